@@ -1,7 +1,10 @@
 /**
    Optimize a fused lasso instance on a general graph by iteratively close the "gaps".
 */
+#include <algorithm>
 #include <cstdio>
+#include <utility>          // std::move
+#include <vector>
 
 #include <argparser.hpp>
 #include <minih5.hpp>
@@ -9,13 +12,13 @@
 #include <graphidx/bits/weights.hpp>
 #include <graphidx/idx/incidence.hpp>
 #include <graphidx/utils/timer.hpp>
-#ifndef HAVE_LEMON
-#  error need lemon graph library
-#else
+#ifdef HAVE_LEMON
 #  include <graphidx/heap/lemon_heap.hpp>
 #endif
 
+#include "../cyclegap.hpp"
 #include "../gaplas.hpp"
+#include "../grid_index.hpp"
 
 
 template <typename int_t = int>
@@ -30,40 +33,132 @@ read_graph(const char *fname, const char *group = "/")
 }
 
 
-template <typename Tag>
+template <typename Tag, typename Mem, typename Graph>
+GapResult
+solve(
+    const Graph &graph,
+    std::vector<double> &x,
+    const std::vector<double> &y,
+    std::vector<double> &alpha,
+    const double lam,
+    const size_t max_iter,
+    const unsigned threads,
+    const size_t max_cycle,
+    const double tol,
+    const double max_time,
+    const double learn,
+    const double mass)
+{
+    const auto n = graph.num_nodes();
+    if (n != y.size())
+        throw std::runtime_error(
+            std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " +
+            std::to_string(n) + " != " + std::to_string(y.size()));
+    x.resize(n);
+    const bool verbose = true;
+    const int root = 0;
+    Mem mem(x.data(), y.data(), n, graph.num_edges(), root);
+    mem.threads = threads;
+    mem.incremental = max_cycle > 0;
+    mem.max_cycle = max_cycle;
+    mem.tol = tol;
+    mem.max_time = max_time;
+    mem.learn = learn;
+    mem.mass = mass;
+    Cancel cancel;                  // [Ctrl-C]: store the current iterate
+    SigintScope sigint;
+    mem.cancel = &cancel;
+    const auto res =
+        gaplas<Tag>(mem, graph, Const<double>(lam), max_iter, verbose, Ones<double>());
+    alpha = std::move(mem.alpha);
+    return res;
+}
+
+
+template <typename Tag, typename Mem = GapMem<double>>
 void
 optimize(
     const char *fname,
     const double lam,
-    const char * /* out_name */,
-    const bool /* overwrite = true */,
+    const char *out_name,
+    const bool overwrite,
     const size_t max_iter,
+    const unsigned threads,
+    const size_t max_cycle,
+    const double tol,
+    const double max_time,
+    const double learn,
+    const double mass,
+    const bool grid,
     const char *group = "/")
 {
-    std::vector<double> y, x;
+    std::vector<double> y, x, alpha;
+    HDF5::Dims dims;
     {
         HDF5 io(fname, "r");
         io.group(group);
-        y = io.read<decltype(y)::value_type>("y");
+        y = io.read<decltype(y)::value_type>("y", &dims);
+    }
+    GapResult res;
+    if (grid) {
+        if (dims.size() != 2)
+            throw std::runtime_error(
+                std::string("--grid: y needs two dimensions, got ") +
+                std::to_string(dims.size()));
+        const GridIndex<int> index {size_t(dims[1]), size_t(dims[0])};
+        res = solve<Tag, Mem>(
+            index,
+            x,
+            y,
+            alpha,
+            lam,
+            max_iter,
+            threads,
+            max_cycle,
+            tol,
+            max_time,
+            learn,
+            mass);
+    } else {
+        const auto index = read_graph(fname, group);
+        res = solve<Tag, Mem>(
+            index,
+            x,
+            y,
+            alpha,
+            lam,
+            max_iter,
+            threads,
+            max_cycle,
+            tol,
+            max_time,
+            learn,
+            mass);
+    }
+    fprintf(stderr,
+            "%s after %d iterations (%.3fs)\n",
+            res.converged ? "converged" : res.cancelled ? "interrupted" : "stopped",
+            int(res.iterations()),
+            res.time.back());
+
+    Timer _("store x, alpha");
+    HDF5 io(fname, "r+");
+    io.group(group);
+    const auto alpha_name = out_name[0] == 'x' ? std::string("alpha") + (out_name + 1)
+                                               : std::string(out_name) + "_alpha";
+    if (overwrite) {
+        io.owrite(out_name, x);
+        io.owrite(alpha_name.c_str(), alpha);
+    } else {
+        io.write(out_name, x);
+        io.write(alpha_name.c_str(), alpha);
     }
-    const auto index = read_graph(fname, group);
-    Const<double> clam(lam);
-    const auto n = index.size();
-    if (n != y.size())
-        throw std::runtime_error(
-            std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " +
-            std::to_string(n) + " != " + std::to_string(y.size()));
-    x.resize(n);
-    const bool verbose = true;
-    gaplas<Tag>(x.data(), y.data(), index, clam, max_iter, verbose);
 }
 
 
 int
 main(int argc, char *argv[])
 {
-    using Queue = lemo::QuadHeapT;
-
     try {
         ArgParser ap(
             "gaplas [file] [out_id]\n"
@@ -73,6 +168,19 @@ main(int argc, char *argv[])
         ap.add_option('i', "iter", "Number of iterations", "INT", "10");
         ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
         ap.add_option('f', "force", "Force to overwrite solution");
+        ap.add_option('e', "tol", "Stop if relative duality gap is below", "num", "1e-6");
+        ap.add_option('T', "time", "Time budget in seconds", "num", "inf");
+        ap.add_option('m', "learn", "Momentum: weight of new iterate [1: off]", "num", "1");
+        ap.add_option('M', "mass", "Momentum: weight of last vs. second last", "num", "0.95");
+        ap.add_option('C', "cycles",
+                      "Rotate capacities along cycles (CycleGap; not with -m, -c)");
+        ap.add_option('G', "grid", "Grid graph given by the dimensions of y (no edges)");
+        ap.add_option('t', "threads", "Number of threads [0: all cores]", "INT", "0");
+        ap.add_option(
+            'c', "incremental", "Update tree locally along cycles up to length", "INT", "0");
+#ifdef HAVE_LEMON
+        ap.add_option('p', "prim", "Prim's algorithm (instead of parallel Boruvka)");
+#endif
         ap.parse(&argc, argv);
         if (argc <= 1) {
             fprintf(stderr, "No file!\n");
@@ -82,7 +190,70 @@ main(int argc, char *argv[])
         const char *x_opt = argc > 2 ? argv[2] : "x_gap";
         const double lam = std::atof(ap.get_option("lam"));
         const int max_iter = std::atoi(ap.get_option("iter"));
-        optimize<Queue>(fname, lam, x_opt, ap.has_option("force"), max_iter);
+        const int threads = std::atoi(ap.get_option("threads"));
+        const auto nthreads = threads > 0 ? unsigned(threads) : default_threads();
+        const char *group = ap.get_option("group");
+        const auto cycle = size_t(std::max(0, std::atoi(ap.get_option("incremental"))));
+        const bool force = ap.has_option("force");
+        const double tol = std::atof(ap.get_option("tol"));
+        const double max_time = std::atof(ap.get_option("time"));
+        const double learn = std::atof(ap.get_option("learn"));
+        const double mass = std::atof(ap.get_option("mass"));
+        const bool grid = ap.has_option("grid");
+        if (ap.has_option("cycles")) {
+            if (learn != 1.0 || cycle > 0) {
+                fprintf(stderr, "--cycles does not support --learn or --incremental\n");
+                return 1;
+            }
+            optimize<Boruvka, CycleGap<double>>(
+                fname,
+                lam,
+                x_opt,
+                force,
+                max_iter,
+                nthreads,
+                cycle,
+                tol,
+                max_time,
+                learn,
+                mass,
+                grid,
+                group);
+            return 0;
+        }
+#ifdef HAVE_LEMON
+        if (ap.has_option("prim")) {
+            using Queue = lemo::QuadHeapT;
+            optimize<Queue>(
+                fname,
+                lam,
+                x_opt,
+                force,
+                max_iter,
+                nthreads,
+                cycle,
+                tol,
+                max_time,
+                learn,
+                mass,
+                grid,
+                group);
+        } else
+#endif
+            optimize<Boruvka>(
+                fname,
+                lam,
+                x_opt,
+                force,
+                max_iter,
+                nthreads,
+                cycle,
+                tol,
+                max_time,
+                learn,
+                mass,
+                grid,
+                group);
     } catch (std::runtime_error &e) {
         fprintf(stderr, "EXCEPTION: %s\n", e.what());
     } catch (const char *msg) {
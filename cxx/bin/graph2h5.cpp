@@ -1,13 +1,70 @@
+#include <chrono>
+#include <cstdio>
 #include <string>      // stoi
 #include <iostream>
+#include <vector>
 #include <argparser.hpp>
 #include <minih5.hpp>
-#include <graphidx/io/dimacs10.hpp>
-#include <graphidx/io/snap.hpp>
 #include <graphidx/io/autoistream.hpp>
 #include <graphidx/utils/timer.hpp>
 #include <graphidx/utils/thousand.hpp>
 
+#ifdef HAVE_BZIP2
+#  include "../bz2_blocks.hpp"
+#endif
+#include "../edge_parse.hpp"
+#include "../mmap_file.hpp"
+
+
+/** Does the file start with the bzip2 magic? */
+static bool
+is_bz2(const char *fname)
+{
+    char magic[3] = {0, 0, 0};
+    FILE *f = fopen(fname, "rb");
+    if (f) {
+        if (fread(magic, 1, sizeof(magic), f) != sizeof(magic))
+            magic[0] = 0;
+        fclose(f);
+    }
+    return magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h';
+}
+
+
+/** Plain files are memory-mapped, bzip2 compressed ones are decompressed
+    block-parallel (or as a stream of `buf_size` chunks if `threads == 1`
+    or without `HAVE_BZIP2`). */
+static void
+parse_edges(const char *fname,
+            EdgeParser &parser,
+            const size_t buf_size,
+            const unsigned threads)
+{
+#ifdef HAVE_BZIP2
+    if (is_bz2(fname) && threads > 1) {
+        Bz2Blocks bz (fname, threads);
+        bz.decompress([&](const char *data, size_t len) { parser.feed(data, data + len); });
+        parser.finish();
+        return;
+    }
+#else
+    (void) threads;
+#endif
+    if (is_bz2(fname)) {
+        AutoIStream io (fname, int(buf_size));
+        std::vector<char> chunk (std::max<size_t>(buf_size, size_t(1) << 24));
+        while (io) {
+            io.read(chunk.data(), std::streamsize(chunk.size()));
+            parser.feed(chunk.data(), chunk.data() + io.gcount());
+        }
+    } else {
+        const MappedFile file (fname);
+        file.willneed(0, file.size());
+        parser.feed(file.data(), file.data() + file.size());
+    }
+    parser.finish();
+}
+
 
 int
 main(int argc, char *argv[])
@@ -15,10 +72,12 @@ main(int argc, char *argv[])
     ArgParser ap (
         "graph2h5 <graph> [outfile]\n"
         "\n"
-        "Decompress `graph` (in DIMACS10 format) and store edges as HDF5"
+        "Parse `graph` (DIMACS10 or SNAP format; plain or bzip2) and store edges\n"
+        "as HDF5"
     );
     ap.add_option('b', "buf-size",  "Buffer size [8192]", "INT", "8192");
     ap.add_option('s', "snap",  "Use SNAP format");
+    ap.add_option('t', "threads",  "Number of parsing threads [all]", "INT", "0");
     ap.parse(&argc, argv);
 
     if (argc <= 1) {
@@ -30,22 +89,29 @@ main(int argc, char *argv[])
     const char *infn = argv[1];
     const char *outfn =  (argc > 2) ? argv[2] : "out.h5";
     const int buf_size = atoi(ap.get_option("buf-size"));
+    const int threads = atoi(ap.get_option("threads"));
 
     set_thousand_sep(std::cout);
 
     std::cout << infn << " -> " << outfn << std::endl;
     try {
-	std::vector<int> head, tail;
-	if (!ap.has_option("snap")) {
-	    Timer _ ("parse dimacs10");
-	    AutoIStream io (infn, buf_size);
-	    parse_dimacs10_edges(io, head, tail);
-	} else {
-	    Timer _ ("parse snap");
-	    AutoIStream io (infn, buf_size);
-	    parse_snap_edges(io, head, tail);
+	const bool snap = ap.has_option("snap");
+	const unsigned nthreads = threads > 0 ? unsigned(threads) : default_threads();
+	EdgeParser parser (snap ? EdgeFormat::SNAP : EdgeFormat::DIMACS10, nthreads);
+	const auto start = std::chrono::steady_clock::now();
+	{
+	    Timer _ (snap ? "parse snap" : "parse dimacs10");
+	    parse_edges(infn, parser, size_t(std::max(buf_size, 1)), nthreads);
 	}
+	const std::chrono::duration<double> secs =
+	    std::chrono::steady_clock::now() - start;
+	const auto &head = parser.head, &tail = parser.tail;
 	std::cout << " m = " << head.size() << std::endl;
+	fprintf(stdout, " %.1f MB in %.3f s: %.1f MB/s\n",
+	        double(parser.bytes()) * 1e-6,
+	        secs.count(),
+	        double(parser.bytes()) * 1e-6 / std::max(secs.count(), 1e-9));
+	fflush(stdout);
 	{   Timer _ ("write hdf5");
 	    HDF5 io (outfn, "w");
 	    io.owrite("head", head);
@@ -0,0 +1,199 @@
+/**
+   Denoise a 2-D image or 3-D volume `y` (stored in a HDF5 file) by
+   anisotropic total variation.
+*/
+#include <algorithm>
+#include <cmath>            // std::isnan
+#include <cstdio>
+#include <memory>           // std::unique_ptr
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <argparser.hpp>
+#include <minih5.hpp>
+
+#include <graphidx/utils/timer.hpp>
+
+#include "../grid_tv.hpp"
+#include "../tiled_tv.hpp"
+
+
+/** Solve tile by tile; read y and write x by hyperslabs */
+void
+process_tiled(
+    const char *fname,
+    const char *out_name,
+    const bool overwrite,
+    const double lam,
+    const size_t max_iter,
+    const double tol,
+    const unsigned threads,
+    const char *group,
+    const size_t tile,
+    const size_t overlap,
+    const double rho)
+{
+    HDF5::Dims dims;
+    std::unique_ptr<TiledTV<double>> tiled;
+    {
+        Timer _("load tiles");
+        HDF5 io(fname, "r");
+        io.group(group);
+        dims = io.dimensions("y");
+        tiled.reset(new TiledTV<double>(
+            std::vector<size_t>(dims.begin(), dims.end()), tile, overlap));
+        tiled->rho = rho;
+        tiled->load([&](size_t t, double *yt) {
+            const auto &T = tiled->tiles[t];
+            HDF5::Dims offset(T.lo.begin(), T.lo.end()), count;
+            for (size_t d = 0; d < dims.size(); d++)
+                count.push_back(T.hi[d] - T.lo[d]);
+            const auto y = io.read_slab<double>("y", offset, count);
+            std::copy(y.begin(), y.end(), yt);
+        });
+    }
+    fprintf(stderr, "%d tiles, overlap %d\n", int(tiled->tiles.size()), int(overlap));
+
+    ThreadPool pool(threads);
+    const auto res = tiled->solve(lam, max_iter, tol, pool, true);
+    fprintf(stderr,
+            "%s after %d iterations (%.3fs)\n",
+            res.converged ? "converged" : "stopped",
+            int(res.iterations()),
+            res.time.back());
+
+    Timer _("store x");
+    HDF5 io(fname, "r+");
+    io.group(group);
+    io.create<double>(out_name, dims, overwrite);
+    for (size_t t = 0; t < tiled->tiles.size(); t++) {
+        const auto &T = tiled->tiles[t];
+        HDF5::Dims offset(T.core_lo.begin(), T.core_lo.end()), count;
+        for (size_t d = 0; d < dims.size(); d++)
+            count.push_back(T.core_hi[d] - T.core_lo[d]);
+        io.write_slab(out_name, tiled->core(t), offset, count);
+    }
+}
+
+
+void
+process_file(
+    const char *fname,
+    const char *out_name,
+    const bool overwrite,
+    double lam,
+    const size_t max_iter,
+    const double tol,
+    const unsigned threads,
+    const char *group,
+    const size_t tile,
+    const size_t overlap,
+    const double rho)
+{
+    if (std::isnan(lam)) {
+        HDF5 io(fname, "r");
+        io.group(group);
+        if (io.has("lam"))
+            lam = io.read<double>("lam").at(0);
+    }
+    if (std::isnan(lam))
+        throw std::runtime_error("Need λ (either --lam or dataset \"lam\")");
+    if (tile > 0) {
+        process_tiled(
+            fname,
+            out_name,
+            overwrite,
+            lam,
+            max_iter,
+            tol,
+            threads,
+            group,
+            tile,
+            overlap,
+            rho);
+        return;
+    }
+
+    HDF5::Dims dims;
+    std::vector<double> y;
+    {
+        Timer _("load hdf5");
+        HDF5 io(fname, "r");
+        io.group(group);
+        y = io.read<double>("y", &dims);
+    }
+    std::vector<size_t> sdims(dims.begin(), dims.end());
+    fprintf(stderr, "dims = ");
+    for (size_t d = 0; d < sdims.size(); d++)
+        fprintf(stderr, d == 0 ? "%d" : "x%d", int(sdims[d]));
+    fprintf(stderr, ", lam = %g, threads = %d\n", lam, int(threads));
+
+    std::vector<double> x(y.size());
+    ThreadPool pool(threads);
+    GridTV<double> tv(sdims);
+    const auto res = tv.solve(x.data(), y.data(), lam, max_iter, tol, pool, true);
+    fprintf(stderr,
+            "%s after %d iterations (%.3fs)\n",
+            res.converged ? "converged" : "stopped",
+            int(res.iterations()),
+            res.time.back());
+
+    Timer _("store x");
+    HDF5 io(fname, "r+");
+    io.group(group);
+    if (overwrite)
+        io.owrite(out_name, x, &dims);
+    else
+        io.write(out_name, x, &dims);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    ArgParser ap(
+        "grid_tv [file] [out_id]\n"
+        "\n"
+        "Anisotropic total variation denoising of the (2-D or 3-D) array \"y\"");
+    try {
+        ap.add_option('l', "lam", "Tuning parameter λ [default: \"lam\" in file]", "num", "nan");
+        ap.add_option('i', "iter", "Maximal number of iterations", "INT", "100");
+        ap.add_option('e', "tol", "Stop if no x[i] changes more than", "num", "1e-6");
+        ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.add_option('f', "force", "Force to overwrite solution");
+        ap.add_option('t', "threads", "Number of threads [0: all cores]", "INT", "0");
+        ap.add_option('T', "tile", "Solve by tiles of this size [0: off]", "INT", "0");
+        ap.add_option('O', "overlap", "Tiles: overlap (at least 1)", "INT", "4");
+        ap.add_option('r', "rho", "Tiles: ADMM penalty ρ", "num", "1");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        const int threads = std::atoi(ap.get_option("threads"));
+        process_file(argv[1],
+                     argc > 2 ? argv[2] : "x_tv",
+                     ap.has_option("force"),
+                     std::atof(ap.get_option("lam")),
+                     size_t(std::max(0, std::atoi(ap.get_option("iter")))),
+                     std::atof(ap.get_option("tol")),
+                     threads > 0 ? unsigned(threads) : default_threads(),
+                     ap.get_option("group"),
+                     size_t(std::max(0, std::atoi(ap.get_option("tile")))),
+                     size_t(std::max(0, std::atoi(ap.get_option("overlap")))),
+                     std::atof(ap.get_option("rho")));
+    } catch (ArgParser::ArgParserException &e) {
+        fprintf(stderr, "%s\n", e.what());
+        ap.print_usage();
+        return 1;
+    } catch (std::exception &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+   Convert a tree instance from HDF5 to the memory-mappable binary
+   container of `tree_bin.hpp`.
+ */
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <argparser.hpp>
+#include <minih5.hpp>
+
+#include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../tree_bin.hpp"
+
+
+void
+convert(const char *h5_name, const char *bin_name, const char *group)
+{
+    std::vector<double> y, lam, mu;
+    std::vector<int> parent, dfs, bfs, postorder, queue_start;
+    {
+        Timer _("Loading HDF5");
+        HDF5 io(h5_name, "r");
+        io.group(group);
+        y = io.read<double>("y");
+        lam = io.read<double>("lam");
+        parent = io.read<int>("parent");
+        if (io.has("mu"))
+            mu = io.read<double>("mu");
+        if (io.has("dfs"))
+            dfs = io.read<int>("dfs");
+        if (io.has("bfs"))
+            bfs = io.read<int>("bfs");
+        if (io.has("postorder"))
+            postorder = io.read<int>("postorder");
+        if (io.has("queue_start"))
+            queue_start = io.read<int>("queue_start");
+    }
+    if (parent.size() != y.size())
+        throw std::runtime_error("len(parent) != len(y)");
+    if (lam.empty())
+        throw std::runtime_error("Empty lam");
+
+    int root = -1;
+    {
+        Timer _("find root");
+        if (!dfs.empty())
+            root = dfs[0];
+        else if (!postorder.empty())
+            root = postorder.back();
+        else
+            root = find_root(parent);
+    }
+
+    Timer _("Writing binary");
+    TreeBinWriter w(y.size(), root);
+    w.add("y", y).add("lam", lam).add("parent", parent);
+    if (!mu.empty())
+        w.add("mu", mu);
+    if (!dfs.empty())
+        w.add("dfs", dfs);
+    if (!bfs.empty())
+        w.add("bfs", bfs);
+    if (!postorder.empty())
+        w.add("postorder", postorder);
+    if (!queue_start.empty())
+        w.add("queue_start", queue_start);
+    w.write(bin_name);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    ArgParser ap(
+        "h5tobin [file.h5] [file.bin]\n"
+        "\n"
+        "Convert a tree instance (y, lam, parent, ...) to the binary format\n"
+        "that tree_opt can memory-map.");
+    try {
+        ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        std::string out = argc > 2 ? argv[2] : "";
+        if (out.empty()) {          // file.h5 -> file.bin
+            out = argv[1];
+            const auto ext = out.rfind(".h5");
+            if (ext != std::string::npos)
+                out.resize(ext);
+            out += ".bin";
+        }
+        convert(argv[1], out.c_str(), ap.get_option("group"));
+        printf("%s\n", out.c_str());
+    } catch (ArgParser::ArgParserException &e) {
+        fprintf(stderr, "%s\n", e.what());
+        ap.print_usage();
+        return 1;
+    } catch (std::exception &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+    return 0;
+}
@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include <graphidx/min_cut.hpp>
 #include <graphidx/utils/timer.hpp>
 
+#include "../line_dp.hpp"
 #include "../tree_dp.hpp"
 #include "../tree_dual.hpp"
 
-
 #ifdef _WIN32
 #  define __export __declspec(dllexport)
 #elif defined(__GNUC__)
@@ -13,6 +21,9 @@
 #  define __export
 #endif
 
+#define TREELAS_API __export
+#include "../treelas.h"
+
 
 void
 inline _timer_disable()
@@ -59,6 +70,365 @@ tree_dual_f64_i32(
 }
 
 
+/** Workspace of the C interface (see treelas.h) */
+struct treelas_solver
+{
+    explicit treelas_solver(const size_t n)
+        : n(n), status(n, true), parent(n), postorder(n), queue_start(n),
+          xbuf(n), ybuf(n), ub(n)
+    {
+        event.reserve(2*n);
+    }
+
+    const size_t n;
+    TreeDPStatus status;
+    std::vector<int> parent, postorder, queue_start;
+    int root = -1;
+    std::vector<double> xbuf, ybuf;     // float conversion, aliasing
+    uvector<Event> event;               // line workspace
+    uvector<double> ub;
+    std::string error;
+};
+
+
+/** Weights given as `float`: read as `double` */
+template <typename T>
+struct Cast
+{
+    const T *a;
+    static constexpr bool is_const() { return false; }
+    double operator[](size_t i) const { return double(a[i]); }
+};
+
+
+/** Call `f(lam, mu)` with the weights wrapped in the matching views */
+template <typename T, typename F>
+inline void
+with_weights(const T *lam, const T lam_c, const T *mu, const T mu_c, F f)
+{
+    if (lam && mu)
+        f(Cast<T>{lam}, Cast<T>{mu});
+    else if (lam)
+        f(Cast<T>{lam}, Const<double>(mu_c));
+    else if (mu)
+        f(Const<double>(lam_c), Cast<T>{mu});
+    else
+        f(Const<double>(lam_c), Const<double>(mu_c));
+}
+
+
+/** Run `f` catching all exceptions; their message goes to `s->error` */
+template <typename F>
+inline int
+guarded(treelas_solver *s, F f)
+{
+    if (s == nullptr)
+        return -1;
+    try {
+        f();
+        s->error.clear();
+        return 0;
+    } catch (const std::exception &e) {
+        s->error = e.what();
+    } catch (...) {
+        s->error = "unknown error";
+    }
+    return 1;
+}
+
+
+template <typename int_t>
+inline void
+set_tree(treelas_solver *s, const int_t *parent, int_t root)
+{
+    const size_t n = s->n;
+    s->root = -1;
+    for (size_t i = 0; i < n; i++) {
+        if (parent[i] < 0 || size_t(parent[i]) >= n)
+            throw std::invalid_argument(
+                "parent[" + std::to_string(i) + "] = " + std::to_string(parent[i]) +
+                " out of range");
+        s->parent[i] = int(parent[i]);
+    }
+    if (root < 0)
+        root = int_t(find_root(n, s->parent.data()));
+    if (size_t(root) >= n || s->parent[root] != root)
+        throw std::invalid_argument("root " + std::to_string(root) + " is not a root");
+
+    auto &st = s->status;
+    st.childs.reset(n, s->parent.data(), int(root));
+    init_queues(n, st.pq, st.proc_order, st.childs, st.dfs_stack, int(root));
+    if (st.proc_order.size() + 1 != n)
+        throw std::invalid_argument("parent does not describe a tree");
+    std::copy(st.proc_order.begin(), st.proc_order.end(), s->postorder.begin());
+    s->postorder[n-1] = int(root);
+    for (size_t i = 0; i < n; i++)
+        s->queue_start[i] = st.pq[i].start;
+    s->root = int(root);
+}
+
+
+/**
+   `x` may point to `y`; for `float`, solve via the double buffers.
+   If `dual` is given, its `alpha` must be a double array (or NULL).
+ */
+template <typename T, typename Wlam, typename Wmu>
+inline void
+solve_tree(treelas_solver *s, T *x, const T *y, const Wlam &lam, const Wmu &mu,
+           TreeDPDual *dual = nullptr)
+{
+    if (s->root < 0)
+        throw std::runtime_error("no tree registered (treelas_set_tree_*)");
+    constexpr bool
+        merge_sort = false,
+        lazy_sort = true;
+    const size_t n = s->n;
+    if constexpr (std::is_same<T, double>::value) {
+        if (!dual || x != y) {
+            tree_dp<merge_sort, lazy_sort>(n, x, y, s->parent.data(), lam, mu,
+                                           s->root, s->status, s->postorder.data(),
+                                           s->queue_start.data(), nullptr, dual);
+            return;
+        }
+    }
+    std::copy(y, y + n, s->ybuf.begin());   // the dual reads y after x is written
+    tree_dp<merge_sort, lazy_sort>(n, s->xbuf.data(), s->ybuf.data(),
+                                   s->parent.data(), lam, mu, s->root, s->status,
+                                   s->postorder.data(), s->queue_start.data(),
+                                   nullptr, dual);
+    std::transform(s->xbuf.begin(), s->xbuf.end(), x,
+                   [](double v) { return T(v); });
+}
+
+
+template <typename T, typename Wlam, typename Wmu>
+inline void
+solve_line(treelas_solver *s, T *x, const T *y, const Wlam &lam, const Wmu &mu)
+{
+    const size_t n = s->n;
+    if (n == 0)
+        return;
+    if (mu[n-1] <= 0)
+        throw std::invalid_argument("End node must not be latent");
+    if constexpr (std::is_same<T, double>::value) {
+        if (x != y) {
+            line_las(n, x, y, lam, mu, s->event.data(), s->ub.data());
+            return;
+        }
+    }
+    std::copy(y, y + n, s->ybuf.begin());   // line_las writes x[i] before y[i] is read
+    line_las(n, s->xbuf.data(), s->ybuf.data(), lam, mu, s->event.data(), s->ub.data());
+    std::transform(s->xbuf.begin(), s->xbuf.end(), x, [](double v) { return T(v); });
+}
+
+
+extern "C" __export treelas_solver*
+treelas_create(const size_t n)
+{
+    try {
+        return new treelas_solver(n);
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+
+extern "C" __export void
+treelas_destroy(treelas_solver *s)
+{
+    delete s;
+}
+
+
+extern "C" __export size_t
+treelas_size(const treelas_solver *s)
+{
+    return s ? s->n : 0;
+}
+
+
+extern "C" __export const char*
+treelas_error(const treelas_solver *s)
+{
+    return s ? s->error.c_str() : "no solver";
+}
+
+
+extern "C" __export int
+treelas_set_tree_i32(treelas_solver *s, const int32_t *parent, const int32_t root)
+{
+    return guarded(s, [&]() { set_tree(s, parent, root); });
+}
+
+
+extern "C" __export int
+treelas_set_tree_i64(treelas_solver *s, const int64_t *parent, const int64_t root)
+{
+    return guarded(s, [&]() {
+        if (s->n > size_t(INT_MAX))
+            throw std::invalid_argument("tree too large for 32 bit indices");
+        set_tree(s, parent, root);
+    });
+}
+
+
+template <typename T>
+inline int
+tree(treelas_solver *s, T *x, const T *y, const T *lam, const T lam_c, const T *mu,
+     const T mu_c)
+{
+    return guarded(s, [&]() {
+        with_weights(lam, lam_c, mu, mu_c, [&](const auto &l, const auto &m) {
+            solve_tree(s, x, y, l, m);
+        });
+    });
+}
+
+
+template <typename T>
+inline int
+tree_with_dual(treelas_solver *s, T *x, const T *y, const T *lam, const T lam_c,
+               const T *mu, const T mu_c, T *alpha, treelas_objective *obj)
+{
+    return guarded(s, [&]() {
+        TreeDPDual dual;
+        if constexpr (std::is_same<T, double>::value)
+            dual.alpha = alpha;
+        else
+            dual.alpha = alpha ? s->ub.data() : nullptr;
+        with_weights(lam, lam_c, mu, mu_c, [&](const auto &l, const auto &m) {
+            solve_tree(s, x, y, l, m, &dual);
+        });
+        if constexpr (!std::is_same<T, double>::value) {
+            if (alpha)
+                std::transform(dual.alpha, dual.alpha + s->n, alpha,
+                               [](double v) { return T(v); });
+        }
+        if (obj)
+            *obj = {dual.primal, dual.dual, dual.gap};
+    });
+}
+
+
+template <typename T>
+inline int
+tree_batch(treelas_solver *s, const size_t k, T *x, const T *y, const T *lam)
+{
+    return guarded(s, [&]() {
+        for (size_t j = 0; j < k; j++)
+            solve_tree(s, x + j*s->n, y + j*s->n, Const<double>(lam[j]),
+                       Ones<double>());
+    });
+}
+
+
+template <typename T>
+inline int
+line(treelas_solver *s, T *x, const T *y, const T *lam, const T lam_c, const T *mu,
+     const T mu_c)
+{
+    return guarded(s, [&]() {
+        with_weights(lam, lam_c, mu, mu_c, [&](const auto &l, const auto &m) {
+            solve_line(s, x, y, l, m);
+        });
+    });
+}
+
+
+template <typename T>
+inline int
+line_batch(treelas_solver *s, const size_t k, T *x, const T *y, const T *lam)
+{
+    return guarded(s, [&]() {
+        for (size_t j = 0; j < k; j++)
+            solve_line(s, x + j*s->n, y + j*s->n, Const<double>(lam[j]),
+                       Ones<double>());
+    });
+}
+
+
+extern "C" __export int
+treelas_tree_f64(treelas_solver *s, double *x, const double *y, const double *lam,
+                 const double lam_c, const double *mu, const double mu_c)
+{
+    return tree(s, x, y, lam, lam_c, mu, mu_c);
+}
+
+
+extern "C" __export int
+treelas_tree_f32(treelas_solver *s, float *x, const float *y, const float *lam,
+                 const float lam_c, const float *mu, const float mu_c)
+{
+    return tree(s, x, y, lam, lam_c, mu, mu_c);
+}
+
+
+extern "C" __export int
+treelas_tree_dual_f64(treelas_solver *s, double *x, const double *y, const double *lam,
+                      const double lam_c, const double *mu, const double mu_c,
+                      double *alpha, treelas_objective *obj)
+{
+    return tree_with_dual(s, x, y, lam, lam_c, mu, mu_c, alpha, obj);
+}
+
+
+extern "C" __export int
+treelas_tree_dual_f32(treelas_solver *s, float *x, const float *y, const float *lam,
+                      const float lam_c, const float *mu, const float mu_c,
+                      float *alpha, treelas_objective *obj)
+{
+    return tree_with_dual(s, x, y, lam, lam_c, mu, mu_c, alpha, obj);
+}
+
+
+extern "C" __export int
+treelas_tree_batch_f64(treelas_solver *s, const size_t k, double *x, const double *y,
+                       const double *lam)
+{
+    return tree_batch(s, k, x, y, lam);
+}
+
+
+extern "C" __export int
+treelas_tree_batch_f32(treelas_solver *s, const size_t k, float *x, const float *y,
+                       const float *lam)
+{
+    return tree_batch(s, k, x, y, lam);
+}
+
+
+extern "C" __export int
+treelas_line_f64(treelas_solver *s, double *x, const double *y, const double *lam,
+                 const double lam_c, const double *mu, const double mu_c)
+{
+    return line(s, x, y, lam, lam_c, mu, mu_c);
+}
+
+
+extern "C" __export int
+treelas_line_f32(treelas_solver *s, float *x, const float *y, const float *lam,
+                 const float lam_c, const float *mu, const float mu_c)
+{
+    return line(s, x, y, lam, lam_c, mu, mu_c);
+}
+
+
+extern "C" __export int
+treelas_line_batch_f64(treelas_solver *s, const size_t k, double *x, const double *y,
+                       const double *lam)
+{
+    return line_batch(s, k, x, y, lam);
+}
+
+
+extern "C" __export int
+treelas_line_batch_f32(treelas_solver *s, const size_t k, float *x, const float *y,
+                       const float *lam)
+{
+    return line_batch(s, k, x, y, lam);
+}
+
+
 #ifdef HAVE_LEMON
 extern "C" __export double
 min_cut_f64_i32(
@@ -0,0 +1,94 @@
+/**
+   Fused lasso on a line graph for signals `y` (one-dimensional dataset in
+   a HDF5 file) that are too large for the memory: see line_stream.hpp.
+*/
+#include <algorithm>
+#include <cmath>            // std::isnan
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include <argparser.hpp>
+#include <minih5.hpp>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../line_stream.hpp"
+
+
+void
+process_file(
+    const char *fname,
+    const char *out_name,
+    const bool overwrite,
+    double lam,
+    const char *group,
+    const size_t block,
+    const char *scratch_dir)
+{
+    HDF5 io(fname, "r+");
+    io.group(group);
+    if (std::isnan(lam) && io.has("lam"))
+        lam = io.read<double>("lam").at(0);
+    if (std::isnan(lam))
+        throw std::runtime_error("Need λ (either --lam or dataset \"lam\")");
+
+    auto y = io.stream<double>("y");
+    const size_t n = y.size();
+    io.create<double>(out_name, {n}, overwrite);
+    auto x = io.stream<double>(out_name);
+    fprintf(stderr, "n = %ld, lam = %g, block = %ld\n", long(n), lam, long(block));
+
+    Timer _("line_las_stream:\n");
+    line_las_stream(
+        n,
+        [&](size_t offset, size_t count, double *buf) { y.read(offset, count, buf); },
+        [&](size_t offset, size_t count, const double *buf) {
+            x.write(offset, count, buf);
+        },
+        Const<double>(lam),
+        block,
+        scratch_dir);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    ArgParser ap(
+        "line_stream [file] [out_id]\n"
+        "\n"
+        "Fused lasso on the line \"y\" without loading it into memory");
+    try {
+        ap.add_option('l', "lam", "Tuning parameter λ [default: \"lam\" in file]", "num", "nan");
+        ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.add_option('f', "force", "Force to overwrite solution");
+        ap.add_option('b', "block", "Elements per read/write", "INT", "1048576");
+        ap.add_option('s', "scratch", "Directory of the scratch file [$TMPDIR]", "DIR", "");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        const std::string scratch = ap.get_option("scratch");
+        process_file(argv[1],
+                     argc > 2 ? argv[2] : "x",
+                     ap.has_option("force"),
+                     std::atof(ap.get_option("lam")),
+                     ap.get_option("group"),
+                     size_t(std::max(1, std::atoi(ap.get_option("block")))),
+                     scratch.empty() ? nullptr : scratch.c_str());
+    } catch (ArgParser::ArgParserException &e) {
+        fprintf(stderr, "%s\n", e.what());
+        ap.print_usage();
+        return 1;
+    } catch (std::exception &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+   Optimize a fused lasso instance on a general graph by splitting the edges
+   into several forests which are solved in parallel.
+*/
+#include <algorithm>
+#include <cstdio>
+
+#include <argparser.hpp>
+#include <minih5.hpp>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../multitree.hpp"
+
+
+void
+optimize(
+    const char *fname,
+    const double lam,
+    const char *out_name,
+    const bool overwrite,
+    const size_t max_iter,
+    const double tol,
+    const unsigned threads,
+    const size_t max_degree,
+    const size_t max_size,
+    const char *group = "/")
+{
+    std::vector<double> y, x;
+    std::vector<int> head, tail;
+    {
+        Timer _("load hdf5");
+        HDF5 io(fname, "r");
+        io.group(group);
+        io.readv(y, "y");
+        io.readv(head, "head");
+        io.readv(tail, "tail");
+    }
+    const IncidenceIndex<int> index(head, tail);
+    const auto n = index.size();
+    if (n != y.size())
+        throw std::runtime_error(
+            std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " +
+            std::to_string(n) + " != " + std::to_string(y.size()));
+    MultiTree<int> mt;
+    {
+        Timer _("decompose");
+        mt.reset(index, max_degree, max_size);
+    }
+    fprintf(stderr,
+            "%d forests, %d parts (largest path %d, largest tree %d)\n",
+            int(mt.num_forests),
+            int(mt.parts.size()),
+            int(mt.max_line),
+            int(mt.max_tree));
+    x.resize(n);
+    const auto res = mt.solve(x.data(), y.data(), Const<double>(lam), max_iter, tol,
+                              threads, /* verbose = */ true);
+    fprintf(stderr,
+            "%s after %d iterations (%.3fs)\n",
+            res.converged ? "converged" : "stopped",
+            int(res.iterations()),
+            res.time.back());
+
+    Timer _("store x");
+    HDF5 io(fname, "r+");
+    io.group(group);
+    if (overwrite)
+        io.owrite(out_name, x);
+    else
+        io.write(out_name, x);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    try {
+        ArgParser ap(
+            "multitree [file] [out_id]\n"
+            "\n"
+            "Fused lasso by splitting the graph into forests, solved in parallel");
+        ap.add_option('l', "lam", "Tuning parameter λ", "num", "nan");
+        ap.add_option('i', "iter", "Maximal number of iterations", "INT", "100");
+        ap.add_option('e', "tol", "Stop if no x[i] changes more than", "num", "1e-6");
+        ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.add_option('f', "force", "Force to overwrite solution");
+        ap.add_option('t', "threads", "Number of threads [0: all cores]", "INT", "0");
+        ap.add_option('d', "degree", "Max. degree within a forest [0: any]", "INT", "2");
+        ap.add_option('s', "size", "Max. nodes per component [0: any]", "INT", "0");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        const char *fname = argv[1];
+        const char *x_opt = argc > 2 ? argv[2] : "x_multi";
+        const int threads = std::atoi(ap.get_option("threads"));
+        optimize(fname,
+                 std::atof(ap.get_option("lam")),
+                 x_opt,
+                 ap.has_option("force"),
+                 size_t(std::max(0, std::atoi(ap.get_option("iter")))),
+                 std::atof(ap.get_option("tol")),
+                 threads > 0 ? unsigned(threads) : default_threads(),
+                 size_t(std::max(0, std::atoi(ap.get_option("degree")))),
+                 size_t(std::max(0, std::atoi(ap.get_option("size")))),
+                 ap.get_option("group"));
+    } catch (std::runtime_error &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+
+    return 0;
+}
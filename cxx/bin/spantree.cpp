@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <argparser.hpp>
 #include <minih5.hpp>
 
@@ -15,22 +16,19 @@
 #include <graphidx/spanning/rand_prim_mst.hpp>
 #include <graphidx/utils/thousand.hpp>
 
+#include "../boruvka.hpp"
+#include "../components.hpp"
 
-void
-spantree(
+
+/** Sequential variant (graphidx) */
+std::vector<int>
+spantree_sequential(
     const char *fname,
-    const char *outfn,
-    const char *group = "/",
-    const int seed = 2018)
+    const char *group,
+    const std::vector<int> &head,
+    const std::vector<int> &tail,
+    const int seed)
 {
-    std::vector<int> head, tail;
-    {   Timer _ ("load hdf5");
-        HDF5 io (fname, "r");
-        io.group(group);
-        head = io.read<decltype(head)::value_type>("head");
-        tail = io.read<decltype(tail)::value_type>("tail");
-    }
-
     const size_t m = head.size();
     Timer tim ("compute edgxe index");
     BiAdjacent index (head, tail);
@@ -66,10 +64,88 @@ spantree(
             }
         }
     }
-    std::vector<int> parent;
-    {   Timer _ ("random span");
-        parent = random_spanning_tree(index, seed);
+    Timer _ ("random span");
+    return random_spanning_tree(index, seed);
+}
+
+
+/** Parallel variant: union-find components and Borůvka on random weights */
+std::vector<int>
+spantree_parallel(
+    const char *fname,
+    const char *group,
+    std::vector<int> &head,
+    std::vector<int> &tail,
+    const int seed,
+    const unsigned threads)
+{
+    const size_t m = head.size();
+    int min_node = 0, max_node = -1;
+    {
+        Timer _ ("min nodes\n");
+        std::vector<int> lo (threads, std::numeric_limits<int>::max()), hi (threads, -1);
+        parallel_blocks(m, threads, [&](size_t begin, size_t end, unsigned t) {
+            for (size_t e = begin; e < end; e++) {
+                lo[t] = std::min({lo[t], head[e], tail[e]});
+                hi[t] = std::max({hi[t], head[e], tail[e]});
+            }
+        });
+        min_node = *std::min_element(lo.begin(), lo.end());
+        max_node = *std::max_element(hi.begin(), hi.end());
+        std::cout << "  min(node) = " << min_node << std::endl;
+        std::cout << "  m = " << m << std::endl
+                  << "  n = " << max_node + 1 << std::endl;
     }
+    if (m > 0 && min_node < 0)
+        throw std::runtime_error("Negative node index");
+    size_t n = size_t(max_node + 1);
+    {
+        Timer _ ("largest cc\n");
+        const auto labels = connected_labels(n, m, head.data(), tail.data(), threads);
+        const auto largest_cc = largest_component(labels);
+        std::cout << " n' = " << largest_cc.size() << std::endl;
+        if (largest_cc.size() < n) {
+            {
+                Timer _ ("store cc");
+                HDF5 io (fname, "r+");
+                io.group(group);
+                io.owrite("largest_cc", largest_cc);
+            }
+            {
+                Timer _ ("induced subgraph");
+                induced_edges(n, largest_cc, head, tail, threads);
+                n = largest_cc.size();
+            }
+        }
+    }
+    Timer _ ("random span\n");
+    return boruvka_random_tree(n, head, tail, uint64_t(seed), threads);
+}
+
+
+void
+spantree(
+    const char *fname,
+    const char *outfn,
+    const char *group = "/",
+    const int seed = 2018,
+    const unsigned threads = 0)
+{
+    std::vector<int> head, tail;
+    {   Timer _ ("load hdf5");
+        HDF5 io (fname, "r");
+        io.group(group);
+        head = io.read<decltype(head)::value_type>("head");
+        tail = io.read<decltype(tail)::value_type>("tail");
+    }
+    if (head.size() != tail.size())
+        throw std::runtime_error("len(head) != len(tail)");
+
+    std::vector<int> parent;
+    if (threads > 0)
+        parent = spantree_parallel(fname, group, head, tail, seed, threads);
+    else
+        parent = spantree_sequential(fname, group, head, tail, seed);
     {
         Timer _ ("min parent:\n");
         const auto min_parent =
@@ -106,6 +182,9 @@ main(int argc, char *argv[])
         );
         ap.add_option('s', "srand", "Random seed [default 2018]", "INT", "2018");
         ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.add_option('t', "threads",
+                      "Parallel components and Borůvka tree (0: sequential) [0]",
+                      "INT", "0");
         ap.parse(&argc, argv);
         if (argc <= 1) {
             fprintf(stderr, "No file!\n");
@@ -116,7 +195,8 @@ main(int argc, char *argv[])
         const char *outfn = argc > 2 ? argv[2] : fname;
         set_thousand_sep(std::cout);
         std::cout << fname << " => " << outfn << std::endl;
-        spantree(fname, outfn, ap.get_option("group"), seed);
+        const int threads = atoi(ap.get_option("threads"));
+        spantree(fname, outfn, ap.get_option("group"), seed, unsigned(std::max(threads, 0)));
     } catch (std::runtime_error &e) {
         fprintf(stderr, "EXCEPTION: %s\n", e.what());
     } catch (const char *msg) {
@@ -18,6 +18,7 @@
 #include <graphidx/utils/thousand.hpp>
 
 #include "../tree_apx.hpp"
+#include "../tree_orders_par.hpp"
 
 
 template<typename float_ = float, typename int_ = int>
@@ -30,10 +31,11 @@ process_file(
     const bool dfs_order,
     const bool reorder,
     const double lam_override,
+    const unsigned threads = 1,
     const unsigned PRINT_MAX = 10)
 {
     std::vector<float_> xt, y, x;
-    std::vector<int_> parent;
+    std::vector<int_> parent, postorder;
     double lam;
     {   Timer _ ("load hdf5");
         HDF5 io (fname, "r");
@@ -44,6 +46,8 @@ process_file(
         assert(lams.size() >= 1);
         lam = std::isnan(lam_override) ? float_(lams[0]) : lam_override;
         io.readv(parent, "parent");
+        if (io.has("postorder"))        // see tree_prep
+            io.readv(postorder, "postorder");
         if (io.has("xt")) {
             io.readv(xt, "xt");
         } else if (io.has("x++")) {
@@ -56,6 +60,13 @@ process_file(
                                  std::to_string(y.size()) +
                                  " != " + std::to_string(n));
     x.resize(n);
+    if (postorder.size() != n && !dfs_order && threads > 1) {
+        Timer _ ("parallel bfs");
+        TreeOrdersPar<int_> orders (threads);
+        orders.reset(n, parent.data());
+        postorder.resize(n);
+        orders.reversed_bfs(postorder.data());
+    }
     if (!quiet) {
         std::cout << std::endl;
         std::cout << "lam = " << lam << std::endl;
@@ -71,7 +82,8 @@ process_file(
              max_iter,
              !quiet,
              reorder,
-             dfs_order);
+             dfs_order,
+             postorder.size() == n ? postorder.data() : nullptr);
 
     if (n <= PRINT_MAX) {
         fprintf(stdout, " x: ");
@@ -103,6 +115,8 @@ main(int argc, char *argv[])
         ap.add_option('R', "no-reorder", "Relabel nodes in post-order");
         ap.add_option('q', "quiet",      "Suppress timer output");
         ap.add_option('l', "lam",        "Tuning parameter λ", "num", "nan");
+        ap.add_option('t', "threads",    "Threads for the BFS order [0: all cores]",
+                      "INT", "1");
         ap.parse(&argc, argv);
         if (argc <= 1) {
             fprintf(stderr, "No tree file!\n");
@@ -113,6 +127,8 @@ main(int argc, char *argv[])
         typedef int   int_;
         const char *group = "/";
         const bool reorder = !ap.has_option("no-reorder");
+        const int threads = std::atoi(ap.get_option("threads"));
+        const unsigned nthreads = threads > 0 ? unsigned(threads) : default_threads();
 
         printf("%s\n", fname);
         printf("reorder  = %s\n", reorder ? "true" : "false");
@@ -125,7 +141,8 @@ main(int argc, char *argv[])
                                            ap.has_option("quiet"),
                                            ap.has_option("dfs"),
                                            reorder,
-                                           std::atof(ap.get_option("lam")));
+                                           std::atof(ap.get_option("lam")),
+                                           nthreads);
             } else {
                 printf("float32\n");
                 process_file<float, int_>(fname, group,
@@ -133,7 +150,8 @@ main(int argc, char *argv[])
                                           ap.has_option("quiet"),
                                           ap.has_option("dfs"),
                                           reorder,
-                                          std::atof(ap.get_option("lam")));
+                                          std::atof(ap.get_option("lam")),
+                                          nthreads);
             }
         }
     } catch (ArgParser::ArgParserException &ex) {
@@ -3,8 +3,17 @@
   to the input.
  */
 #include <algorithm>
+#include <chrono>
+#include <cmath>            // std::isnan
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <memory>           // std::unique_ptr
+#include <mutex>
 #include <numeric>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include <minih5.hpp>
@@ -16,7 +25,176 @@
 #include <graphidx/utils/viostream.hpp>      // std::cout << std::vector<..>
 #include <graphidx/utils/thousand.hpp>
 
+#include "../parallel.hpp"
+#include "../tree_bin.hpp"
 #include "../tree_dp.hpp"
+#include "../tree_dual.hpp"
+#include "../tree_dual_par.hpp"
+
+
+/** Tree instance, either loaded from HDF5 or mapped (binary format) */
+struct TreeInstance
+{
+    std::vector<double> y_, xt;
+    std::vector<int> parent_, postorder_, queue_start_;
+    std::unique_ptr<TreeBin> bin;
+    HDF5::Dims ydims;
+    const double *y = nullptr;
+    const int *parent = nullptr, *postorder = nullptr, *queue_start = nullptr;
+    size_t n = 0;
+    double lam = std::nan("");          // from the file
+    int root = -1;
+};
+
+
+std::unique_ptr<TreeInstance>
+load_instance(const char *fname, const char *group = "/")
+{
+    std::unique_ptr<TreeInstance> t (new TreeInstance());
+    if (TreeBin::is_treebin(fname)) {
+        Timer _ ("Mapping Tree");
+        t->bin.reset(new TreeBin(fname));
+        const auto &bin = *t->bin;
+        bin.willneed();
+        t->n = bin.size();
+        t->y = bin.at<double>("y", t->n);
+        t->parent = bin.at<int>("parent", t->n);
+        t->postorder = bin.get<int>("postorder", t->n);
+        t->queue_start = bin.get<int>("queue_start", t->n);
+        t->lam = bin.first<double>("lam");
+        t->root = int(bin.root());
+    } else {
+        Timer _ ("Loading Tree");
+        HDF5 io (fname, "r");
+        io.group(group);
+        t->y_ = io.read<double>("y", &t->ydims);
+        auto lams = io.read<double>("lam");
+        assert(lams.size() >= 1);
+        t->lam = lams[0];
+        t->parent_ = io.read<decltype(t->parent_)::value_type>("parent");
+        if (io.has("xt")) {
+            t->xt = io.read<double>("xt");
+        }
+        if (io.has("postorder") && io.has("queue_start")) {
+            t->postorder_ = io.read<int>("postorder");
+            t->queue_start_ = io.read<int>("queue_start");
+            t->postorder = t->postorder_.data();
+            t->queue_start = t->queue_start_.data();
+        }
+        t->n = t->y_.size();
+        t->y = t->y_.data();
+        t->parent = t->parent_.data();
+    }
+    if (t->postorder && t->queue_start) {
+        t->root = t->postorder[t->n-1];
+    } else {
+        Timer _ ("find root");
+        t->root = t->root >= 0 ? t->root : find_root(t->n, t->parent);
+        t->postorder = t->queue_start = nullptr;
+    }
+    return t;
+}
+
+
+template<typename float_ = double>
+void
+solve_instance(const TreeInstance &t,
+               const double lam,
+               const bool merge_sort,
+               double *x,
+               TreeDPStatus &status)
+{
+    const Const<double> clam (lam);
+    const Ones<float_> mu;
+    constexpr bool lazy_sort = true;
+    if (merge_sort)
+        tree_dp<true, lazy_sort>(
+            t.n, x, t.y, t.parent, clam, mu, t.root, status, t.postorder, t.queue_start);
+    else
+        tree_dp<false, lazy_sort>(
+            t.n, x, t.y, t.parent, clam, mu, t.root, status, t.postorder, t.queue_start);
+}
+
+
+/** Store `x` in the instance file (HDF5) or next to it (binary) */
+void
+store_x(const char *fname,
+        const char *group,
+        const TreeInstance &t,
+        const std::vector<double> &x,
+        const std::string &name = "x++")
+{
+    if (t.bin) {
+        const std::string xname = std::string(fname) + "." +   // x++_0.1 -> x_0.1
+            (name.compare(0, 3, "x++") == 0 ? "x" + name.substr(3) : name);
+        TreeBinWriter(t.n, t.root).add("x", x).write(xname.c_str());
+    } else {
+        HDF5 io (fname, "r+");
+        io.group(group);
+        auto dims = t.ydims;
+        io.owrite(name.c_str(), x, &dims);
+    }
+}
+
+
+/**
+   Dual of the solution `x` (edge flows and gap; `mu = 1`), once with
+   `tree_dual` and `tree_dual_gap` and once in parallel (tree_dual_par.hpp)
+   with `threads`; print both times.
+ */
+void
+compare_duals(const TreeInstance &t,
+              const double lam,
+              const std::vector<double> &x,
+              const unsigned threads)
+{
+    using clock = std::chrono::steady_clock;
+    const auto seconds = [](const clock::time_point &start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+    const size_t n = t.n;
+    std::vector<int> postorder_, queue_start_;
+    const int *postorder = t.postorder;
+    if (!postorder) {
+        Timer _ ("tree orders");
+        tree_orders(n, t.parent, t.root, postorder_, queue_start_);
+        postorder = postorder_.data();
+    }
+    std::vector<int> first (n);
+    {   Timer _ ("subtree first");
+        subtree_first(n, t.parent, postorder, t.root, first.data());
+    }
+    std::vector<double> z (n), alpha (n), alpha_par (n), gamma (n), prefix (n);
+    const auto residuals = [&]() {
+        for (size_t i = 0; i < n; i++)
+            z[i] = x[i] - t.y[i];
+    };
+
+    residuals();
+    auto start = clock::now();
+    tree_dual(n, z.data(), t.parent, postorder, alpha.data(), t.root);
+    tree_dual_gap(n, gamma.data(), x.data(), alpha.data(), lam, t.parent);
+    double gap = 0.0;
+    for (size_t i = 0; i < n; i++)
+        gap += int(i) == t.root ? 0.0 : lam * gamma[i];
+    const double seq = seconds(start);
+
+    residuals();
+    start = clock::now();
+    tree_dual_par(n, alpha_par.data(), z.data(), postorder, first.data(), t.root, prefix,
+                  threads);
+    const double gap_par = tree_dual_gap_par(n, gamma.data(), x.data(), alpha_par.data(),
+                                             Const<double>(lam), t.parent, 0.0, threads);
+    const double par = seconds(start);
+
+    double diff = 0.0;
+    for (size_t i = 0; i < n; i++)
+        if (int(i) != t.root)
+            diff = std::max(diff, std::abs(alpha[i] - alpha_par[i]));
+    printf("dual: sequential %.4fs, %u threads %.4fs (speedup %.2f)\n"
+           "      gap %g (parallel %g), max |alpha - alpha_par| = %g\n",
+           seq, threads, par, par > 0 ? seq / par : 0.0, gap, gap_par, diff);
+}
 
 
 template<typename float_ = double>
@@ -26,82 +204,286 @@ process_tree(const char *fname,
              const bool output,
              const double lam_override,
              const int repeat = 5,
-             const bool verbose = true)
+             const bool verbose = true,
+             const bool dual = false,
+             const unsigned threads = 1,
+             const bool compact = false)
 {
     TimerQuiet _ (verbose);
 
-    std::vector<double> y, xt, x;
-    std::vector<int> parent;
-    double lam;
-    Ones<float_> mu;
-    HDF5::Dims ydims;
-    {   Timer _ ("Loading Tree");
-        HDF5 io (fname, "r");
-        y = io.read<double>("y", &ydims);
-        auto lams = io.read<double>("lam");
-        assert(lams.size() >= 1);
-        lam = std::isnan(lam_override) ? float_(lams[0]) : lam_override;
-        parent = io.read<decltype(parent)::value_type>("parent");
-        if (io.has("xt")) {
-            xt = io.read<double>("xt");
-        }
-    }
-    {
+    const auto inst = load_instance(fname);
+    const auto &t = *inst;
+    const double lam = std::isnan(lam_override) ? float_(t.lam) : lam_override;
+    if (!t.bin && !t.postorder) {
         Timer _ ("min parent\n");
-        std::cout << "  min(parent) = " 
-                  << *std::min_element(parent.begin(), parent.end())
+        std::cout << "  min(parent) = "
+                  << *std::min_element(t.parent_.begin(), t.parent_.end())
                   << std::endl;
 
     }
-    int root = -1;
-    {   Timer _ ("find root");
-        root = find_root(parent);
-    }
 
     if (verbose) {
-        std::cout << "   n = " << y.size() << std::endl;
+        std::cout << "   n = " << t.n << std::endl;
         std::cout << " lam = " << lam << std::endl;
     }
 
+    std::vector<double> x;
     {
         {   Timer _ ("resize x");
-                x.resize(y.size());
+                x.resize(t.n);
         }
         for (int r = 0; r < repeat; r++) {
             Timer _ ("tree_dp:\n");
-            Const<double> clam (lam);
-            constexpr bool lazy_sort = true;
-            if (merge_sort)
-                tree_dp<true, lazy_sort>(
-                    y.size(),
-                    x.data(),
-                    y.data(),
-                    parent.data(),
-                    clam,
-                    mu,
-                    root
-                );
-            else
-                tree_dp<false, lazy_sort>(
-                    y.size(),
-                    x.data(),
-                    y.data(),
-                    parent.data(),
-                    clam,
-                    mu,
-                    root
-                );
+            {
+                Timer timer ("memory alloc");
+                TreeDPStatus status (t.n, t.postorder == nullptr);
+                status.threads = threads;
+                status.compact = compact;
+                timer.stop();
+                solve_instance<float_>(t, lam, merge_sort, x.data(), status);
+                if (verbose && compact)
+                    std::cout << "  merged = " << status.merged << " events"
+                              << std::endl;
+                Timer::startit("free");
+            }
             Timer::stopit();
         }
     }
     if (verbose && x.size() <= 20) {
         std::cout << x << std::endl;
     }
+    if (dual)
+        compare_duals(t, lam, x, threads);
     if (output) {
         Timer _ ("store x");
-        HDF5 io (fname, "r+");
-        io.owrite("x++", x, &ydims);
+        store_x(fname, "/", t, x);
+    }
+}
+
+
+/** One line of a batch file: `file[:group] [lam ...]` */
+struct BatchInstance
+{
+    std::string file, group;
+    std::vector<double> lams;           // empty: "lam" from the file
+};
+
+
+std::vector<BatchInstance>
+read_batch(const char *fname)
+{
+    std::ifstream in (fname);
+    if (!in)
+        throw std::runtime_error(std::string("Could not open ") + fname);
+    std::vector<BatchInstance> batch;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream words (line);
+        std::string word;
+        if (!(words >> word) || word[0] == '#')
+            continue;
+        BatchInstance b;
+        const auto colon = word.rfind(':');
+        b.file = word.substr(0, colon);
+        b.group = colon == std::string::npos ? "/" : word.substr(colon + 1);
+        double lam;
+        while (words >> lam)
+            b.lams.push_back(lam);
+        if (!words.eof())
+            throw std::runtime_error("Could not parse line \"" + line + "\"");
+        batch.push_back(b);
     }
+    return batch;
+}
+
+
+/**
+   Solve all (instance, λ) pairs of a batch file on `threads` solver
+   threads.  HDF5 is not thread-safe, so the calling thread does all the
+   I/O: it loads the next instances while the solvers are busy and stores
+   the solutions as they arrive.  Every solver keeps its `TreeDPStatus`
+   between jobs.  One row per job is written to `timing` (TSV).
+   Returns the number of failed jobs.
+ */
+size_t
+process_batch(const char *batch_file,
+              const bool merge_sort,
+              const bool output,
+              const unsigned threads,
+              std::ostream &timing)
+{
+    struct Job
+    {
+        size_t inst;
+        double lam;
+        std::string name;               // of x
+        double solve = 0, store = 0;
+        unsigned thread = 0;
+        std::vector<double> x;
+        std::string error;
+    };
+
+    using clock = std::chrono::steady_clock;
+    const auto seconds = [](const clock::time_point &start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+    const auto batch = read_batch(batch_file);
+    std::vector<Job> jobs;
+    std::vector<size_t> first_job (batch.size() + 1, 0);
+    const auto add_job = [&](const size_t i, const double lam, const std::string &name) {
+        jobs.emplace_back();
+        jobs.back().inst = i;
+        jobs.back().lam = lam;
+        jobs.back().name = name;
+    };
+    for (size_t i = 0; i < batch.size(); i++) {
+        first_job[i] = jobs.size();
+        if (batch[i].lams.empty()) {
+            add_job(i, std::nan(""), "x++");
+        } else {
+            for (const auto lam : batch[i].lams) {
+                char name[64];
+                snprintf(name, sizeof(name), "x++_%g", lam);
+                add_job(i, lam, name);
+            }
+        }
+    }
+    first_job[batch.size()] = jobs.size();
+
+    std::vector<std::unique_ptr<TreeInstance>> inst (batch.size());
+    std::vector<double> load_time (batch.size(), 0.0);
+    std::vector<size_t> size (batch.size(), 0);
+    std::vector<std::string> load_error (batch.size());
+    std::vector<size_t> left (batch.size());        // jobs not stored yet
+    std::deque<size_t> todo, finished;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable task_cv, done_cv;
+
+    const auto io = [&]() {
+        size_t next = 0, pending = 0;
+        while (next < batch.size() || pending > 0) {
+            std::unique_lock<std::mutex> lock (mutex);
+            if (finished.empty() && next < batch.size() && todo.size() < threads) {
+                lock.unlock();
+                const size_t i = next++;
+                const auto start = clock::now();
+                try {
+                    inst[i] = load_instance(batch[i].file.c_str(), batch[i].group.c_str());
+                } catch (std::exception &e) {
+                    load_error[i] = e.what();
+                }
+                load_time[i] = seconds(start);
+                lock.lock();
+                if (inst[i]) {
+                    size[i] = inst[i]->n;
+                    left[i] = first_job[i+1] - first_job[i];
+                    for (size_t j = first_job[i]; j < first_job[i+1]; j++)
+                        todo.push_back(j);
+                    pending += left[i];
+                    task_cv.notify_all();
+                }
+                continue;
+            }
+            done_cv.wait(lock, [&]() {
+                return !finished.empty() ||
+                    (next < batch.size() && todo.size() < threads);
+            });
+            if (finished.empty())
+                continue;
+            const size_t j = finished.front();
+            finished.pop_front();
+            lock.unlock();
+
+            auto &job = jobs[j];
+            const auto &b = batch[job.inst];
+            if (output && job.error.empty()) {
+                const auto start = clock::now();
+                try {
+                    store_x(b.file.c_str(), b.group.c_str(), *inst[job.inst], job.x,
+                            job.name);
+                } catch (std::exception &e) {
+                    job.error = e.what();
+                }
+                job.store = seconds(start);
+            }
+            std::vector<double>().swap(job.x);
+            pending--;
+            if (--left[job.inst] == 0)
+                inst[job.inst].reset();
+        }
+        std::lock_guard<std::mutex> lock (mutex);
+        closed = true;
+        task_cv.notify_all();
+    };
+
+    const auto solver = [&](const unsigned t) {
+        std::unique_ptr<TreeDPStatus> status;
+        size_t capacity = 0;
+        bool topology = false;
+        while (true) {
+            size_t j;
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                task_cv.wait(lock, [&]() { return closed || !todo.empty(); });
+                if (todo.empty())
+                    return;
+                j = todo.front();
+                todo.pop_front();
+            }
+            done_cv.notify_one();       // room for the next instance
+
+            auto &job = jobs[j];
+            const auto &in = *inst[job.inst];
+            const bool need_topology = in.postorder == nullptr;
+            const auto start = clock::now();
+            if (std::isnan(job.lam))
+                job.lam = in.lam;
+            try {
+                if (!status || capacity < in.n || (need_topology && !topology)) {
+                    status.reset();
+                    capacity = in.n;
+                    topology = need_topology;
+                    status.reset(new TreeDPStatus(capacity, topology));
+                }
+                job.x.resize(in.n);
+                solve_instance(in, job.lam, merge_sort, job.x.data(), *status);
+            } catch (std::exception &e) {
+                job.error = e.what();
+            }
+            job.solve = seconds(start);
+            job.thread = t;
+
+            std::lock_guard<std::mutex> lock (mutex);
+            finished.push_back(j);
+            done_cv.notify_one();
+        }
+    };
+
+    {
+        TimerQuiet _ (false);
+        ThreadPool pool (threads + 1);
+        pool.each([&](unsigned t) {
+            if (t == 0)
+                io();
+            else
+                solver(t);
+        });
+    }
+
+    size_t failed = 0;
+    timing << "file\tgroup\tlam\tn\tload\tsolve\tstore\tthread\terror\n";
+    for (const auto &job : jobs) {
+        const auto &b = batch[job.inst];
+        const auto &error = load_error[job.inst].empty() ? job.error
+                                                          : load_error[job.inst];
+        failed += error.empty() ? 0 : 1;
+        timing << b.file << '\t' << b.group << '\t' << job.lam << '\t'
+               << size[job.inst] << '\t'
+               << load_time[job.inst] << '\t' << job.solve << '\t'
+               << job.store << '\t' << job.thread << '\t' << error << '\n';
+    }
+    return failed;
 }
 
 
@@ -113,12 +495,27 @@ main(int argc, char *argv[])
             "treesolve [file]\n"
             "\n"
             "Compute exact fused lasso solution on a tree graph.\n"
-            "Input [file] is assumed in HDF5 format.\n"
+            "Input [file] is either in HDF5 format or a binary instance\n"
+            "(see h5tobin) which is memory-mapped; the solution of the\n"
+            "latter is written to [file].x\n"
+            "\n"
+            "With --batch, [file] lists one instance per line as\n"
+            "    path[:group] [lam ...]\n"
+            "whereby x is stored as \"x++_<lam>\" (\"x++\" if no lam is given).\n"
         );
         ap.add_option('m', "merge",     "Use merging (instead of std::sort)");
         ap.add_option('O', "no-output", "Do not write output");
         ap.add_option('r', "repeat",    "Repeat execution", "num", "1");
         ap.add_option('l', "lam",       "Tuning parameter λ", "num", "nan");
+        ap.add_option('b', "batch",     "[file] is a list of instances (see above)");
+        ap.add_option('d', "dual",      "Compute the dual sequentially and in parallel");
+        ap.add_option('t', "threads",   "Batch: solver threads [0: all cores], "
+                      "otherwise: threads for the orders and the dual [0: sequential]",
+                      "INT", "0");
+        ap.add_option('c', "compact",   "Coalesce equal events in the queues "
+                      "(equal up to rounding)");
+        ap.add_option('T', "timing",    "Batch: timing table (TSV) [default: stdout]",
+                      "FILE", "-");
         ap.parse(&argc, argv);
         if (argc <= 1) {
             fprintf(stderr, "No tree file!\n");
@@ -126,6 +523,22 @@ main(int argc, char *argv[])
         }
         const char *fname = argv[1];
         setlocale(LC_ALL, "C");
+        const int threads = std::atoi(ap.get_option("threads"));
+        if (ap.has_option("batch")) {
+            const std::string tname = ap.get_option("timing");
+            std::ofstream tfile;
+            if (tname != "-")
+                tfile.open(tname);
+            const size_t failed =
+                process_batch(fname,
+                              ap.has_option("merge"),
+                              !ap.has_option("no-output"),
+                              threads > 0 ? unsigned(threads) : default_threads(),
+                              tname != "-" ? tfile : std::cout);
+            if (failed > 0)
+                fprintf(stderr, "%d jobs failed\n", int(failed));
+            return failed > 0 ? 4 : 0;
+        }
         set_thousand_sep(std::cout);
         const int repeat = std::atoi(ap.get_option("repeat"));
         printf("%s\n", fname);
@@ -133,7 +546,11 @@ main(int argc, char *argv[])
                      ap.has_option("merge"),
                      !ap.has_option("no-output"),
                      std::atof(ap.get_option("lam")),
-                     repeat);
+                     repeat,
+                     true,
+                     ap.has_option("dual"),
+                     threads > 0 ? unsigned(threads) : 1u,
+                     ap.has_option("compact"));
     } catch (const char *msg) {
         fprintf(stderr, "EXCEPTION: %s\n", msg);
     } catch (std::exception &e) {
@@ -0,0 +1,117 @@
+/**
+   Store the topology information needed by tree_dp, tree_apx and
+   tree_dual ("postorder" and "queue_start", see `tree_orders` in
+   merge.hpp) in a tree instance, so that solvers can skip the children
+   index and the DFS.  Works on HDF5 as well as binary instances.
+ */
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <argparser.hpp>
+#include <minih5.hpp>
+
+#include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../merge.hpp"
+#include "../tree_bin.hpp"
+
+
+/** Rewrite the container (to a temporary file that is then renamed) */
+void
+prep_bin(const char *fname)
+{
+    const std::string tmp = std::string(fname) + ".tmp";
+    {
+        const TreeBin bin(fname);
+        const size_t n = bin.size();
+        const int *parent = bin.at<int>("parent", n);
+        int root = int(bin.root());
+        if (root < 0) {
+            Timer _("find root");
+            root = find_root(n, parent);
+        }
+        std::vector<int> postorder, queue_start;
+        {
+            Timer _("orders");
+            tree_orders(n, parent, root, postorder, queue_start);
+        }
+        Timer _("Writing binary");
+        TreeBinWriter w(n, root);
+        for (const auto &e : bin.arrays())
+            if (std::strncmp(e.name, "postorder", sizeof(e.name)) != 0 &&
+                std::strncmp(e.name, "queue_start", sizeof(e.name)) != 0)
+                w.add(e, bin.data(e));
+        w.add("postorder", postorder).add("queue_start", queue_start);
+        w.write(tmp.c_str());
+    }
+    if (std::rename(tmp.c_str(), fname) != 0)
+        throw std::runtime_error(std::string("Could not rename ") + tmp);
+}
+
+
+void
+prep_h5(const char *fname, const char *group)
+{
+    std::vector<int> parent;
+    {
+        Timer _("Loading HDF5");
+        HDF5 io(fname, "r");
+        io.group(group);
+        parent = io.read<int>("parent");
+    }
+    int root = -1;
+    {
+        Timer _("find root");
+        root = find_root(parent);
+    }
+    if (root < 0)
+        throw std::runtime_error("parent has no root");
+    std::vector<int> postorder, queue_start;
+    {
+        Timer _("orders");
+        tree_orders(parent.size(), parent.data(), root, postorder, queue_start);
+    }
+    Timer _("Writing HDF5");
+    HDF5 io(fname, "r+");
+    io.group(group);
+    io.owrite("postorder", postorder);
+    io.owrite("queue_start", queue_start);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    ArgParser ap(
+        "tree_prep [file]\n"
+        "\n"
+        "Precompute the post-order and queue positions of a tree instance\n"
+        "(HDF5 or binary, see h5tobin) and store them in the file.");
+    try {
+        ap.add_option('g', "group", "HDF5 group [default \"/\"]", "STR", "/");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        if (TreeBin::is_treebin(argv[1]))
+            prep_bin(argv[1]);
+        else
+            prep_h5(argv[1], ap.get_option("group"));
+    } catch (ArgParser::ArgParserException &e) {
+        fprintf(stderr, "%s\n", e.what());
+        ap.print_usage();
+        return 1;
+    } catch (std::exception &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+    return 0;
+}
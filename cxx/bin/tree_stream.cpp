@@ -0,0 +1,101 @@
+/**
+   Solve a binary tree instance (see h5tobin, prepared by tree_prep) that is
+   too large for the memory: see tree_stream.hpp.  The solution is stored
+   next to the instance as `<file>.x` (binary format, array "x").
+ */
+#include <cmath>            // std::isnan
+#include <cstdio>
+#include <cstdlib>          // std::atof, std::atoi
+#include <stdexcept>
+#include <string>
+
+#include <argparser.hpp>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../mmap_file.hpp"
+#include "../tree_bin.hpp"
+#include "../tree_stream.hpp"
+
+
+void
+process_file(
+    const char *fname,
+    const char *out_name,
+    double lam,
+    const size_t block,
+    const char *scratch_dir)
+{
+    const TreeBin bin (fname);
+    const size_t n = bin.size();
+    const int *postorder = bin.get<int>("postorder", n);
+    const int *queue_start = bin.get<int>("queue_start", n);
+    if (!postorder || !queue_start)
+        throw std::runtime_error(std::string("No stored orders (run tree_prep): ") +
+                                 fname);
+    if (std::isnan(lam))
+        lam = bin.first<double>("lam");
+    fprintf(stderr, "n = %ld, lam = %g, block = %ld\n", long(n), lam, long(block));
+
+    ScratchFile xfile (n * sizeof(double), scratch_dir);
+    auto *x = reinterpret_cast<double *>(xfile.data());
+    {
+        Timer _("tree_dp_stream:\n");
+        tree_dp_stream(
+            n,
+            bin.at<double>("y", n),
+            bin.at<int>("parent", n),
+            postorder,
+            queue_start,
+            Const<double>(lam),
+            Ones<double>(),
+            [&](const int *nodes, const double *xb, size_t count) {
+                for (size_t j = 0; j < count; j++)
+                    x[nodes[j]] = xb[j];
+            },
+            block,
+            scratch_dir);
+    }
+    Timer _("Writing x");
+    TreeBinWriter(n, bin.root()).add("x", x, n).write(out_name);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    ArgParser ap(
+        "tree_stream [file.bin] [out.bin]\n"
+        "\n"
+        "Fused lasso on a tree instance without loading it into memory");
+    try {
+        ap.add_option('l', "lam", "Tuning parameter λ [default: \"lam\" in file]", "num", "nan");
+        ap.add_option('b', "block", "Nodes per block", "INT", "1048576");
+        ap.add_option('s', "scratch", "Directory of the scratch files [$TMPDIR]", "DIR", "");
+        ap.parse(&argc, argv);
+        if (argc <= 1) {
+            fprintf(stderr, "No file!\n");
+            return 1;
+        }
+        const std::string out = argc > 2 ? argv[2] : std::string(argv[1]) + ".x";
+        const std::string scratch = ap.get_option("scratch");
+        process_file(argv[1],
+                     out.c_str(),
+                     std::atof(ap.get_option("lam")),
+                     size_t(std::max(1, std::atoi(ap.get_option("block")))),
+                     scratch.empty() ? nullptr : scratch.c_str());
+        printf("%s\n", out.c_str());
+    } catch (ArgParser::ArgParserException &e) {
+        fprintf(stderr, "%s\n", e.what());
+        ap.print_usage();
+        return 1;
+    } catch (std::exception &e) {
+        fprintf(stderr, "EXCEPTION: %s\n", e.what());
+        return 2;
+    } catch (const char *msg) {
+        fprintf(stderr, "EXCEPTION: %s\n", msg);
+        return 3;
+    }
+    return 0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>      // max
+#include <chrono>
 #include <cstdio>
 #include <fstream>
 #include <string>         // stoi
@@ -5,6 +7,8 @@
 #include <argparser.hpp>
 #include <graphidx/io/bz2istream.hpp>
 
+#include "../bz2_blocks.hpp"
+
 
 int
 main(int argc, char *argv[])
@@ -17,6 +21,8 @@ main(int argc, char *argv[])
     );
     ap.add_option('r', "only-read", "Don't write (for benchmarking)");
     ap.add_option('b', "buf-size",  "Buffer size [8192]", "INT", "8192");
+    ap.add_option('t', "threads",
+                  "Decode blocks in parallel (0: sequential stream) [0]", "INT", "0");
     ap.parse(&argc, argv);
 
     if (argc <= 1) {
@@ -29,15 +35,39 @@ main(int argc, char *argv[])
     const char *outfn =  (argc > 2) ? argv[2] : "out.txt";
     const int buf_size = atoi(ap.get_option("buf-size"));
     const bool only_read = ap.has_option("only-read");
+    const int threads = atoi(ap.get_option("threads"));
 
-    BZ2IStream io (infn, buf_size);
-    {
+    const auto start = std::chrono::steady_clock::now();
+    size_t nbytes = 0;
+    if (threads > 0) {
+        std::fstream out;
+        if (!only_read) {
+            out.open(outfn, std::ios::out | std::ios::binary);
+            if (!out) {
+                fprintf(stderr, "Could not open \"%s\" for writing\n", outfn);
+                return 2;
+            }
+        }
+        try {
+            Bz2Blocks bz (infn, unsigned(threads));
+            fprintf(stderr, "%ld blocks\n", long(bz.num_blocks()));
+            bz.decompress([&](const char *data, size_t len) {
+                nbytes += len;
+                only_read || out.write(data, std::streamsize(len));
+            });
+        } catch (std::exception &e) {
+            fprintf(stderr, "EXCEPTION: %s\n", e.what());
+            return 3;
+        }
+    } else {
+        BZ2IStream io (infn, buf_size);
         std::fstream out (outfn, std::ios::out | std::ios::binary);
         if (out) {
-            std::unique_ptr<char> buf (new char[buf_size]);
+            std::unique_ptr<char[]> buf (new char[buf_size]);
             while (io) {
                 io.read(buf.get(), buf_size);
                 auto nread = io.gcount();
+                nbytes += size_t(nread);
                 only_read || out.write(buf.get(), nread);
             }
         } else {
@@ -45,6 +75,11 @@ main(int argc, char *argv[])
             return 2;
         }
     }
+    const std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    fprintf(stderr, "%.1f MB in %.3f s: %.1f MB/s\n",
+            double(nbytes) * 1e-6,
+            secs.count(),
+            double(nbytes) * 1e-6 / std::max(secs.count(), 1e-9));
 
     return 0;
 }
@@ -0,0 +1,315 @@
+/**
+   Parallel minimum spanning tree (Borůvka's algorithm) without any
+   external dependency.
+
+   In every round, each component selects its lightest incident edge
+   (in parallel over all edges, using atomic compare-and-swap), then the
+   components are merged along the selected edges.
+   Ties are broken by the edge index, i.e. the edges are totally ordered
+   and the resulting tree is unique; in particular it coincides with the
+   one found by Prim's algorithm if all weights are distinct.
+ */
+#pragma once
+#include <algorithm>          // std::fill
+#include <atomic>
+#include <cstdint>          // uint64_t
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <graphidx/edges.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "parallel.hpp"
+
+
+/** Tag to select `BoruvkaMST` instead of a heap for Prim's algorithm. */
+struct Boruvka
+{
+};
+
+
+/**
+   Memory needed to compute minimum spanning trees of the same graph
+   several times (with changing weights), e.g. in `gaplas`.
+ */
+template <typename int_t = int>
+struct BoruvkaMST
+{
+    size_t n = 0, m = 0;
+    std::vector<int_t> head, tail;          // endpoints of every edge
+    std::vector<char> in_tree;              // in_tree[e] iff e in the tree
+    std::vector<int_t> comp, link, index, adj;
+    std::vector<std::atomic<int_t>> best;
+
+    BoruvkaMST() = default;
+
+    template <typename Graph>
+    BoruvkaMST(const Graph &graph)
+    {
+        reset(graph);
+    }
+
+    /** Extract the edges (once) from `graph`. */
+    template <typename Graph>
+    void reset(const Graph &graph);
+
+    /** Take the edges from lists (self loops are ignored). */
+    void reset(const size_t n, const std::vector<int_t> &head, const std::vector<int_t> &tail);
+
+    /** Compute the edges of the minimum spanning forest (`in_tree`).
+        Return their number. */
+    template <typename float_t>
+    size_t mst(const float_t *weight, const unsigned threads = default_threads());
+
+    /** Orient the tree edges towards `root`, i.e. compute `parent`.
+        Nodes not connected to `root` become roots of their own tree. */
+    void orient(int_t *parent, const int_t root);
+};
+
+
+template <typename int_t>
+template <typename Graph>
+void
+BoruvkaMST<int_t>::reset(const Graph &graph)
+{
+    n = graph.num_nodes();
+    m = graph.num_edges();
+    head.assign(m, int_t(-1));
+    tail.assign(m, int_t(-1));
+    in_tree.assign(m, 0);
+    comp.resize(n);
+    link.resize(n);
+    index.resize(n + 1);
+    adj.resize(2 * n);
+    best = std::vector<std::atomic<int_t>>(n);
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
+        if (u < v) {
+            head[e] = u;
+            tail[e] = v;
+        }
+    });
+}
+
+
+template <typename int_t>
+void
+BoruvkaMST<int_t>::reset(
+    const size_t n,
+    const std::vector<int_t> &head,
+    const std::vector<int_t> &tail)
+{
+    this->n = n;
+    m = head.size();
+    this->head = head;
+    this->tail = tail;
+    in_tree.assign(m, 0);
+    comp.resize(n);
+    link.resize(n);
+    index.resize(n + 1);
+    adj.resize(2 * n);
+    best = std::vector<std::atomic<int_t>>(n);
+}
+
+
+template <typename int_t>
+template <typename float_t>
+size_t
+BoruvkaMST<int_t>::mst(const float_t *weight, const unsigned threads)
+{
+    const auto lighter = [weight](const int_t e, const int_t f) {
+        return f < 0 || weight[e] < weight[f] || (weight[e] == weight[f] && e < f);
+    };
+    const auto offer = [&lighter](std::atomic<int_t> &b, const int_t e) {
+        int_t cur = b.load(std::memory_order_relaxed);
+        while (lighter(e, cur) &&
+               !b.compare_exchange_weak(cur, e, std::memory_order_relaxed)) {
+        }
+    };
+    const auto find = [this](int_t c) {
+        int_t r = c;
+        while (link[r] != r)
+            r = link[r];
+        while (link[c] != r) {
+            const auto next = link[c];
+            link[c] = r;
+            c = next;
+        }
+        return r;
+    };
+
+    parallel_for(n, threads, [&](size_t v) { comp[v] = link[v] = int_t(v); });
+    parallel_for(m, threads, [&](size_t e) { in_tree[e] = 0; });
+    std::vector<int_t> roots(n);
+    for (size_t v = 0; v < n; v++)
+        roots[v] = int_t(v);
+
+    size_t num_tree = 0;
+    while (roots.size() > 1) {
+        for (const auto r : roots)
+            best[r].store(int_t(-1), std::memory_order_relaxed);
+        parallel_for(m, threads, [&](size_t e) {
+            if (head[e] < 0)
+                return;
+            const auto cu = comp[head[e]], cv = comp[tail[e]];
+            if (cu != cv) {
+                offer(best[cu], int_t(e));
+                offer(best[cv], int_t(e));
+            }
+        });
+
+        size_t hooked = 0;
+        for (const auto r : roots) {
+            const auto e = best[r].load(std::memory_order_relaxed);
+            if (e < 0)
+                continue;
+            const auto cu = comp[head[e]], cv = comp[tail[e]];
+            const auto other = cu == r ? cv : cu;
+            if (best[other].load(std::memory_order_relaxed) == e && r < other)
+                continue;           // both chose `e`: `r` stays the root
+            link[r] = other;
+            in_tree[e] = 1;
+            hooked++;
+        }
+        if (hooked == 0)
+            break;                  // graph is not connected
+        num_tree += hooked;
+
+        size_t k = 0;
+        for (const auto r : roots) {
+            find(r);
+            if (link[r] == r)
+                roots[k++] = r;
+        }
+        roots.resize(k);
+        parallel_for(n, threads, [&](size_t v) { comp[v] = link[comp[v]]; });
+    }
+    return num_tree;
+}
+
+
+template <typename int_t>
+void
+BoruvkaMST<int_t>::orient(int_t *parent, const int_t root)
+{
+    if (root < 0 || size_t(root) >= n)
+        throw std::invalid_argument(
+            std::string("BoruvkaMST::orient(): root = ") + std::to_string(root));
+    std::fill(index.begin(), index.end(), int_t(0));
+    for (size_t e = 0; e < m; e++) {
+        if (in_tree[e]) {
+            index[head[e] + 1]++;
+            index[tail[e] + 1]++;
+        }
+    }
+    for (size_t v = 0; v < n; v++)
+        index[v + 1] += index[v];
+    for (size_t e = 0; e < m; e++) {
+        if (in_tree[e]) {
+            adj[index[head[e]]++] = tail[e];
+            adj[index[tail[e]]++] = head[e];
+        }
+    }
+    for (size_t v = n; v > 0; v--)
+        index[v] = index[v - 1];
+    index[0] = 0;
+
+    // breadth first search; reuse `comp` as queue and `link` as marker
+    std::fill(link.begin(), link.end(), int_t(0));
+    size_t qend = 0;
+    for (size_t s = 0; s < n; s++) {
+        const auto r = s == 0 ? root : int_t(s);
+        if (link[r])
+            continue;
+        link[r] = 1;
+        parent[r] = r;
+        size_t qbegin = qend;
+        comp[qend++] = r;
+        while (qbegin < qend) {
+            const auto u = comp[qbegin++];
+            for (auto i = index[u]; i < index[u + 1]; i++) {
+                const auto v = adj[i];
+                if (!link[v]) {
+                    link[v] = 1;
+                    parent[v] = u;
+                    comp[qend++] = v;
+                }
+            }
+        }
+    }
+}
+
+
+/**
+   Compute a minimum spanning tree of `graph` regarding `weight` (indexed by
+   edges) and store it as `parent` array, rooted at `root`.
+ */
+template <typename int_t, typename float_t, typename Graph>
+void
+boruvka_mst_edges(
+    int_t *parent,
+    const float_t *weight,
+    const Graph &graph,
+    const int_t root = 0,
+    const unsigned threads = default_threads())
+{
+    BoruvkaMST<int_t> mst;
+    {
+        Timer _("boruvka: edges");
+        mst.reset(graph);
+    }
+    {
+        Timer _("boruvka: mst");
+        mst.mst(weight, threads);
+    }
+    {
+        Timer _("boruvka: orient");
+        mst.orient(parent, root);
+    }
+}
+
+
+/**
+   Random spanning tree of the (connected) graph given by `head` and `tail`,
+   rooted at node 0: the minimum spanning tree regarding independent
+   uniform edge weights.  The weight of an edge only depends on `seed` and
+   the edge's index, so the tree does not depend on the number of threads.
+ */
+template <typename int_t = int>
+std::vector<int_t>
+boruvka_random_tree(
+    const size_t n,
+    const std::vector<int_t> &head,
+    const std::vector<int_t> &tail,
+    const uint64_t seed,
+    const unsigned threads = default_threads())
+{
+    std::vector<double> weight (head.size());
+    {
+        Timer _("boruvka: weights");
+        parallel_for(weight.size(), threads, [&](size_t e) {
+            uint64_t z = seed + 0x9e3779b97f4a7c15ull * (e + 1);    // splitmix64
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z ^= z >> 31;
+            weight[e] = double(z >> 11) * 0x1.0p-53;
+        });
+    }
+    std::vector<int_t> parent (n);
+    if (n == 0)
+        return parent;
+    BoruvkaMST<int_t> mst;
+    {
+        Timer _("boruvka: edges");
+        mst.reset(n, head, tail);
+    }
+    {
+        Timer _("boruvka: mst");
+        mst.mst(weight.data(), threads);
+    }
+    {
+        Timer _("boruvka: orient");
+        mst.orient(parent.data(), int_t(0));
+    }
+    return parent;
+}
@@ -0,0 +1,251 @@
+/**
+   Parallel decompression of bzip2 files.
+
+   A bzip2 stream consists of blocks that can be decoded independently;
+   each starts with the 48-bit magic 0x314159265359 (not byte-aligned) and
+   the stream ends with 0x177245385090.  The whole (memory-mapped) file is
+   scanned for these magics, every block is copied into a stream of its
+   own and decoded by libbz2 on a thread pool.  The decoded blocks are
+   handed to the consumer in order, a batch of blocks at a time.
+
+   A magic may also appear by chance inside the compressed data; then the
+   decoding (CRC check) fails and the block is retried together with the
+   following one.
+ */
+#pragma once
+#include <algorithm>        // std::max
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <bzlib.h>
+
+#include "mmap_file.hpp"
+#include "parallel.hpp"
+
+
+namespace bz2blocks {
+
+constexpr uint64_t BLOCK_MAGIC = 0x314159265359ull;
+constexpr uint64_t END_MAGIC = 0x177245385090ull;
+
+/** Position (in bits) of a magic in the file */
+struct Mark
+{
+    uint64_t bit;
+    bool block;         // block or end of stream
+};
+
+
+/** The `count <= 57` bits starting at bit `pos` (most significant first) */
+inline uint64_t
+get_bits(const uint8_t *data, const size_t nbytes, const uint64_t pos, const int count)
+{
+    uint64_t w = 0;
+    const size_t byte = size_t(pos / 8);
+    for (size_t i = 0; i < 8; i++)
+        w = (w << 8) | (byte + i < nbytes ? data[byte + i] : 0u);
+    return (w << (pos % 8)) >> (64 - count);
+}
+
+
+/** Append bits to a byte buffer */
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<char> &out) : out(out) { }
+
+    void put(const uint64_t bits, const int count)       // count <= 57
+    {
+        acc = (acc << count) | (bits & ((uint64_t(1) << count) - 1));
+        nacc += count;
+        while (nacc >= 8) {
+            nacc -= 8;
+            out.push_back(char(uint8_t(acc >> nacc)));
+        }
+    }
+
+    /** Copy the bits `[start, stop)` of `data` */
+    void copy(const uint8_t *data, const size_t nbytes, uint64_t start, const uint64_t stop)
+    {
+        for (; start + 48 <= stop; start += 48)
+            put(get_bits(data, nbytes, start, 48), 48);
+        if (start < stop)
+            put(get_bits(data, nbytes, start, int(stop - start)), int(stop - start));
+    }
+
+    void flush()
+    {
+        if (nacc > 0)
+            put(0, 8 - nacc);
+    }
+
+private:
+    std::vector<char> &out;
+    uint64_t acc = 0;
+    int nacc = 0;
+};
+
+
+/** Find all block and end-of-stream magics in `[8*begin, 8*end)` */
+inline void
+scan(const uint8_t *data, const size_t nbytes, size_t begin, const size_t end,
+     std::vector<Mark> &marks)
+{
+    const uint64_t mask = (uint64_t(1) << 48) - 1;
+    uint64_t w = 0;                     // bits [8*begin - 64, 8*begin)
+    for (size_t i = begin >= 8 ? begin - 8 : 0; i < begin; i++)
+        w = (w << 8) | data[i];
+    for (size_t i = begin; i < end + 6 && i < nbytes; i++) {
+        w = (w << 8) | data[i];
+        // magics ending within byte i: start at bit 8*(i+1) - 48 - s
+        for (int s = 7; s >= 0; s--) {
+            const uint64_t v = (w >> s) & mask;
+            if (v != BLOCK_MAGIC && v != END_MAGIC)
+                continue;
+            const uint64_t bit = 8 * uint64_t(i + 1) - 48 - uint64_t(s);
+            if (8 * (i + 1) < 48 + uint64_t(s) || bit < 8 * uint64_t(begin) ||
+                bit >= 8 * uint64_t(end))
+                continue;
+            marks.push_back(Mark{bit, v == BLOCK_MAGIC});
+        }
+    }
+}
+
+
+/**
+   Decode the block in bits `[start, stop)` of `data` (without the
+   end-of-stream magic) into `out`.  Return false on corrupt data.
+ */
+inline bool
+decode(const uint8_t *data,
+       const size_t nbytes,
+       const uint64_t start,
+       const uint64_t stop,
+       std::vector<char> &out,
+       std::vector<char> &stream)
+{
+    stream.clear();
+    stream.reserve(size_t((stop - start) / 8) + 16);
+    BitWriter w (stream);
+    for (const char c : {'B', 'Z', 'h', '9'})
+        w.put(uint8_t(c), 8);
+    w.copy(data, nbytes, start, stop);
+    w.put(END_MAGIC, 48);
+    w.put(get_bits(data, nbytes, start + 48, 32), 32);  // one block: stream CRC = block CRC
+    w.flush();
+
+    bz_stream strm;
+    strm.bzalloc = nullptr;
+    strm.bzfree = nullptr;
+    strm.opaque = nullptr;
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK)
+        throw std::runtime_error("BZ2_bzDecompressInit failed");
+    strm.next_in = stream.data();
+    strm.avail_in = unsigned(stream.size());
+    out.resize(std::max<size_t>(out.capacity(), 1 << 20));
+    size_t have = 0;
+    int ret = BZ_OK;
+    while (ret == BZ_OK) {
+        if (have == out.size())
+            out.resize(2 * out.size());
+        strm.next_out = out.data() + have;
+        strm.avail_out = unsigned(out.size() - have);
+        ret = BZ2_bzDecompress(&strm);
+        have = out.size() - strm.avail_out;
+        if (ret == BZ_OK && strm.avail_in == 0 && strm.avail_out > 0)
+            break;                      // truncated
+    }
+    BZ2_bzDecompressEnd(&strm);
+    out.resize(have);
+    return ret == BZ_STREAM_END;
+}
+
+}   // namespace bz2blocks
+
+
+/**
+   Decompress a bzip2 file (also several concatenated streams as written
+   by pbzip2) with `threads` threads.
+ */
+class Bz2Blocks
+{
+public:
+    Bz2Blocks(const char *fname, const unsigned threads = default_threads())
+        : file(fname), pool(threads)
+    {
+        const auto *data = reinterpret_cast<const uint8_t *>(file.data());
+        const size_t n = file.size();
+        if (n < 4 || data[0] != 'B' || data[1] != 'Z' || data[2] != 'h')
+            throw std::runtime_error(std::string("Not a bzip2 file: ") + fname);
+        file.willneed(0, n);
+        std::vector<std::vector<bz2blocks::Mark>> found (pool.size());
+        pool.blocks(n, [&](size_t begin, size_t end, unsigned t) {
+            bz2blocks::scan(data, n, begin, end, found[t]);
+        });
+        for (const auto &f : found)
+            marks.insert(marks.end(), f.begin(), f.end());
+        for (const auto &m : marks)
+            nblocks += m.block ? 1 : 0;
+    }
+
+    /** Number of blocks (might include a few false positives) */
+    size_t num_blocks() const { return nblocks; }
+
+    /** Size of the compressed file */
+    size_t size() const { return file.size(); }
+
+    /**
+       Call `consume(const char *data, size_t len)` for every decoded block
+       in order; `batch` blocks (default: two per thread) are decoded in
+       parallel before they are consumed.
+     */
+    template <typename F>
+    void decompress(F consume, size_t batch = 0)
+    {
+        using namespace bz2blocks;
+        const auto *data = reinterpret_cast<const uint8_t *>(file.data());
+        const size_t n = file.size();
+        if (batch == 0)
+            batch = 2 * pool.size();
+        std::vector<size_t> idx;            // marks of the blocks in this batch
+        std::vector<std::vector<char>> out (batch), stream (pool.size());
+        std::vector<char> ok (batch);
+        size_t j = 0;                       // next mark
+        while (j < marks.size()) {
+            idx.clear();
+            for (; j < marks.size() && idx.size() < batch; j++)
+                if (marks[j].block)
+                    idx.push_back(j);
+            pool.run(idx.size(), [&](size_t b, unsigned t) {
+                const size_t k = idx[b];
+                const uint64_t stop = k + 1 < marks.size() ? marks[k+1].bit : 8 * uint64_t(n);
+                ok[b] = decode(data, n, marks[k].bit, stop, out[b], stream[t]);
+            });
+            uint64_t skip = 0;              // blocks below were merged into previous
+            for (size_t b = 0; b < idx.size(); b++) {
+                const size_t k = idx[b];
+                if (marks[k].bit < skip)
+                    continue;
+                size_t e = k + 1;
+                while (!ok[b]) {            // false magic: extend to the next one
+                    if (++e > marks.size())
+                        throw std::runtime_error(
+                            "bzip2: corrupt block at bit " + std::to_string(marks[k].bit));
+                    const uint64_t stop = e < marks.size() ? marks[e].bit : 8 * uint64_t(n);
+                    ok[b] = decode(data, n, marks[k].bit, stop, out[b], stream[0]);
+                }
+                skip = e < marks.size() ? marks[e].bit : 8 * uint64_t(n);
+                j = std::max(j, e);         // merged beyond this batch?
+                consume(static_cast<const char *>(out[b].data()), out[b].size());
+            }
+        }
+    }
+
+private:
+    MappedFile file;
+    ThreadPool pool;
+    std::vector<bz2blocks::Mark> marks;
+    size_t nblocks = 0;
+};
@@ -30,13 +30,19 @@ static const bool DEBUG = DEBUG_CLIP;
     if `slope` is too close to zero (i.e. `EPS`) the division by `slope`
     might result in strange behavior.
     That is why a new `Event` is only added if `std::abs(slope) > EPS`.
+
+    If `compact` is set and the new event falls on the same position as
+    its neighbour in the queue, the slopes are summed up instead (and the
+    event is dropped if the sum is zero); like `compact_events`, this is
+    exact only up to rounding.
 */
 template<int step, bool need_check = false, typename float_ = double>
 inline float_
 clip(Event *elem,
      Range &pq,
      float_ slope,
-     float_ offset)
+     float_ offset,
+     const bool compact = false)
 {
     constexpr auto dir = step > 0 ? "f" : "b";
     if (DEBUG) {
@@ -53,6 +59,16 @@ clip(Event *elem,
             -std::numeric_limits<float_>::infinity() :
             +std::numeric_limits<float_>::infinity();
     const auto x = -offset/slope;
+    if (compact && pq) {
+        Event &e = elem[step > 0 ? pq.start : pq.stop];
+        if (e.x == x) {
+            e.slope += slope;
+            if (e.slope == 0)
+                step > 0 ? pq.start++ : pq.stop--;
+            DEBUG && printf("  ip_%s: (%+g, %+.2f) compact\n", dir, slope, offset);
+            return x;
+        }
+    }
     elem[step > 0 ? --pq.start : ++pq.stop] = Event({x, slope});
     DEBUG && printf("  ip_%s: (%+g, %+.2f)\n", dir, slope, offset);
     return x;
@@ -64,9 +80,10 @@ inline float_
 clip(std::vector<Event> &elem,
      Range &pq,
      float_ slope,
-     float_ offset)
+     float_ offset,
+     const bool compact = false)
 {
-    return clip<step, need_check, float_>(elem.data(), pq, slope, offset);
+    return clip<step, need_check, float_>(elem.data(), pq, slope, offset, compact);
 }
 
 
@@ -0,0 +1,121 @@
+/**
+   Parallel connected components (lock-free union-find) and induced
+   subgraphs of graphs given as edge lists (`head`, `tail`).
+ */
+#pragma once
+#include <algorithm>        // std::max
+#include <atomic>
+#include <utility>          // std::swap
+#include <vector>
+
+#include "parallel.hpp"
+
+
+/**
+   Label every node with the smallest node of its component.
+
+   The edges are united in parallel; roots are only linked from a larger
+   to a smaller index (compare-and-swap), so the result does not depend
+   on the order of the unions.
+ */
+template <typename int_t = int>
+std::vector<int_t>
+connected_labels(
+    const size_t n,
+    const size_t m,
+    const int_t *head,
+    const int_t *tail,
+    const unsigned threads = default_threads())
+{
+    std::vector<std::atomic<int_t>> link (n);
+    parallel_for(n, threads, [&](size_t v) {
+        link[v].store(int_t(v), std::memory_order_relaxed);
+    });
+    const auto find = [&link](int_t v) {
+        while (true) {
+            int_t p = link[v].load(std::memory_order_relaxed);
+            if (p == v)
+                return v;
+            const int_t g = link[p].load(std::memory_order_relaxed);
+            if (g != p)                 // path halving
+                link[v].compare_exchange_weak(p, g, std::memory_order_relaxed);
+            v = g;
+        }
+    };
+    parallel_for(m, threads, [&](size_t e) {
+        int_t u = find(head[e]), v = find(tail[e]);
+        while (u != v) {
+            if (u < v)
+                std::swap(u, v);
+            int_t expected = u;
+            if (link[u].compare_exchange_strong(expected, v, std::memory_order_relaxed))
+                break;
+            u = find(expected);
+            v = find(v);
+        }
+    });
+    std::vector<int_t> label (n);
+    parallel_for(n, threads, [&](size_t v) { label[v] = find(int_t(v)); });
+    return label;
+}
+
+
+/** The (sorted) nodes of the largest component; ties: smallest label */
+template <typename int_t = int>
+std::vector<int_t>
+largest_component(const std::vector<int_t> &label)
+{
+    const size_t n = label.size();
+    std::vector<int_t> size (n, 0);
+    for (const auto l : label)
+        size[l]++;
+    int_t best = 0;
+    for (size_t v = 0; v < n; v++)
+        if (size[v] > size[best])
+            best = int_t(v);
+    std::vector<int_t> nodes;
+    nodes.reserve(n > 0 ? size_t(size[best]) : 0);
+    for (size_t v = 0; v < n; v++)
+        if (label[v] == best)
+            nodes.push_back(int_t(v));
+    return nodes;
+}
+
+
+/**
+   Restrict the edges to the sorted `nodes` and renumber them accordingly
+   (node `nodes[i]` becomes `i`); keeps the order of the edges.
+ */
+template <typename int_t = int>
+void
+induced_edges(
+    const size_t n,
+    const std::vector<int_t> &nodes,
+    std::vector<int_t> &head,
+    std::vector<int_t> &tail,
+    const unsigned threads = default_threads())
+{
+    std::vector<int_t> id (n, int_t(-1));
+    parallel_for(nodes.size(), threads, [&](size_t i) { id[nodes[i]] = int_t(i); });
+    const size_t m = head.size();
+    const unsigned parts = std::max(1u, std::min<unsigned>(threads, unsigned(m / 4096 + 1)));
+    std::vector<size_t> count (parts + 1, 0);
+    parallel_blocks(m, parts, [&](size_t begin, size_t end, unsigned t) {
+        for (size_t e = begin; e < end; e++)
+            count[t+1] += id[head[e]] >= 0 && id[tail[e]] >= 0;
+    });
+    for (unsigned t = 0; t < parts; t++)
+        count[t+1] += count[t];
+    std::vector<int_t> h (count[parts]), tl (count[parts]);
+    parallel_blocks(m, parts, [&](size_t begin, size_t end, unsigned t) {
+        size_t k = count[t];
+        for (size_t e = begin; e < end; e++) {
+            if (id[head[e]] >= 0 && id[tail[e]] >= 0) {
+                h[k] = id[head[e]];
+                tl[k++] = id[tail[e]];
+            }
+        }
+    });
+    head.swap(h);
+    tail.swap(tl);
+}
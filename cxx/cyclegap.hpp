@@ -0,0 +1,200 @@
+/**
+   Variant of the iterated gap trees (cf. julia/src/cyclegap.jl):
+   Instead of only pushing the flow of the non-tree edges into `y_tree`,
+   their capacities are rotated along their fundamental cycles w.r.t. the
+   current spanning tree, i.e. every tree edge on the cycle of a non-tree
+   edge `e` is enlarged by `lam[e]`.
+   Afterwards, the tree duals are clipped to the original capacities.
+
+   *Experimental*
+ */
+#pragma once
+#include <cmath>            // std::abs
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/idx/children.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/std/stack.hpp>
+
+#include "gaplas.hpp"
+
+
+template <typename float_t = double, typename int_t = int>
+struct CycleGap : public GapMem<float_t, int_t>
+{
+    using Base = GapMem<float_t, int_t>;
+
+    std::vector<int_t> lca;                 // root of cycle, per non-tree edge
+    std::vector<int_t> order;               // post order of current tree
+    std::vector<float_t> tlam0, tlam;       // original and rotated capacities
+
+    CycleGap(float_t *x, const float_t *y, size_t n, size_t m, int_t root = 0);
+
+    /** Compute `order` and the lowest common ancestor for every non-tree
+        edge in the current tree (`parent`) by Tarjan's offline algorithm. */
+    template <typename Graph>
+    void cycle_basis(const Graph &graph);
+
+    /** Rotate capacities: `tlam[v]` is the capacity of the edge to
+        `parent[v]` plus the capacities of all cycles containing it. */
+    template <typename Graph, typename L>
+    void rotate(const Graph &graph, const L &lam);
+
+    /** Clip the tree duals to the original capacities `tlam0` and
+        move the difference into `x`. */
+    void fix_alpha();
+
+    template <typename Queue, typename Graph, typename L, typename M>
+    void next(const Graph &graph, L &dummy, const L &lam, const M &mu);
+
+private:
+    ChildrenIndex childs;
+    stack<int_t> dfs_stack;
+    std::vector<int_t> uf;
+    std::vector<char> done;
+    std::vector<double> ldiff;
+};
+
+
+template <typename float_t, typename int_t>
+CycleGap<float_t, int_t>::CycleGap(
+    float_t *x, const float_t *y, size_t n, size_t m, int_t root)
+    : Base(x, y, n, m, root), childs(n)
+{
+    lca.resize(m);
+    order.reserve(n);
+    tlam0.resize(n);
+    tlam.resize(n);
+    dfs_stack.reserve(n);
+    uf.resize(n);
+    done.resize(n);
+    ldiff.resize(n);
+}
+
+
+template <typename float_t, typename int_t>
+template <typename Graph>
+void
+CycleGap<float_t, int_t>::cycle_basis(const Graph &graph)
+{
+    const auto &parent = this->parent;
+    const auto &tree_edge = this->tree_edge;
+    const auto n = this->n;
+    const auto root = this->root;
+    childs.reset(n, parent.data(), root);
+    order.clear();
+    dfs_stack.clear();
+    dfs_stack.push_back(root);
+    while (!dfs_stack.empty()) {
+        const auto v = dfs_stack.back();
+        dfs_stack.pop_back();
+        if (v >= 0) {
+            dfs_stack.push_back(-v - 1);
+            for (const auto c : childs[v])
+                dfs_stack.push_back(c);
+        } else {
+            order.push_back(-v - 1);
+        }
+    }
+
+    // every finished node is linked to its parent, i.e. the representative
+    // of a finished node is its lowest ancestor still on the DFS path
+    const auto find = [this](int_t v) {
+        int_t r = v;
+        while (uf[r] != r)
+            r = uf[r];
+        while (uf[v] != r) {
+            const auto next = uf[v];
+            uf[v] = r;
+            v = next;
+        }
+        return r;
+    };
+    for (size_t v = 0; v < n; v++) {
+        uf[v] = int_t(v);
+        done[v] = 0;
+    }
+    for (const auto v : order) {
+        for (const auto &ue : graph[v]) {
+            const auto u = ue.first, e = ue.second;
+            if (done[u] && tree_edge[u] != e && tree_edge[v] != e)
+                lca[e] = find(u);
+        }
+        done[v] = 1;
+        uf[v] = parent[v];
+    }
+}
+
+
+template <typename float_t, typename int_t>
+template <typename Graph, typename L>
+void
+CycleGap<float_t, int_t>::rotate(const Graph &graph, const L &lam)
+{
+    const auto &parent = this->parent;
+    const auto &tree_edge = this->tree_edge;
+    for (size_t v = 0; v < this->n; v++) {
+        tlam0[v] = tree_edge[v] < 0 ? float_t(0) : float_t(lam[tree_edge[v]]);
+        ldiff[v] = 0.0;
+    }
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
+        if (u < v && tree_edge[u] != e && tree_edge[v] != e) {
+            ldiff[u] += lam[e];
+            ldiff[v] += lam[e];
+            ldiff[lca[e]] -= 2 * lam[e];
+        }
+    });
+    for (const auto v : order) {
+        tlam[v] = float_t(tlam0[v] + ldiff[v]);
+        if (parent[v] != v)
+            ldiff[parent[v]] += ldiff[v];
+    }
+}
+
+
+template <typename float_t, typename int_t>
+void
+CycleGap<float_t, int_t>::fix_alpha()
+{
+    auto *x = this->x;
+    auto &alpha_tree = this->alpha_tree;
+    const auto &parent = this->parent;
+    for (size_t i = 0; i < this->n; i++) {
+        if (parent[i] == int_t(i))
+            continue;
+        const auto ai = alpha_tree[i];
+        if (std::abs(ai) > tlam0[i]) {
+            alpha_tree[i] = ai > 0 ? tlam0[i] : -tlam0[i];
+            const auto diff = alpha_tree[i] - ai;
+            x[i] += diff;
+            x[parent[i]] -= diff;
+        }
+    }
+}
+
+
+template <typename float_t, typename int_t>
+template <typename Queue, typename Graph, typename L, typename M>
+void
+CycleGap<float_t, int_t>::next(const Graph &graph, L &dummy, const L &lam, const M &mu)
+{
+    this->template find_tree<Queue>(graph, dummy, lam);
+    cycle_basis(graph);
+    rotate(graph, lam);
+    this->tree_opt(tlam, mu);
+    tree_dual(
+        this->n,
+        this->alpha_tree.data(),
+        this->x,
+        this->y_tree.data(),
+        this->parent.data(),
+        this->mem_tree.proc_order.data());
+    fix_alpha();
+    for (size_t v = 0; v < this->n; v++) {
+        const auto p = this->parent[v], e = this->tree_edge[v];
+        if (e >= 0)
+            this->alpha[e] = int_t(v) < p ? this->alpha_tree[v] : -this->alpha_tree[v];
+    }
+    this->gap_vec(graph, lam);
+}
@@ -0,0 +1,370 @@
+/**
+   Multi-threaded parsing of edge lists in DIMACS10 (METIS) and SNAP
+   format from memory (e.g. a memory-mapped file or decompressed chunks).
+
+   The input is split at line boundaries into one part per thread.  Every
+   part is parsed into its own arrays which are then copied together in
+   order, so the result does not depend on the number of threads.
+   Integers are scanned 16 bytes at a time (SSE2) and converted with
+   multiply-adds on the digits (SSSE3), if available.
+ */
+#pragma once
+#include <algorithm>        // std::copy
+#include <cstdint>
+#include <cstring>          // std::memchr
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#  include <tmmintrin.h>
+#endif
+
+#include "parallel.hpp"
+
+
+namespace edgeparse {
+
+inline bool
+is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+
+inline const char*
+skip_blanks(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+
+#ifdef __SSSE3__
+/** Value of the `len <= 8` digits at `p` (only `p[0..len)` are used) */
+inline uint32_t
+simd_digits(const char *p, const int len)
+{
+    // shuffle masks: right-align the `len` digits in the lower 8 bytes
+    alignas(16) static const struct Masks
+    {
+        int8_t m[9][16];
+        Masks()
+        {
+            for (int l = 0; l <= 8; l++)
+                for (int j = 0; j < 16; j++)
+                    m[l][j] = (j < 8 && j >= 8 - l) ? int8_t(j - (8 - l)) : int8_t(-128);
+        }
+    } masks;
+    __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    c = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    c = _mm_shuffle_epi8(c, _mm_load_si128(reinterpret_cast<const __m128i *>(masks.m[len])));
+    const __m128i d2 =
+        _mm_maddubs_epi16(c, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m128i d4 = _mm_madd_epi16(d2, _mm_setr_epi16(100, 1, 100, 1, 0, 0, 0, 0));
+    const uint64_t r = uint64_t(_mm_cvtsi128_si64(d4));
+    return uint32_t(r) * 10000 + uint32_t(r >> 32);
+}
+#endif
+
+
+/**
+   Parse the unsigned integer at `p` and advance `p` behind it.
+   `end` is the end of the readable memory (not necessarily of the line).
+   Return false if there is no digit at `p`.
+ */
+inline bool
+parse_uint(const char *&p, const char *end, uint64_t &value)
+{
+#ifdef __SSE2__
+    if (end - p >= 16) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                            _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+        const unsigned mask = unsigned(_mm_movemask_epi8(digit));
+        const int len = __builtin_ctz(~mask);      // ~mask has bit 16 set
+        if (len == 0)
+            return false;
+        if (len > 16 - 1)
+            throw std::runtime_error("Integer too long: " + std::string(p, 16));
+#  ifdef __SSSE3__
+        value = len <= 8 ? simd_digits(p, len)
+                         : uint64_t(simd_digits(p, len - 8)) * 100000000 +
+                               simd_digits(p + len - 8, 8);
+#  else
+        value = 0;
+        for (int i = 0; i < len; i++)
+            value = 10 * value + uint64_t(p[i] - '0');
+#  endif
+        p += len;
+        return true;
+    }
+#endif
+    if (p >= end || !is_digit(*p))
+        return false;
+    value = 0;
+    while (p < end && is_digit(*p))
+        value = 10 * value + uint64_t(*p++ - '0');
+    return true;
+}
+
+
+inline const char*
+line_end(const char *p, const char *end)
+{
+    const void *nl = std::memchr(p, '\n', size_t(end - p));
+    return nl ? static_cast<const char *>(nl) : end;
+}
+
+}   // namespace edgeparse
+
+
+enum class EdgeFormat
+{
+    DIMACS10,           // header "n m [fmt [ncon]]", line i: neighbours of i
+    SNAP,               // "u v" per line, '#' comments
+};
+
+
+/**
+   Collect the edges of a graph from consecutive chunks of its text
+   (`feed`); lines may be split across chunks.  DIMACS10 vertices are
+   1-based and every edge is stored once (`head < tail`); SNAP edges are
+   stored as given (0-based).
+ */
+class EdgeParser
+{
+public:
+    EdgeParser(const EdgeFormat format, const unsigned threads = default_threads())
+        : format(format), pool(threads)
+    {
+    }
+
+    std::vector<int> head, tail;
+
+    /** Number of vertices (DIMACS10: from the header; SNAP: max. id + 1) */
+    size_t num_nodes() const { return n; }
+
+    /** Number of bytes fed so far */
+    size_t bytes() const { return nbytes; }
+
+    void feed(const char *begin, const char *end)
+    {
+        nbytes += size_t(end - begin);
+        if (!carry.empty()) {          // complete the last line of the previous chunk
+            const char *nl = edgeparse::line_end(begin, end);
+            if (nl == end) {
+                carry.append(begin, end);
+                return;
+            }
+            carry.append(begin, nl + 1);
+            begin = nl + 1;
+            parse_complete(carry.data(), carry.data() + carry.size());
+            carry.clear();
+        }
+        const char *last = end;
+        while (last > begin && last[-1] != '\n')
+            last--;
+        parse_complete(begin, last);
+        carry.assign(last, end);
+    }
+
+    /** Parse the last line (if not terminated by '\n') */
+    void finish()
+    {
+        if (!carry.empty()) {
+            carry.push_back('\n');
+            parse_complete(carry.data(), carry.data() + carry.size());
+            carry.clear();
+        }
+        if (format == EdgeFormat::DIMACS10 && !header)
+            throw std::runtime_error("DIMACS10: no header");
+    }
+
+private:
+    struct Part
+    {
+        const char *begin, *end;
+        size_t lines = 0;           // DIMACS10: vertex lines
+        size_t max_node = 0;        // SNAP: max. id + 1
+        std::vector<int> head, tail;
+        std::string error;
+    };
+
+    /** Parse `[begin, end)` which consists of complete lines */
+    void parse_complete(const char *begin, const char *end)
+    {
+        if (format == EdgeFormat::DIMACS10 && !header)
+            begin = parse_header(begin, end);
+        if (begin >= end)
+            return;
+
+        // split at line boundaries; small inputs are not split
+        const size_t min_part = size_t(1) << 16;
+        const size_t nparts =
+            std::max<size_t>(1, std::min<size_t>(pool.size(), size_t(end - begin) / min_part));
+        std::vector<Part> parts(nparts);
+        const char *p = begin;
+        for (size_t i = 0; i < nparts; i++) {
+            parts[i].begin = p;
+            const char *q = begin + (i + 1) * size_t(end - begin) / nparts;
+            if (i + 1 == nparts || q <= p)
+                q = end;
+            else
+                q = std::min(end, edgeparse::line_end(q, end) + 1);
+            parts[i].end = p = q;
+        }
+
+        if (format == EdgeFormat::DIMACS10) {
+            pool.run(nparts, [&](size_t i, unsigned) { count_lines(parts[i]); });
+            size_t first = vertex;
+            for (auto &part : parts) {
+                const size_t lines = part.lines;
+                part.lines = first;
+                first += lines;
+            }
+            vertex = first;
+            pool.run(nparts, [&](size_t i, unsigned) { parse_dimacs10(parts[i], end); });
+        } else {
+            pool.run(nparts, [&](size_t i, unsigned) { parse_snap(parts[i], end); });
+        }
+
+        size_t m = head.size();
+        std::vector<size_t> offset(nparts);
+        for (size_t i = 0; i < nparts; i++) {
+            if (!parts[i].error.empty())
+                throw std::runtime_error(parts[i].error);
+            offset[i] = m;
+            m += parts[i].head.size();
+            n = std::max(n, parts[i].max_node);
+        }
+        head.resize(m);
+        tail.resize(m);
+        pool.run(nparts, [&](size_t i, unsigned) {
+            std::copy(parts[i].head.begin(), parts[i].head.end(), head.begin() + offset[i]);
+            std::copy(parts[i].tail.begin(), parts[i].tail.end(), tail.begin() + offset[i]);
+        });
+    }
+
+    const char* parse_header(const char *p, const char *end)
+    {
+        using namespace edgeparse;
+        while (p < end && !header) {
+            const char *e = line_end(p, end);
+            if (*p != '%') {
+                uint64_t v[4] = {0, 0, 0, 0};
+                int k = 0;
+                const char *q = skip_blanks(p, e);
+                while (k < 4 && parse_uint(q, end, v[k]))
+                    q = skip_blanks(q, e), k++;
+                if (k < 2 || q != e)
+                    throw std::runtime_error("DIMACS10: invalid header \"" +
+                                             std::string(p, e) + "\"");
+                if (v[0] > uint64_t(std::numeric_limits<int>::max()))
+                    throw std::runtime_error("DIMACS10: n too large");
+                n = size_t(v[0]);
+                head.reserve(size_t(v[1]));
+                tail.reserve(size_t(v[1]));
+                const unsigned fmt = unsigned(v[2]);
+                vsize = fmt / 100 % 10 != 0;
+                ncon = fmt / 10 % 10 != 0 ? (k > 3 ? unsigned(v[3]) : 1u) : 0u;
+                eweight = fmt % 10 != 0;
+                header = true;
+            }
+            p = e < end ? e + 1 : end;
+        }
+        return p;
+    }
+
+    void count_lines(Part &part) const
+    {
+        size_t lines = 0;
+        for (const char *p = part.begin; p < part.end; ) {
+            if (*p != '%')
+                lines++;
+            p = edgeparse::line_end(p, part.end) + 1;
+        }
+        part.lines = lines;
+    }
+
+    void parse_dimacs10(Part &part, const char *end) const
+    {
+        using namespace edgeparse;
+        size_t u = part.lines;
+        const unsigned skip = (vsize ? 1 : 0) + ncon;
+        for (const char *p = part.begin; p < part.end; ) {
+            const char *e = line_end(p, part.end);
+            if (*p != '%') {
+                if (u >= n) {
+                    if (skip_blanks(p, e) == e) {     // trailing empty lines
+                        p = e + 1;
+                        continue;
+                    }
+                    part.error = "DIMACS10: more than n = " + std::to_string(n) +
+                        " vertex lines";
+                    return;
+                }
+                const char *q = skip_blanks(p, e);
+                uint64_t v;
+                for (unsigned k = 0; q < e; k++) {
+                    if (!parse_uint(q, end, v)) {
+                        part.error = "DIMACS10: invalid line " + std::to_string(u + 1) +
+                            ": \"" + std::string(p, e) + "\"";
+                        return;
+                    }
+                    q = skip_blanks(q, e);
+                    if (k < skip || (eweight && (k - skip) % 2 == 1))
+                        continue;
+                    if (v == 0 || v > n) {
+                        part.error = "DIMACS10: vertex " + std::to_string(v) +
+                            " out of range in line " + std::to_string(u + 1);
+                        return;
+                    }
+                    if (u < v - 1) {
+                        part.head.push_back(int(u));
+                        part.tail.push_back(int(v - 1));
+                    }
+                }
+                u++;
+            }
+            p = e + 1;
+        }
+    }
+
+    void parse_snap(Part &part, const char *end) const
+    {
+        using namespace edgeparse;
+        const uint64_t max_id = uint64_t(std::numeric_limits<int>::max());
+        for (const char *p = part.begin; p < part.end; ) {
+            const char *e = line_end(p, part.end);
+            const char *q = skip_blanks(p, e);
+            if (q < e && *q != '#') {
+                uint64_t u, v;
+                const bool ok = parse_uint(q, end, u) &&
+                    (q = skip_blanks(q, e), parse_uint(q, end, v)) &&
+                    skip_blanks(q, e) == e;
+                if (!ok || u > max_id || v > max_id) {
+                    part.error = "SNAP: invalid line \"" + std::string(p, e) + "\"";
+                    return;
+                }
+                part.head.push_back(int(u));
+                part.tail.push_back(int(v));
+                part.max_node = std::max<size_t>(part.max_node, std::max(u, v) + 1);
+            }
+            p = e + 1;
+        }
+    }
+
+    const EdgeFormat format;
+    ThreadPool pool;
+    std::string carry;              // incomplete last line
+    size_t nbytes = 0, n = 0;
+    size_t vertex = 0;              // DIMACS10: next vertex line
+    bool header = false, vsize = false, eweight = false;
+    unsigned ncon = 0;
+};
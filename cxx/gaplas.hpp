@@ -4,10 +4,30 @@
 #include <graphidx/edges.hpp>
 #include <graphidx/idx/incidence.hpp>
 #include <graphidx/spanning/prim_mst.hpp>
+#include <chrono>
+#include <cmath>            // std::abs
+#include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>          // std::swap
+#include <vector>
 
+#include "boruvka.hpp"
+#include "sigint.hpp"
 #include "tree_dp.hpp"
+#include "tree_dual_par.hpp"
+
+
+/** Progress of `gaplas`: entry `k` refers to the state after `k` iterations */
+struct GapResult
+{
+    std::vector<double> obj, gap, time;     // primal objective, gap, seconds
+    bool converged = false;                 // relative gap below `GapMem::tol`
+    bool cancelled = false;                 // stopped by `GapMem::cancel`
+
+    size_t iterations() const { return obj.empty() ? 0 : obj.size() - 1; }
+};
 
 
 template <typename float_t = double, typename int_t = int>
@@ -22,7 +42,22 @@ struct GapMem
     std::vector<float_t> alpha, gamma;
     std::vector<float_t> y_tree, alpha_tree;
     std::vector<int_t> parent;
+    std::vector<int_t> tree_edge;           // edge between i and parent[i]
     TreeDPStatus mem_tree;
+    BoruvkaMST<int_t> mst;
+    unsigned threads = default_threads();
+    size_t par_tree_min = 1 << 16;          // tree_opt(), update_duals(): parallel
+
+    bool incremental = false;               // next(): update_tree if possible
+    size_t max_cycle = 64;                  // update_tree(): max cycle length
+    size_t swapped = 0;                     // update_tree(): last swap count
+
+    double tol = 0.0;                       // gaplas(): stop if gap <= tol*obj
+    double max_time = std::numeric_limits<double>::infinity(); // seconds
+    const Cancel *cancel = nullptr;         // gaplas(): polled every iteration
+
+    double learn = 1.0;                     // momentum(): weight of new iterate
+    double mass = 0.95;                     // momentum(): weight of x1 vs. x2
 
     GapMem() = delete;
 
@@ -30,25 +65,49 @@ struct GapMem
 
     void init();
 
-    template <typename L>
-    void gap_vec(const IncidenceIndex<int_t> &graph, const L &lam);
+    template <typename Graph, typename L>
+    void gap_vec(const Graph &graph, const L &lam);
 
-    template <typename Queue, typename L>
-    void find_tree(const IncidenceIndex<int_t> &graph, L &tlam, const L &lam);
+    /** Minimum spanning tree regarding `gamma`; `Queue` is either the heap
+        used in Prim's algorithm or `Boruvka` (parallel, no dependencies). */
+    template <typename Queue, typename Graph, typename L>
+    void find_tree(const Graph &graph, L &tlam, const L &lam);
 
-    void update_duals(const IncidenceIndex<int_t> &graph);
+    /** Instead of recomputing the tree: exchange every non-tree edge with
+        the heaviest tree edge on its cycle (of length at most `max_cycle`)
+        if it is lighter.  Return the number of swapped edges. */
+    template <typename Graph, typename L>
+    size_t update_tree(const Graph &graph, L &tlam, const L &lam);
+
+    template <typename Graph>
+    void update_duals(const Graph &graph);
+
+    /** Combine the new iterate with the previous two (if `learn < 1`):
+        `x = η x + ζ x1 + ι x2` with `η = learn`, `ζ = (1 - η) mass` and
+        `ι = (1 - η) (1 - mass)`; the same for `alpha` (cf. momentum.jl). */
+    template <typename Graph>
+    void momentum(const Graph &graph);
 
     template <typename L, typename M>
     void tree_opt(const L &tree_lam, const M &mu);
 
-    template <typename Queue, typename L, typename M>
-    void next(const IncidenceIndex<int_t> &graph, L &tlam, const L &lam, const M &mu);
+    /** One iteration; afterwards `gamma` corresponds to the new `x`, `alpha` */
+    template <typename Queue, typename Graph, typename L, typename M>
+    void next(const Graph &graph, L &tlam, const L &lam, const M &mu);
 
-    template <typename L, typename M>
-    double
-    primal_obj(const IncidenceIndex<int_t> &idx, const L &lam, const M &mu) const;
+    template <typename Graph, typename L, typename M>
+    double primal_obj(const Graph &graph, const L &lam, const M &mu) const;
 
     double gap_obj() const;
+
+private:
+    bool has_tree = false;
+    size_t stamp = 0;
+    std::vector<size_t> mark;
+    std::vector<float_t> x1, x2, alpha1, alpha2;  // previous iterates
+    std::vector<double> prefix;                   // update_duals()
+
+    bool par_tree() const { return threads > 1 && n >= par_tree_min; }
 };
 
 
@@ -64,17 +123,16 @@ GapMem<float_t, int_t>::gap_obj() const
 
 
 template <typename float_t, typename int_t>
-template <typename L, typename M>
+template <typename Graph, typename L, typename M>
 double
-GapMem<float_t, int_t>::primal_obj(
-    const IncidenceIndex<int_t> &idx, const L &lam, const M &mu) const
+GapMem<float_t, int_t>::primal_obj(const Graph &graph, const L &lam, const M &mu) const
 {
     double sum = 0;
     for (size_t i = 0; i < n; i++) {
         const auto diff = double(x[i]) - double(y[i]);
         sum += mu[i] * diff * diff;
     }
-    edges<int_t>(idx, [&](int_t u, int_t v, int_t e) {
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
         sum += u < v ? lam[e] * std::abs(double(x[u]) - double(x[v])) : 0.0;
     });
     return sum;
@@ -82,15 +140,25 @@ GapMem<float_t, int_t>::primal_obj(
 
 
 template <typename float_t, typename int_t>
-template <typename Queue, typename L, typename M>
+template <typename Queue, typename Graph, typename L, typename M>
 void
-GapMem<float_t, int_t>::next(
-    const IncidenceIndex<int_t> &graph, L &tlam, const L &lam, const M &mu)
+GapMem<float_t, int_t>::next(const Graph &graph, L &tlam, const L &lam, const M &mu)
 {
-    gap_vec(graph, lam);
-    find_tree<Queue>(graph, tlam, lam);
+    if (learn < 1.0) {
+        std::swap(x1, x2);
+        std::swap(alpha1, alpha2);
+        x1.assign(x, x + n);
+        alpha1 = alpha;
+    }
+    if (incremental && has_tree)
+        swapped = update_tree(graph, tlam, lam);
+    else
+        find_tree<Queue>(graph, tlam, lam);
     tree_opt(tlam, mu);
     update_duals(graph);
+    if (learn < 1.0)
+        momentum(graph);
+    gap_vec(graph, lam);
 }
 
 
@@ -128,23 +196,33 @@ GapMem<float_t, int_t>::tree_opt(const L &tree_lam, const M &mu)
 {
     TimerQuiet _;
     constexpr bool merge_sort = false, lazy_sort = false;
+    mem_tree.threads = par_tree() ? threads : 1;
+    mem_tree.subtree_first.resize(par_tree() ? n : 0);
     tree_dp<merge_sort, lazy_sort>(
         n, x, y_tree.data(), parent.data(), tree_lam, mu, root, mem_tree);
 }
 
 
 template <typename float_t, typename int_t>
+template <typename Graph>
 void
-GapMem<float_t, int_t>::update_duals(const IncidenceIndex<int_t> &graph)
+GapMem<float_t, int_t>::update_duals(const Graph &graph)
 {
-    tree_dual(
-        n,
-        alpha_tree.data(),
-        x,
-        y_tree.data(),
-        parent.data(),
-        mem_tree.proc_order.data());
-    edges<int>(graph, [&](int_t u, int_t v, int_t e) {
+    if (par_tree()) {
+        parallel_for(n, threads, [&](size_t i) { alpha_tree[i] = x[i] - y_tree[i]; });
+        tree_dual_par(n, alpha_tree.data(), alpha_tree.data(),
+                      mem_tree.proc_order.data(), mem_tree.subtree_first.data(),
+                      int(root), prefix, threads);
+    } else {
+        tree_dual(
+            n,
+            alpha_tree.data(),
+            x,
+            y_tree.data(),
+            parent.data(),
+            mem_tree.proc_order.data());
+    }
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
         if (u < v) {
             if (parent[u] == v)
                 alpha[e] = alpha_tree[u];
@@ -155,6 +233,27 @@ GapMem<float_t, int_t>::update_duals(const IncidenceIndex<int_t> &graph)
 }
 
 
+template <typename float_t, typename int_t>
+template <typename Graph>
+void
+GapMem<float_t, int_t>::momentum(const Graph &graph)
+{
+    const double eta = learn, zeta = (1 - eta) * mass, iota = (1 - eta) * (1 - mass);
+    for (size_t i = 0; i < n; i++)
+        x[i] = float_t(eta * x[i] + zeta * x1[i] + iota * x2[i]);
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
+        if (u < v) {
+            const auto a = float_t(eta * alpha[e] + zeta * alpha1[e] + iota * alpha2[e]);
+            if (tree_edge[u] != e && tree_edge[v] != e) {
+                y_tree[u] += a - alpha[e];
+                y_tree[v] -= a - alpha[e];
+            }
+            alpha[e] = a;
+        }
+    });
+}
+
+
 template <typename float_t, typename int_t>
 GapMem<float_t, int_t>::GapMem(
     float_t *x, const float_t *y, size_t n, size_t m, int_t root)
@@ -165,6 +264,7 @@ GapMem<float_t, int_t>::GapMem(
     y_tree.resize(n);
     alpha_tree.resize(n);
     parent.resize(n);
+    tree_edge.resize(n);
 }
 
 
@@ -176,12 +276,17 @@ GapMem<float_t, int_t>::init()
         x[i] = y[i];
     for (size_t e = 0; e < m; e++)
         alpha[e] = 0.0;
+    has_tree = false;
+    if (learn < 1.0) {
+        x1.assign(x, x + n);
+        alpha1 = alpha;
+    }
 }
 
 template <typename float_t, typename int_t>
-template <typename L>
+template <typename Graph, typename L>
 void
-GapMem<float_t, int_t>::gap_vec(const IncidenceIndex<int_t> &graph, const L &lam)
+GapMem<float_t, int_t>::gap_vec(const Graph &graph, const L &lam)
 {
     // update gamma
     const auto c = -1;
@@ -206,55 +311,169 @@ GapMem<float_t, int_t>::gap_vec(const IncidenceIndex<int_t> &graph, const L &lam
 
 
 template <typename float_t, typename int_t>
-template <typename Queue, typename L>
+template <typename Queue, typename Graph, typename L>
 void
-GapMem<float_t, int_t>::find_tree(
-    const IncidenceIndex<int_t> &graph, L &tlam, const L &lam)
+GapMem<float_t, int_t>::find_tree(const Graph &graph, L &tlam, const L &lam)
 {
     // minimum spanning tree: update parent
-    prim_mst_edges<Queue>(parent.data(), gamma.data(), graph, root);
-    for (size_t i = 0; i < n; i++)
+    if constexpr (std::is_same<Queue, Boruvka>::value) {
+        if (mst.head.size() != m)
+            mst.reset(graph);
+        mst.mst(gamma.data(), threads);
+        mst.orient(parent.data(), root);
+    } else {
+        prim_mst_edges<Queue>(parent.data(), gamma.data(), graph, root);
+    }
+    for (size_t i = 0; i < n; i++) {
         y_tree[i] = y[i];
+        tree_edge[i] = int_t(-1);
+    }
     edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
         if (u < v) {
-            if (parent[u] == v)
+            if (parent[u] == v) {
                 tlam[u] = lam[e];
-            else if (parent[v] == u)
+                tree_edge[u] = e;
+            } else if (parent[v] == u) {
                 tlam[v] = lam[e];
-            else {
+                tree_edge[v] = e;
+            } else {
                 y_tree[u] += alpha[e];
                 y_tree[v] -= alpha[e];
             }
         }
     });
+    has_tree = true;
 }
 
 
-template <
-    typename Queue,
-    typename float_t = double,
-    typename int_t = int,
-    typename L,
-    typename M>
-double
+template <typename float_t, typename int_t>
+template <typename Graph, typename L>
+size_t
+GapMem<float_t, int_t>::update_tree(const Graph &graph, L &tlam, const L &lam)
+{
+    mark.resize(n, 0);
+    size_t swaps = 0;
+    edges<int_t>(graph, [&](const int_t u, const int_t v, const int_t e) {
+        if (!(u < v) || tree_edge[u] == e || tree_edge[v] == e)
+            return;
+
+        // lowest common ancestor: climb alternately from u and v
+        const size_t su = ++stamp, sv = ++stamp;
+        int_t a = u, b = v, lca = -1;
+        mark[a] = su;
+        mark[b] = sv;
+        for (size_t k = 0; k < max_cycle && lca < 0; k++) {
+            const bool a_up = parent[a] != a, b_up = parent[b] != b;
+            if (!a_up && !b_up)
+                break;
+            if (a_up) {
+                a = parent[a];
+                if (mark[a] == sv) {
+                    lca = a;
+                    break;
+                }
+                mark[a] = su;
+            }
+            if (b_up) {
+                b = parent[b];
+                if (mark[b] == su) {
+                    lca = b;
+                    break;
+                }
+                mark[b] = sv;
+            }
+        }
+        if (lca < 0)
+            return;
+
+        // heaviest tree edge on the cycle, represented by its child node c
+        int_t c = -1, c_side = -1;
+        for (const auto s : {u, v}) {
+            for (auto w = s; w != lca; w = parent[w]) {
+                if (c < 0 || gamma[tree_edge[w]] > gamma[tree_edge[c]]) {
+                    c = w;
+                    c_side = s;
+                }
+            }
+        }
+        if (c < 0 || !(gamma[e] < gamma[tree_edge[c]]))
+            return;
+
+        // f leaves, e enters the tree
+        const auto f = tree_edge[c];
+        const auto fu = std::min(c, parent[c]), fv = std::max(c, parent[c]);
+        y_tree[u] -= alpha[e];
+        y_tree[v] += alpha[e];
+        y_tree[fu] += alpha[f];
+        y_tree[fv] -= alpha[f];
+
+        // re-hang the subtree of c: reverse the path from c_side up to c
+        int_t prev = c_side == u ? v : u, prev_edge = e, w = c_side;
+        while (true) {
+            const auto next = parent[w], next_edge = tree_edge[w];
+            parent[w] = prev;
+            tree_edge[w] = prev_edge;
+            tlam[w] = lam[prev_edge];
+            if (w == c)
+                break;
+            prev = w;
+            prev_edge = next_edge;
+            w = next;
+        }
+        swaps++;
+    });
+    return swaps;
+}
+
+
+/**
+   Iterate until the relative duality gap is at most `mem.tol`, the time
+   budget `mem.max_time` (seconds) is exceeded, `mem.cancel` stops or
+   `max_iter` is reached; `x` and `alpha` are the last iterate then.
+   `Mem` is `GapMem` or a variant thereof (e.g. `CycleGap`);
+   `Graph` is an `IncidenceIndex` or an implicit graph like `GridIndex`.
+ */
+template <typename Queue, typename Mem, typename Graph, typename L, typename M>
+GapResult
 gaplas(
-    GapMem<float_t, int_t> &mem,
-    const IncidenceIndex<int_t> &graph,
+    Mem &mem,
+    const Graph &graph,
     const L &lam,
-    const size_t max_iter = 10,
-    const bool verbose = true,
-    const M &mu = Ones<float_t>())
+    const size_t max_iter,
+    const bool verbose,
+    const M &mu)
 {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    GapResult res;
     L tlam(lam);
     mem.init();
     mem.gap_vec(graph, lam);
-    for (size_t it = 0; it < max_iter; it++) {
-        if (verbose)
-            std::cout << it << '\t' << mem.primal_obj(graph, lam, mu) << '\t'
-                      << mem.gap_obj() << std::endl;
+    for (size_t it = 0; true; it++) {
+        const double obj = mem.primal_obj(graph, lam, mu), gap = mem.gap_obj();
+        const double secs = std::chrono::duration<double>(clock::now() - start).count();
+        res.obj.push_back(obj);
+        res.gap.push_back(gap);
+        res.time.push_back(secs);
+        if (verbose) {
+            std::cout << it << '\t' << obj << '\t' << gap << '\t' << secs;
+            if (mem.incremental && it > 1)
+                std::cout << '\t' << mem.swapped << " swapped";
+            std::cout << std::endl;
+        }
+        if (gap <= mem.tol * std::abs(obj)) {
+            res.converged = true;
+            break;
+        }
+        if (mem.cancel && mem.cancel->stop()) {
+            res.cancelled = true;
+            break;
+        }
+        if (it >= max_iter || secs >= mem.max_time)
+            break;
         mem.template next<Queue>(graph, tlam, lam, mu);
     }
-    return -1; // TODO: return runtime
+    return res;
 }
 
 
@@ -264,7 +483,7 @@ template <
     typename int_t = int,
     typename L,
     typename M>
-double
+GapResult
 gaplas(
     float_t *x,
     const float_t *y,
@@ -281,7 +500,7 @@ gaplas(
 
 
 template <typename Queue, typename float_t = double, typename int_t, typename L>
-double
+GapResult
 gaplas(
     float_t *x,
     const float_t *y,
@@ -0,0 +1,95 @@
+/**
+   Grid graph whose neighbors and edge indices are computed on the fly,
+   i.e. without any stored edge list or incidence index.
+
+   Node `u = i + j*n1` has coordinates `(i, j)` where `i < n1` runs along
+   the contiguous axis (for a C-order array with dimensions `{n2, n1}`).
+   The edges are numbered in node order, first along `i`, then along `j`:
+
+       e = j*(n1-1) + i            for (u, u + 1),   i < n1 - 1
+       e = (n1-1)*n2 + u           for (u, u + n1),  j < n2 - 1
+
+   so that `edges(...)` accesses node arrays sequentially.
+ */
+#pragma once
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>          // std::pair
+
+
+template <typename int_t = int>
+struct GridIndex
+{
+    /** Neighbors of one node as (neighbor, edge) pairs, like `IncidenceIndex` */
+    struct Neighbors
+    {
+        std::array<std::pair<int_t, int_t>, 4> nb;
+        size_t len = 0;
+
+        const std::pair<int_t, int_t> *begin() const { return nb.data(); }
+        const std::pair<int_t, int_t> *end() const { return nb.data() + len; }
+        size_t size() const { return len; }
+    };
+
+    size_t n1 = 0, n2 = 0;
+
+    GridIndex(const size_t n1, const size_t n2) : n1(n1), n2(n2)
+    {
+        if (n1 == 0 || n2 == 0)
+            throw std::invalid_argument(
+                std::string("GridIndex: ") + std::to_string(n1) + "x" +
+                std::to_string(n2));
+    }
+
+    size_t num_nodes() const { return n1 * n2; }
+    size_t size() const { return num_nodes(); }
+    size_t num_edges() const { return (n1 - 1) * n2 + n1 * (n2 - 1); }
+
+    /** Number of edges along the contiguous axis (they come first) */
+    size_t num_edges1() const { return (n1 - 1) * n2; }
+
+    int_t head(const int_t e) const
+    {
+        const auto m1 = int_t(num_edges1());
+        return e < m1 ? e + e / int_t(n1 - 1) : e - m1;
+    }
+
+    int_t tail(const int_t e) const
+    {
+        const auto m1 = int_t(num_edges1());
+        return e < m1 ? head(e) + 1 : e - m1 + int_t(n1);
+    }
+
+    Neighbors operator[](const int_t u) const
+    {
+        const auto N1 = int_t(n1), N2 = int_t(n2), m1 = int_t(num_edges1());
+        const int_t i = u % N1, j = u / N1;
+        Neighbors r;
+        if (j > 0)
+            r.nb[r.len++] = {u - N1, m1 + u - N1};
+        if (i > 0)
+            r.nb[r.len++] = {u - 1, j * (N1 - 1) + i - 1};
+        if (i + 1 < N1)
+            r.nb[r.len++] = {u + 1, j * (N1 - 1) + i};
+        if (j + 1 < N2)
+            r.nb[r.len++] = {u + N1, m1 + u};
+        return r;
+    }
+};
+
+
+/** Call `f(u, v, e)` for every edge once (`u < v`) in the order of `e`.
+    In contrast to the general `edges`, the reverse direction is omitted. */
+template <typename int_t = int, typename gint_t, typename F>
+inline void
+edges(const GridIndex<gint_t> &grid, F f)
+{
+    const auto N1 = int_t(grid.n1), N2 = int_t(grid.n2);
+    int_t e = 0;
+    for (int_t j = 0; j < N2; j++)
+        for (int_t u = j * N1; u < (j + 1) * N1 - 1; u++)
+            f(u, u + 1, e++);
+    for (int_t u = 0; u < (N2 - 1) * N1; u++)
+        f(u, u + N1, e++);
+}
@@ -0,0 +1,257 @@
+/**
+   Anisotropic total variation for 2-D images and 3-D volumes:
+
+       min_x  ½ Σ_i μ[i] (x[i] - y[i])² + λ Σ_d Σ_i |x[i] - x[i + e_d]|
+
+   For every axis `d` the problem decomposes into independent lines (rows,
+   columns, ...) which are solved in parallel by `line_las` directly on
+   strided views of the arrays (no transposed copies); the axes are
+   combined as in split.hpp (in the metric given by `μ`, default 1).
+ */
+#pragma once
+#include <algorithm>        // std::max, std::min
+#include <chrono>
+#include <cmath>            // std::abs
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/std/uvector.hpp>
+
+#include "event.hpp"
+#include "line_dp.hpp"
+#include "parallel.hpp"
+#include "split.hpp"
+#include "strided.hpp"
+
+
+template <typename float_t = double>
+struct GridTV
+{
+    std::vector<size_t> dims;               // C-order: last dimension is contiguous
+    size_t n = 0;
+    size_t chunk = 8;                       // neighboring lines per task
+    std::vector<size_t> lo, hi;             // if set, only edges starting in the
+                                            // box [lo, hi) are weighted by λ
+    bool warm = false;                      // solve(): continue from the last call
+                                            // (x and the splitting state)
+
+    explicit GridTV(const std::vector<size_t> &dims);
+
+    /** Distance in memory between neighbors along axis `d` */
+    size_t stride(const size_t d) const;
+
+    double objective(
+        const float_t *x,
+        const float_t *y,
+        double lam,
+        ThreadPool &pool,
+        const float_t *mu = nullptr) const;
+
+    /** Stop after `max_iter` iterations or if no `x[i]` changed by more
+        than `tol`; `mu == nullptr` means `μ = 1`, otherwise `μ > 0`. */
+    SplitResult solve(
+        float_t *x,
+        const float_t *y,
+        const double lam,
+        const size_t max_iter,
+        const double tol,
+        ThreadPool &pool,
+        const bool verbose = false,
+        const float_t *mu = nullptr);
+
+private:
+    std::vector<size_t> axes;               // axes with at least two nodes
+    std::vector<float_t> z, p;
+
+    /** Whether node `i` lies in [lo, hi) regarding all axes except `skip` */
+    bool in_box(const size_t i, const size_t skip) const;
+};
+
+
+template <typename float_t>
+GridTV<float_t>::GridTV(const std::vector<size_t> &dims) : dims(dims)
+{
+    if (dims.empty() || dims.size() > 3)
+        throw std::invalid_argument(
+            std::string("GridTV: need 1 to 3 dimensions, got ") +
+            std::to_string(dims.size()));
+    n = 1;
+    for (size_t d = 0; d < dims.size(); d++) {
+        n *= dims[d];
+        if (dims[d] > 1)
+            axes.push_back(d);
+    }
+}
+
+
+template <typename float_t>
+size_t
+GridTV<float_t>::stride(const size_t d) const
+{
+    size_t s = 1;
+    for (size_t j = d + 1; j < dims.size(); j++)
+        s *= dims[j];
+    return s;
+}
+
+
+template <typename float_t>
+bool
+GridTV<float_t>::in_box(const size_t i, const size_t skip) const
+{
+    if (lo.empty())
+        return true;
+    for (size_t d = 0; d < dims.size(); d++) {
+        const size_t c = (i / stride(d)) % dims[d];
+        if (d != skip && (c < lo[d] || c >= hi[d]))
+            return false;
+    }
+    return true;
+}
+
+
+template <typename float_t>
+double
+GridTV<float_t>::objective(
+    const float_t *x,
+    const float_t *y,
+    const double lam,
+    ThreadPool &pool,
+    const float_t *mu) const
+{
+    std::vector<double> sums(pool.size(), 0.0);
+    pool.blocks(n, [&](size_t begin, size_t end, unsigned t) {
+        double s = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            const double d = double(x[i]) - double(y[i]);
+            s += 0.5 * (mu ? double(mu[i]) : 1.0) * d * d;
+        }
+        for (const auto d : axes) {
+            const size_t sd = stride(d);
+            for (size_t i = begin; i < end; i++)
+                if ((i / sd) % dims[d] + 1 < dims[d] && in_box(i, dims.size()))
+                    s += lam * std::abs(double(x[i]) - double(x[i + sd]));
+        }
+        sums[t] = s;
+    });
+    double s = 0.0;
+    for (const auto v : sums)
+        s += v;
+    return s;
+}
+
+
+template <typename float_t>
+SplitResult
+GridTV<float_t>::solve(
+    float_t *x,
+    const float_t *y,
+    const double lam,
+    const size_t max_iter,
+    const double tol,
+    ThreadPool &pool,
+    const bool verbose,
+    const float_t *mu)
+{
+    if (!lo.empty() && (lo.size() != dims.size() || hi.size() != dims.size()))
+        throw std::invalid_argument("GridTV: lo, hi need one entry per dimension");
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const size_t K = axes.size();
+    const bool resume = warm && z.size() == K * n && K > 0;
+    if (!resume)
+        std::copy(y, y + n, x);
+    SplitResult res;
+    if (K == 0) {
+        res.obj.push_back(0.0);
+        res.delta.push_back(0.0);
+        res.time.push_back(0.0);
+        res.converged = true;
+        return res;
+    }
+    z.resize(K * n);
+    p.resize(K * n);
+    for (size_t k = 0; k < K; k++)          // resume: z holds z_k - y (sum 0)
+        for (size_t i = 0; i < n; i++)
+            z[k * n + i] = resume ? z[k * n + i] + y[i] : y[i];
+
+    size_t max_len = 0;
+    for (const auto d : axes)
+        max_len = std::max(max_len, dims[d]);
+    std::vector<uvector<Event>> events(pool.size());
+    std::vector<uvector<float_t>> ubs(pool.size());
+    for (unsigned t = 0; t < pool.size(); t++) {
+        events[t].reserve(2 * max_len);
+        ubs[t].reserve(max_len);
+    }
+    const auto klam = Const<float_t>(float_t(double(K) * lam));
+
+    double delta = 0.0;
+    for (size_t it = 0; true; it++) {
+        const double secs = std::chrono::duration<double>(clock::now() - start).count();
+        res.obj.push_back(objective(x, y, lam, pool, mu));
+        res.delta.push_back(it == 0 ? 0.0 : delta);
+        res.time.push_back(secs);
+        if (verbose)
+            std::cout << it << '\t' << res.obj.back() << '\t' << res.delta.back() << '\t'
+                      << secs << std::endl;
+        if (it > 0 && delta <= tol) {
+            res.converged = true;
+            break;
+        }
+        if (it >= max_iter)
+            break;
+
+        for (size_t k = 0; k < K; k++) {
+            const size_t d = axes[k], len = dims[d], sd = stride(d), lines = n / len;
+            float_t *pk = p.data() + k * n, *zk = z.data() + k * n;
+            pool.run((lines + chunk - 1) / chunk, [&](size_t c, unsigned t) {
+                const size_t end = std::min(lines, (c + 1) * chunk);
+                for (size_t l = c * chunk; l < end; l++) {
+                    const size_t off = (l / sd) * len * sd + l % sd;
+                    // edges starting in [a, b), i.e. nodes [a, b]; others: identity
+                    size_t a = 0, b = len - 1;
+                    if (!lo.empty()) {
+                        a = in_box(off, d) ? lo[d] : len;
+                        b = std::min(hi[d], len - 1);
+                    }
+                    const auto P = strided(pk + off, std::ptrdiff_t(sd));
+                    const auto Z = strided(zk + off, std::ptrdiff_t(sd));
+                    for (size_t i = 0; i < len; i++)
+                        if (i < a || i > b || a >= b)
+                            P[i] = Z[i];
+                    if (a >= b)
+                        continue;
+                    const auto ds = std::ptrdiff_t(a * sd);
+                    if (mu)
+                        line_las<false>(
+                            b - a + 1,
+                            strided(pk + off + ds, std::ptrdiff_t(sd)),
+                            strided(zk + off + ds, std::ptrdiff_t(sd)),
+                            klam,
+                            strided(mu + off + ds, std::ptrdiff_t(sd)),
+                            events[t].data(),
+                            ubs[t].data());
+                    else
+                        line_las<false>(
+                            b - a + 1,
+                            strided(pk + off + ds, std::ptrdiff_t(sd)),
+                            strided(zk + off + ds, std::ptrdiff_t(sd)),
+                            klam,
+                            Ones<float_t>(),
+                            events[t].data(),
+                            ubs[t].data());
+                }
+            });
+        }
+        delta = dykstra_average(K, n, p.data(), z.data(), x, pool);
+    }
+    if (warm)
+        for (size_t k = 0; k < K; k++)
+            for (size_t i = 0; i < n; i++)
+                z[k * n + i] -= y[i];
+    return res;
+}
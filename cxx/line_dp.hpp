@@ -53,6 +53,47 @@ line_las(
 }
 
 
+/**
+   The dynamic program itself, without any allocation or timer.
+
+   `x` and `y` may be pointers or views (e.g. `Strided`, see strided.hpp);
+   `x` is also used to store the lower bounds.
+   The workspace `event` must provide `2*n` and `ub` at least `n-1` elements.
+*/
+template<bool CHECK = true, typename float_, typename X, typename Y,
+         typename Wlam, typename Wmu>
+inline void
+line_las(
+    const size_t n,
+    X x,
+    const Y &y,
+    const Wlam &lam,
+    const Wmu &mu,
+    Event *event,
+    float_ *ub)
+{
+    if (n == 0)
+        return;
+    Range pq {int(n), int(n-1)};
+    float_ lam0 = float_(0.0);
+    DEBUG && printf("\n");
+    for (size_t i = 0; i < n-1; i++) {
+        DEBUG && printf("mu[%d] = %f, y[i] = %f, lam0 = %f, lam[i] = %f\n",
+                        int(i), double(mu[i]), double(y[i]), lam0, double(lam[i]));
+        x[i] = clip<+1, CHECK>(event, pq, float_(+mu[i]),
+                               float_(-mu[i]*y[i] - lam0 + lam[i]));
+        ub[i] = clip<-1, CHECK>(event, pq, float_(-mu[i]),
+                                float_(+mu[i]*y[i] - lam0 + lam[i]));
+        lam0 = (!CHECK || mu[i] > EPS) ? float_(lam[i]) : std::min(lam0, float_(lam[i]));
+    }
+    DEBUG && printf("\n");
+    x[n-1] = clip<+1, CHECK>(event, pq, float_(mu[n-1]),
+                             float_(-mu[n-1]*y[n-1] - lam0 + 0));
+    for (size_t i = n-1; i >= 1; i--)
+        x[i-1] = clamp(float_(x[i]), float_(x[i-1]), ub[i-1]);
+}
+
+
 template<typename float_, typename Wlam, typename Wmu, bool CHECK = true>
 void
 line_las(
@@ -67,32 +108,13 @@ line_las(
 
     uvector<Event> elem;
     uvector<float_> ub;
-    Range pq {int(n), int(n-1)};
     {
         Timer _ ("alloc");
         elem.reserve(2*n);
         ub.reserve(n-1);
     }
-    auto *el = elem.data();
-    float_
-        *lb = x,
-        lam0 = float_(0.0);
-    {
-        Timer _ ("forward");
-        DEBUG && printf("\n");
-        for (size_t i = 0; i < n-1; i++) {
-            DEBUG && printf("mu[%d] = %f, y[i] = %f, lam0 = %f, lam[i] = %f\n",
-                            int(i), mu[i], y[i], lam0, lam[i]);
-            lb[i] = clip<+1, CHECK>(el, pq, +mu[i], -mu[i]*y[i] - lam0 + lam[i]);
-            ub[i] = clip<-1, CHECK>(el, pq, -mu[i], +mu[i]*y[i] - lam0 + lam[i]);
-            lam0 = (!CHECK || mu[i] > EPS) ? lam[i] : std::min(lam0, lam[i]);
-        }
-    }
     {
-        Timer _ ("backward");
-        DEBUG && printf("\n");
-        x[n-1] = clip<+1, CHECK>(el, pq, mu[n-1], -mu[n-1]*y[n-1] - lam0 + 0);
-        for (size_t i = n-1; i >= 1; i--)
-            x[i-1] = clamp(x[i], lb[i-1], ub[i-1]);
+        Timer _ ("dp");
+        line_las<CHECK>(n, x, y, lam, mu, elem.data(), ub.data());
     }
 }
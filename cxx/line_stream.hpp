@@ -0,0 +1,96 @@
+/**
+   `line_las` for signals that do not fit into memory: `y` is read block by
+   block, the bounds `lb`, `ub` and the event queue are kept in a
+   memory-mapped scratch file (see mmap_file.hpp) and `x` is written block
+   by block after the backward pass.  Only one block of `y` resides in
+   memory; the kernel pages the rest of the workspace in and out, which is
+   cheap because the dynamic program accesses it almost sequentially.
+
+   Scratch space: 2n events, n lower and n-1 upper bounds.
+ */
+#pragma once
+#include <algorithm>        // std::min
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "event.hpp"
+#include "line_dp.hpp"
+#include "mmap_file.hpp"
+
+
+/** Random access view of `read(offset, count, buf)` for (almost)
+    sequential reads: one block is cached */
+template <typename float_, typename Read>
+class BlockReader
+{
+public:
+    BlockReader(const size_t n, const size_t block, Read &read)
+        : n(n), read(read), buf(std::max<size_t>(block, 1))
+    {
+    }
+
+    float_ operator[](const size_t i) const
+    {
+        if (i < start || i >= start + len) {
+            start = i / buf.size() * buf.size();
+            len = std::min(buf.size(), n - start);
+            read(start, len, buf.data());
+        }
+        return buf[i - start];
+    }
+
+private:
+    const size_t n;
+    Read &read;
+    mutable std::vector<float_> buf;
+    mutable size_t start = 0, len = 0;
+};
+
+
+/**
+   Solve the line problem of length `n` whereby the data is provided by
+   `read_y(offset, count, float_ *buf)` and the solution is handed to
+   `write_x(offset, count, const float_ *buf)` (both in blocks of at most
+   `block` elements).
+ */
+template <typename float_ = double, typename Read, typename Write, typename Wlam>
+void
+line_las_stream(
+    const size_t n,
+    Read read_y,
+    Write write_x,
+    const Wlam &lam,
+    size_t block = size_t(1) << 20,
+    const char *scratch_dir = nullptr)
+{
+    if (n == 0)
+        return;
+    block = std::max<size_t>(block, 1);
+    const size_t
+        ev_bytes = 2 * n * sizeof(Event),
+        lb_bytes = n * sizeof(float_),
+        ub_bytes = (n - 1) * sizeof(float_);
+    Timer timer ("scratch");
+    ScratchFile scratch (ev_bytes + lb_bytes + ub_bytes, scratch_dir);
+    auto *event = reinterpret_cast<Event *>(scratch.data());
+    auto *lb = reinterpret_cast<float_ *>(scratch.data() + ev_bytes);
+    auto *ub = reinterpret_cast<float_ *>(scratch.data() + ev_bytes + lb_bytes);
+    timer.stop();
+    {
+        Timer _ ("dp");
+        const BlockReader<float_, Read> y (n, block, read_y);
+        line_las<true>(n, lb, y, lam, Ones<float_>(), event, ub);
+    }
+    scratch.discard(0, ev_bytes);
+    scratch.discard(ev_bytes + lb_bytes, ub_bytes);
+    {
+        Timer _ ("write x");
+        for (size_t i = 0; i < n; i += block) {
+            const size_t count = std::min(block, n - i);
+            write_x(i, count, static_cast<const float_ *>(lb + i));
+            scratch.discard(ev_bytes + i * sizeof(float_), count * sizeof(float_));
+        }
+    }
+}
@@ -18,6 +18,10 @@
 
    proc_order: Post order (parent after their children), excluding root.
 
+   subtree_first: If not NULL, `subtree_first[v]` is set to the position
+         in the post order where the subtree of `v` starts (see
+         tree_dual_par.hpp).
+
    timc: If not NULL, allocate a Timer before returning.
          This makes it possible to measure the time needed for deallocation.
 */
@@ -28,7 +32,8 @@ init_queues(
     std::vector<int> &proc_order,
     const ChildrenIndex &childs,
     stack<int> &stack,
-    int root = 0)
+    int root = 0,
+    int *subtree_first = nullptr)
 {
     {
         // Timer _ ("init_queue: alloc");
@@ -46,6 +51,8 @@ init_queues(
             const auto v = stack.back();
             stack.pop_back();
             if (v >= 0) {
+                if (subtree_first)
+                    subtree_first[v] = int(proc_order.size());
                 stack.push_back(-v-1);
                 for (const auto i : childs[v])
                     stack.push_back(i);
@@ -60,6 +67,44 @@ init_queues(
 }
 
 
+/**
+   Like `init_queues` but with the processing order already known:
+   `queue_start[i]` is the start of the (empty) queue of node `i` as set
+   by `init_queues`.
+*/
+inline void
+init_queues(const size_t n, uvector<Range> &pq, const int *queue_start)
+{
+    Timer _ ("init_queue: stored");
+    for (size_t i = 0; i < n; i++)
+        pq[i] = Range({queue_start[i], queue_start[i]-1});
+}
+
+
+/**
+   Compute what `tree_dp` needs about the topology, e.g. to store it:
+   `postorder` (as `proc_order` in `init_queues` followed by the root) and
+   `queue_start` (see above).
+*/
+inline void
+tree_orders(
+    const size_t n,
+    const int *parent,
+    const int root,
+    std::vector<int> &postorder,
+    std::vector<int> &queue_start)
+{
+    uvector<Range> pq (n);
+    ChildrenIndex childs (n, parent, root);
+    stack<int> stack;
+    init_queues(n, pq, postorder, childs, stack, root);
+    postorder.push_back(root);
+    queue_start.resize(n);
+    for (size_t i = 0; i < n; i++)
+        queue_start[i] = pq[i].start;
+}
+
+
 
 template <typename E>
 inline void
@@ -69,6 +114,47 @@ sort_events(const Range &range, E *elements)
 }
 
 
+/**
+   Append `e` to the events `elements[first:last+1]` (sorted) unless it
+   can be merged into the last one; returns the new `last`.
+*/
+template <typename E>
+inline int
+push_event(E *elements, const int first, int last, const E &e)
+{
+    if (last >= first && elements[last].x == e.x) {
+        elements[last].slope += e.slope;
+        if (elements[last].slope == 0)
+            last--;
+    } else if (e.slope != 0) {
+        elements[++last] = e;
+    }
+    return last;
+}
+
+
+/**
+   Coalesce the events of the sorted `range` with equal `x` by summing
+   their slopes and drop events whose slope is exactly zero.  The start
+   stays, the returned range may end earlier.
+
+   This is NOT bit-exact: the piecewise linear function stays the same,
+   but `clip` then adds `-x*(s1 + s2)` instead of `-x*s1 - x*s2` to its
+   offset (and cannot stop between the coalesced events), so results
+   agree with the uncompacted ones only up to rounding.  Being exact
+   would mean keeping every original event, i.e. no compaction at all.
+*/
+template <typename E>
+inline Range
+compact_events(const Range &range, E *elements)
+{
+    int last = range.start - 1;         // last kept event
+    for (int j = range.start; j <= range.stop; j++)
+        last = push_event(elements, range.start, last, elements[j]);
+    return Range({range.start, last});
+}
+
+
 template <typename E>
 inline Range
 merge(const Range &parent, const Range &child, E *elements)
@@ -98,12 +184,22 @@ merge(const Range &parent, const Range &child, std::vector<E> &elements)
 }
 
 
+/**
+   Merge the sorted queues `parent` and `child` (stored behind it).
+   With `compact`, equal events are coalesced while merging (see
+   `compact_events`).
+
+   `buffer` holds a copy of `parent` (grown as needed); if NULL, a
+   buffer local to the calling thread is used.
+*/
 template <typename E>
 inline Range
-merge2(const Range &parent, const Range &child, E *elements)
+merge2(const Range &parent, const Range &child, E *elements,
+       const bool compact = false, uvector<E> *buffer = nullptr)
 {
-    static uvector<E> buf (15);
     if (parent.start <= parent.stop) {
+        thread_local uvector<E> local (15);
+        auto &buf = buffer ? *buffer : local;
         const auto gap = child.start - parent.stop -1;
         const Range res {parent.start, child.stop - gap};
         buf.reserve(parent.length());
@@ -117,6 +213,16 @@ merge2(const Range &parent, const Range &child, E *elements)
         int
             l = 0,
             r = child.start;
+        if (compact) {
+            int last = res.start - 1;
+            for (int k = res.start; k <= res.stop; k++) {
+                const E e = (l < buf_end &&
+                             (r > child.stop || buf[l].x < elements[r].x)) ?
+                    buf[l++] : elements[r++];
+                last = push_event(elements, res.start, last, e);
+            }
+            return Range({res.start, last});
+        }
         for (int k = res.start; k <= res.stop; k++) {
             elements[k] = (l < buf_end &&
                            (r > child.stop || buf[l].x < elements[r].x)) ?
@@ -131,7 +237,8 @@ merge2(const Range &parent, const Range &child, E *elements)
 /// For convinience: std::vector instead of pointers
 template <typename E>
 inline Range
-merge2(const Range &parent, const Range &child, std::vector<E> &elements)
+merge2(const Range &parent, const Range &child, std::vector<E> &elements,
+       const bool compact = false, uvector<E> *buffer = nullptr)
 {
-    return merge2(parent, child, elements.data());
+    return merge2(parent, child, elements.data(), compact, buffer);
 }
@@ -0,0 +1,162 @@
+/**
+   Memory maps: read-only ones of existing files and scratch space for
+   workspaces that do not fit into memory.
+ */
+#pragma once
+#include <algorithm>        // std::min
+#include <cstdlib>          // std::getenv
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>          // open
+#include <sys/mman.h>       // mmap
+#include <sys/stat.h>       // fstat
+#include <unistd.h>         // close, ftruncate, unlink
+
+
+/** Read-only memory map of a whole file */
+class MappedFile
+{
+public:
+    MappedFile(const char *fname)
+    {
+        const int fd = ::open(fname, O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error(std::string("Could not open ") + fname);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("Could not stat ") + fname);
+        }
+        len = size_t(st.st_size);
+        if (len > 0) {
+            void *p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error(std::string("Could not mmap ") + fname);
+            }
+            addr = static_cast<const char *>(p);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (addr)
+            ::munmap(const_cast<char *>(addr), len);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return addr; }
+    size_t size() const { return len; }
+
+    /** Hint the kernel that [offset, offset + bytes) will be read soon */
+    void willneed(const size_t offset, const size_t bytes) const
+    {
+        const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t start = offset / page * page;
+        if (addr && start < len)
+            ::madvise(const_cast<char *>(addr) + start,
+                      std::min(len - start, bytes + offset - start),
+                      MADV_WILLNEED);
+    }
+
+private:
+    const char *addr = nullptr;
+    size_t len = 0;
+};
+
+
+/**
+   Read-write map of a temporary file in `dir` (default: `$TMPDIR` or
+   "/tmp").  The file is unlinked right away so that it vanishes with the
+   process; the kernel writes pages back to it under memory pressure.
+   Pages never touched do not occupy any disk space (sparse file).
+ */
+class ScratchFile
+{
+public:
+    ScratchFile(const size_t bytes, const char *dir = nullptr) : len(bytes)
+    {
+        if (dir == nullptr)
+            dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir && *dir ? dir : "/tmp") + "/treelas-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        const int fd = ::mkstemp(name.data());
+        if (fd < 0)
+            throw std::runtime_error("Could not create scratch file " + path);
+        ::unlink(name.data());
+        if (len > 0 && ::ftruncate(fd, off_t(len)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not resize scratch file to " +
+                                     std::to_string(len) + " bytes");
+        }
+        if (len > 0) {
+            void *p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Could not mmap scratch file");
+            }
+            addr = static_cast<char *>(p);
+        }
+        ::close(fd);
+    }
+
+    ~ScratchFile()
+    {
+        if (addr)
+            ::munmap(addr, len);
+    }
+
+    ScratchFile(const ScratchFile &) = delete;
+    ScratchFile &operator=(const ScratchFile &) = delete;
+
+    char *data() const { return addr; }
+    size_t size() const { return len; }
+
+    /** Release the pages of [offset, offset + bytes): they are not needed
+        anymore and need not be written back */
+    void discard(const size_t offset, const size_t bytes) const
+    {
+        const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t start = (offset + page - 1) / page * page;
+        const size_t stop = std::min(len, offset + bytes) / page * page;
+        if (addr && start < stop)
+            ::madvise(addr + start, stop - start, MADV_REMOVE);
+    }
+
+    /** Hint that [offset, offset + bytes) will not be accessed for a while:
+        the kernel may write the pages back and reclaim them (Linux >= 5.4) */
+    void spill(const size_t offset, const size_t bytes) const
+    {
+#ifdef MADV_PAGEOUT
+        const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t start = (offset + page - 1) / page * page;
+        const size_t stop = std::min(len, offset + bytes) / page * page;
+        if (addr && start < stop)
+            ::madvise(addr + start, stop - start, MADV_PAGEOUT);
+#else
+        (void)offset;
+        (void)bytes;
+#endif
+    }
+
+    /** Hint the kernel that [offset, offset + bytes) will be read soon */
+    void willneed(const size_t offset, const size_t bytes) const
+    {
+        const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t start = offset / page * page;
+        if (addr && start < len)
+            ::madvise(addr + start,
+                      std::min(len - start, bytes + offset - start),
+                      MADV_WILLNEED);
+    }
+
+private:
+    char *addr = nullptr;
+    size_t len = 0;
+};
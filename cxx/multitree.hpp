@@ -0,0 +1,332 @@
+/**
+   Fused lasso on general graphs by splitting the edges into several
+   edge-disjoint forests (e.g. the rows and columns of a grid).
+
+   Every forest is a sum of independent subproblems (one per connected
+   component) which are solved in parallel, by `line_las` for paths and
+   `tree_dp` otherwise; the forests are combined as in split.hpp.
+ */
+#pragma once
+#include <algorithm>        // std::sort, std::max
+#include <atomic>
+#include <chrono>
+#include <cmath>            // std::abs
+#include <iostream>
+#include <memory>           // std::unique_ptr
+#include <numeric>          // std::iota
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/edges.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "line_dp.hpp"
+#include "parallel.hpp"
+#include "split.hpp"
+#include "tree_dp.hpp"
+
+
+template <typename int_t = int>
+struct MultiTree
+{
+    /** Connected component (at least two nodes) of one forest */
+    struct Part
+    {
+        int_t forest;
+        size_t begin, end;                  // nodes in `node[begin, end)`
+        bool line;                          // path (in order) or tree (BFS order)
+    };
+
+    size_t n = 0, m = 0, num_forests = 0;
+    std::vector<int_t> head, tail;          // endpoints of every edge
+    std::vector<int_t> forest;              // forest[e]: forest containing edge e
+    std::vector<int_t> node;                // nodes of all parts
+    std::vector<int_t> local;               // trees: parent, relative to `begin`
+    std::vector<int_t> edge;                // edge to parent (tree) or successor (line)
+    std::vector<Part> parts;                // largest first
+    size_t max_line = 0, max_tree = 0;      // largest part sizes
+
+    MultiTree() = default;
+
+    template <typename Graph>
+    MultiTree(const Graph &graph, const size_t max_degree = 2, const size_t max_size = 0)
+    {
+        reset(graph, max_degree, max_size);
+    }
+
+    /** Greedily decompose the edges of `graph` into forests.
+        Every node has at most `max_degree` neighbors within one forest
+        (2: the forests consist of paths; 0: no limit) and every component
+        has at most `max_size` nodes (0: no limit). */
+    template <typename Graph>
+    void reset(const Graph &graph, const size_t max_degree = 2, const size_t max_size = 0);
+
+    /** Solve with edge weights `lam`; store the result in `x`.
+        Stop after `max_iter` iterations or if no `x[i]` changed by more
+        than `tol`. */
+    template <typename L>
+    SplitResult solve(
+        double *x,
+        const double *y,
+        const L &lam,
+        const size_t max_iter = 100,
+        const double tol = 1e-6,
+        const unsigned threads = default_threads(),
+        const bool verbose = false) const;
+
+private:
+    void collect_parts(const std::vector<int_t> &index, const std::vector<int_t> &adj);
+};
+
+
+template <typename int_t>
+template <typename Graph>
+void
+MultiTree<int_t>::reset(const Graph &graph, const size_t max_degree, const size_t max_size)
+{
+    n = graph.num_nodes();
+    m = graph.num_edges();
+    head.assign(m, int_t(-1));
+    tail.assign(m, int_t(-1));
+    edges<int_t>(graph, [&](int_t u, int_t v, int_t e) {
+        if (u < v) {
+            head[e] = u;
+            tail[e] = v;
+        }
+    });
+
+    forest.assign(m, int_t(-1));
+    node.clear();
+    local.clear();
+    edge.clear();
+    parts.clear();
+    max_line = max_tree = 0;
+    num_forests = 0;
+
+    std::vector<int_t> uf(n), size(n), degree(n), index(n + 1), adj;
+    const auto find = [&uf](int_t v) {
+        while (uf[v] != v)
+            v = uf[v] = uf[uf[v]];
+        return v;
+    };
+    size_t remaining = m;
+    while (remaining > 0) {
+        const auto k = int_t(num_forests++);
+        std::iota(uf.begin(), uf.end(), int_t(0));
+        std::fill(size.begin(), size.end(), int_t(1));
+        std::fill(degree.begin(), degree.end(), int_t(0));
+        size_t taken = 0;
+        for (size_t e = 0; e < m; e++) {
+            if (forest[e] >= 0 || head[e] < 0)
+                continue;
+            const auto u = head[e], v = tail[e];
+            if (max_degree > 0 &&
+                (size_t(degree[u]) >= max_degree || size_t(degree[v]) >= max_degree))
+                continue;
+            const auto ru = find(u), rv = find(v);
+            if (ru == rv)
+                continue;
+            if (max_size > 0 && size_t(size[ru] + size[rv]) > max_size)
+                continue;
+            uf[ru] = rv;
+            size[rv] += size[ru];
+            degree[u]++;
+            degree[v]++;
+            forest[e] = k;
+            taken++;
+        }
+        if (taken == 0)             // only self loops (or max_size < 2) left
+            break;
+        remaining -= taken;
+
+        // adjacency of forest k
+        std::fill(index.begin(), index.end(), int_t(0));
+        for (size_t e = 0; e < m; e++) {
+            if (forest[e] == k) {
+                index[head[e] + 1]++;
+                index[tail[e] + 1]++;
+            }
+        }
+        for (size_t v = 0; v < n; v++)
+            index[v + 1] += index[v];
+        adj.resize(2 * size_t(index[n]));
+        for (size_t e = 0; e < m; e++) {
+            if (forest[e] == k) {
+                adj[2 * index[head[e]]] = tail[e];
+                adj[2 * index[head[e]]++ + 1] = int_t(e);
+                adj[2 * index[tail[e]]] = head[e];
+                adj[2 * index[tail[e]]++ + 1] = int_t(e);
+            }
+        }
+        for (size_t v = n; v > 0; v--)
+            index[v] = index[v - 1];
+        index[0] = 0;
+        collect_parts(index, adj);
+    }
+    std::sort(parts.begin(), parts.end(), [](const Part &a, const Part &b) {
+        return a.end - a.begin > b.end - b.begin;
+    });
+}
+
+
+template <typename int_t>
+void
+MultiTree<int_t>::collect_parts(
+    const std::vector<int_t> &index, const std::vector<int_t> &adj)
+{
+    const auto k = int_t(num_forests - 1);
+    const auto degree = [&index](int_t v) { return index[v + 1] - index[v]; };
+    std::vector<char> seen(n, 0);
+    const auto add_part = [&](int_t start) {
+        const size_t begin = node.size();
+        bool line = true;
+        node.push_back(start);
+        local.push_back(0);
+        edge.push_back(int_t(-1));
+        seen[start] = 1;
+        for (size_t i = begin; i < node.size(); i++) {    // BFS
+            const auto u = node[i];
+            line = line && degree(u) <= 2;
+            for (auto j = index[u]; j < index[u + 1]; j++) {
+                const auto v = adj[2 * j], e = adj[2 * j + 1];
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    node.push_back(v);
+                    local.push_back(int_t(i - begin));
+                    edge.push_back(e);
+                }
+            }
+        }
+        const size_t end = node.size();
+        if (line) {     // started at an end of the path: edge[i] to successor
+            for (size_t i = begin; i + 1 < end; i++)
+                edge[i] = edge[i + 1];
+            edge[end - 1] = int_t(-1);
+            max_line = std::max(max_line, end - begin);
+        } else {
+            max_tree = std::max(max_tree, end - begin);
+        }
+        parts.push_back(Part {k, begin, end, line});
+    };
+    for (size_t v = 0; v < n; v++)     // paths: start at one end
+        if (!seen[v] && degree(int_t(v)) == 1)
+            add_part(int_t(v));
+    for (size_t v = 0; v < n; v++)
+        if (!seen[v] && degree(int_t(v)) > 1)
+            add_part(int_t(v));
+}
+
+
+template <typename int_t>
+template <typename L>
+SplitResult
+MultiTree<int_t>::solve(
+    double *x,
+    const double *y,
+    const L &lam,
+    const size_t max_iter,
+    const double tol,
+    const unsigned threads,
+    const bool verbose) const
+{
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const size_t K = std::max<size_t>(num_forests, 1);
+    ThreadPool pool(threads);
+    const auto nthreads = pool.size();
+    std::vector<double> z(K * n), p(K * n);
+    for (size_t k = 0; k < K; k++)
+        std::copy(y, y + n, z.data() + k * n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = y[i];
+
+    // every thread has its own workspace; larger (tree) parts first
+    TimerQuiet quiet;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < parts.size(); i++)
+        if (!parts[i].line)
+            order.push_back(i);
+    for (size_t i = 0; i < parts.size(); i++)
+        if (parts[i].line)
+            order.push_back(i);
+    const size_t buf = std::max(max_line, max_tree);
+    std::vector<std::vector<double>> yb(nthreads, std::vector<double>(buf)),
+        xb(nthreads, std::vector<double>(buf)), lb(nthreads, std::vector<double>(buf)),
+        ub(nthreads, std::vector<double>(max_line));
+    std::vector<std::vector<Event>> events(nthreads, std::vector<Event>(2*max_line));
+    std::vector<std::vector<int>> tparent(nthreads, std::vector<int>(max_tree));
+    std::vector<std::unique_ptr<TreeDPStatus>> tree_mem(nthreads);
+    for (auto &mem : tree_mem)
+        mem.reset(new TreeDPStatus(max_tree));
+
+    const auto solve_part = [&](const Part &P, unsigned t) {
+        const size_t len = P.end - P.begin;
+        const double *zk = z.data() + size_t(P.forest) * n;
+        double *pk = p.data() + size_t(P.forest) * n;
+        double *yt = yb[t].data(), *xt = xb[t].data(), *lt = lb[t].data();
+        for (size_t i = 0; i < len; i++) {
+            const auto e = edge[P.begin + i];
+            yt[i] = zk[node[P.begin + i]];
+            lt[i] = e < 0 ? 0.0 : double(K) * lam[e];
+        }
+        if (P.line) {
+            line_las(len, xt, yt, lt, Ones<double>(), events[t].data(), ub[t].data());
+        } else {
+            int *pt = tparent[t].data();
+            for (size_t i = 0; i < len; i++)
+                pt[i] = int(local[P.begin + i]);
+            tree_dp<false, false>(len, xt, yt, pt, lt, Ones<double>(), 0, *tree_mem[t]);
+        }
+        for (size_t i = 0; i < len; i++)
+            pk[node[P.begin + i]] = xt[i];
+    };
+
+    const auto objective = [&]() {
+        std::vector<double> sums(nthreads, 0.0);
+        pool.blocks(n + m, [&](size_t b, size_t e, unsigned t) {
+            double s = 0.0;
+            for (size_t i = b; i < e; i++) {
+                if (i < n) {
+                    const double d = x[i] - y[i];
+                    s += 0.5 * d * d;
+                } else if (head[i - n] >= 0) {
+                    s += lam[i - n] * std::abs(x[head[i - n]] - x[tail[i - n]]);
+                }
+            }
+            sums[t] = s;
+        });
+        double s = 0.0;
+        for (const auto v : sums)
+            s += v;
+        return s;
+    };
+
+    SplitResult res;
+    double delta = 0.0;
+    for (size_t it = 0; true; it++) {
+        const double secs = std::chrono::duration<double>(clock::now() - start).count();
+        res.obj.push_back(objective());
+        res.delta.push_back(it == 0 ? 0.0 : delta);
+        res.time.push_back(secs);
+        if (verbose)
+            std::cout << it << '\t' << res.obj.back() << '\t' << res.delta.back() << '\t'
+                      << secs << std::endl;
+        if (it > 0 && delta <= tol) {
+            res.converged = true;
+            break;
+        }
+        if (it >= max_iter)
+            break;
+
+        pool.blocks(K * n, [&](size_t b, size_t e, unsigned) {
+            std::copy(z.data() + b, z.data() + e, p.data() + b);
+        });
+        std::atomic<size_t> next {0};
+        pool.each([&](unsigned t) {
+            for (size_t i = next++; i < order.size(); i = next++)
+                solve_part(parts[order[i]], t);
+        });
+        delta = dykstra_average(K, n, p.data(), z.data(), x, pool);
+    }
+    return res;
+}
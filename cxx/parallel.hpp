@@ -0,0 +1,209 @@
+/**
+   Minimal helpers to distribute loops over several `std::thread`s.
+ */
+#pragma once
+#include <algorithm>        // std::min
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>          // std::size_t
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/** Number of threads to be used if nothing else is specified. */
+inline unsigned
+default_threads()
+{
+    const unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+
+/**
+   Split `[0, n)` into (at most) `threads` consecutive blocks and call
+   `f(begin, end, t)` for the `t`-th block.
+   The calling thread processes the first block itself; if there is only
+   one block, no thread is spawned at all.
+ */
+template <typename F>
+inline void
+parallel_blocks(const size_t n, unsigned threads, F f)
+{
+    threads = unsigned(std::min<size_t>(std::max(threads, 1u), std::max<size_t>(n, 1)));
+    const size_t block = (n + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; t++) {
+        const size_t begin = std::min(n, t * block), end = std::min(n, begin + block);
+        workers.emplace_back([=, &f]() { f(begin, end, t); });
+    }
+    f(size_t(0), std::min(n, block), 0u);
+    for (auto &w : workers)
+        w.join();
+}
+
+
+/** Call `f(i)` for every `i` in `[0, n)`, distributed over `threads`. */
+template <typename F>
+inline void
+parallel_for(const size_t n, const unsigned threads, F f)
+{
+    parallel_blocks(n, threads, [&f](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++)
+            f(i);
+    });
+}
+
+
+/** Number of blocks for `m` elements: at most `threads`, at least `grain`
+    elements per block (i.e. short loops run in the calling thread). */
+inline unsigned
+parallel_parts(const size_t m, const unsigned threads, const size_t grain = 4096)
+{
+    return std::max(1u, std::min<unsigned>(threads, unsigned(m / grain + 1)));
+}
+
+
+/**
+   Exclusive prefix sums `out[i] = f(0) + ... + f(i-1)` for `i` in `[0, m]`
+   (i.e. `out` has `m + 1` entries): block sums, then every block again
+   starting from its offset.
+ */
+template <typename T, typename F>
+inline void
+parallel_scan(const size_t m, const unsigned threads, T *out, F f)
+{
+    const unsigned parts = parallel_parts(m, threads);
+    if (parts <= 1) {
+        T sum = T(0);
+        for (size_t i = 0; i < m; i++) {
+            out[i] = sum;
+            sum += f(i);
+        }
+        out[m] = sum;
+        return;
+    }
+    std::vector<T> offset (parts + 1, T(0));
+    parallel_blocks(m, parts, [&](size_t begin, size_t end, unsigned t) {
+        T sum = T(0);
+        for (size_t i = begin; i < end; i++)
+            sum += f(i);
+        offset[t+1] = sum;
+    });
+    for (unsigned t = 0; t < parts; t++)
+        offset[t+1] += offset[t];
+    parallel_blocks(m, parts, [&](size_t begin, size_t end, unsigned t) {
+        T sum = offset[t];
+        for (size_t i = begin; i < end; i++) {
+            out[i] = sum;
+            sum += f(i);
+        }
+    });
+    out[m] = offset[parts];
+}
+
+
+/**
+   Fixed set of threads to run many short parallel loops without spawning
+   threads every time (e.g. in every iteration of a solver).
+   The calling thread takes part as thread number 0.
+   The called functions must not throw.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads = default_threads())
+    {
+        for (unsigned t = 1; t < std::max(threads, 1u); t++)
+            workers.emplace_back([this, t]() { work(t); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return unsigned(workers.size()) + 1; }
+
+    /** Call `f(t)` on every thread `t`; return when all are done. */
+    template <typename F>
+    void each(F f)
+    {
+        if (workers.empty()) {
+            f(0u);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = std::function<void(unsigned)>(f);
+            pending = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        f(0u);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    /** Call `f(i, t)` for every `i` in `[0, n)`; the `i` are handed out
+        dynamically, `t` is the number of the executing thread. */
+    template <typename F>
+    void run(const size_t n, F f)
+    {
+        std::atomic<size_t> next {0};
+        each([&](unsigned t) {
+            for (size_t i = next++; i < n; i = next++)
+                f(i, t);
+        });
+    }
+
+    /** Like `parallel_blocks`: `f(begin, end, t)` for consecutive blocks. */
+    template <typename F>
+    void blocks(const size_t n, F f)
+    {
+        const size_t block = (n + size() - 1) / size();
+        each([&](unsigned t) {
+            const size_t begin = std::min(n, t * block);
+            f(begin, std::min(n, begin + block), t);
+        });
+    }
+
+private:
+    void work(const unsigned t)
+    {
+        size_t seen = 0;
+        while (true) {
+            std::function<void(unsigned)> f;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+                f = job;
+            }
+            f(t);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::function<void(unsigned)> job;
+    size_t generation = 0, pending = 0;
+    bool stop = false;
+};
@@ -5,4 +5,108 @@
    https://stackoverflow.com/a/53134263
 
    https://github.com/NERSC/timemory/search?q=sigint&unscoped_q=sigint
+
+   Long running solvers poll a `Cancel` token at phase and iteration
+   boundaries.  Anytime methods (`tree_apx`, `gaplas`) stop with their
+   current iterate; exact ones (`tree_dp`) throw `Interrupted`.
 */
+#pragma once
+#include <algorithm>        // std::min
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+
+/** Thrown by solvers that cannot return an intermediate result */
+struct Interrupted : public std::runtime_error
+{
+    explicit Interrupted(const std::string &where)
+        : std::runtime_error(where + ": interrupted") { }
+};
+
+
+/**
+   While in scope, [Ctrl-C] (SIGINT) does not terminate the process but
+   raises a flag that every `Cancel::stop()` obeys.  Scopes may be nested
+   or live in several threads; the previous handler is restored when the
+   last one ends.
+ */
+class SigintScope
+{
+public:
+    SigintScope()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (count++ == 0) {
+            flag.store(false);
+            previous = std::signal(SIGINT, handler);
+        }
+    }
+
+    ~SigintScope()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (--count == 0) {
+            std::signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+            flag.store(false);
+        }
+    }
+
+    SigintScope(const SigintScope &) = delete;
+    SigintScope& operator=(const SigintScope &) = delete;
+
+    static bool raised() { return flag.load(std::memory_order_relaxed); }
+
+private:
+    static void handler(int) { flag.store(true, std::memory_order_relaxed); }
+
+    static inline std::atomic<bool> flag {false};
+    static inline std::mutex mutex;
+    static inline int count = 0;
+    static inline void (*previous)(int) = SIG_DFL;
+};
+
+
+/**
+   Cancellation token: set by `cancel()` (from any thread), by a deadline
+   or by [Ctrl-C] within a `SigintScope`.
+ */
+class Cancel
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    Cancel() = default;
+
+    /** Deadline in `seconds` from now (infinity: none) */
+    explicit Cancel(const double seconds) { deadline_in(seconds); }
+
+    void deadline_in(const double seconds)
+    {
+        has_deadline = seconds < std::numeric_limits<double>::infinity();
+        if (has_deadline)
+            deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(std::min(seconds, 1e9)));
+    }
+
+    void cancel() { flag.store(true, std::memory_order_relaxed); }
+
+    bool cancelled() const
+    {
+        return flag.load(std::memory_order_relaxed) || SigintScope::raised();
+    }
+
+    bool timed_out() const { return has_deadline && clock::now() >= deadline; }
+
+    /** Should the solver stop? */
+    bool stop() const { return cancelled() || timed_out(); }
+
+private:
+    std::atomic<bool> flag {false};
+    bool has_deadline = false;
+    clock::time_point deadline;
+};
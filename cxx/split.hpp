@@ -0,0 +1,61 @@
+/**
+   Common parts of the splitting solvers (`MultiTree`, `GridTV`) which
+   combine `K` proximal operators by the parallel Dykstra-like algorithm
+   (Combettes and Pesquet, "Proximal Splitting Methods in Signal
+   Processing", 2011, Algorithm 10.31) with equal weights:
+
+       p_k = prox_{K f_k}(z_k);   x = mean_k p_k;   z_k += x - p_k
+
+   starting from `z_k = y`.
+ */
+#pragma once
+#include <algorithm>        // std::max
+#include <cmath>            // std::abs
+#include <vector>
+
+#include "parallel.hpp"
+
+
+/** Progress of a splitting solver: entry `k` after `k` iterations */
+struct SplitResult
+{
+    std::vector<double> obj, delta, time;   // objective, max |x - x_prev|, seconds
+    bool converged = false;                 // delta below tolerance
+
+    size_t iterations() const { return obj.empty() ? 0 : obj.size() - 1; }
+};
+
+
+/** Averaging step: `x = mean_k p_k` and `z_k += x - p_k` whereby `p` and
+    `z` consist of `K` consecutive blocks of length `n`.
+    Return the maximal change of `x`. */
+template <typename float_t>
+double
+dykstra_average(
+    const size_t K,
+    const size_t n,
+    const float_t *p,
+    float_t *z,
+    float_t *x,
+    ThreadPool &pool)
+{
+    std::vector<double> deltas(pool.size(), 0.0);
+    pool.blocks(n, [&](size_t begin, size_t end, unsigned t) {
+        double d = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            double xi = 0.0;
+            for (size_t k = 0; k < K; k++)
+                xi += p[k * n + i];
+            xi /= double(K);
+            for (size_t k = 0; k < K; k++)
+                z[k * n + i] += float_t(xi - p[k * n + i]);
+            d = std::max(d, std::abs(xi - x[i]));
+            x[i] = float_t(xi);
+        }
+        deltas[t] = d;
+    });
+    double delta = 0.0;
+    for (const auto d : deltas)
+        delta = std::max(delta, d);
+    return delta;
+}
@@ -0,0 +1,25 @@
+/**
+   Strided view on an array, e.g. a column of a matrix stored in C-order.
+ */
+#pragma once
+#include <cstddef>          // std::size_t, std::ptrdiff_t
+
+
+template <typename T>
+struct Strided
+{
+    T *ptr;
+    std::ptrdiff_t stride;
+
+    Strided(T *ptr, const std::ptrdiff_t stride = 1) : ptr(ptr), stride(stride) {}
+
+    T &operator[](const size_t i) const { return ptr[std::ptrdiff_t(i) * stride]; }
+};
+
+
+template <typename T>
+inline Strided<T>
+strided(T *ptr, const std::ptrdiff_t stride)
+{
+    return Strided<T>(ptr, stride);
+}
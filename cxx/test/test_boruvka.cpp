@@ -0,0 +1,154 @@
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <graphidx/edges.hpp>
+#include <graphidx/grid.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../boruvka.hpp"
+#include "../gaplas.hpp"
+#include "demo3x7.hpp"
+
+
+/** Reference: Kruskal's algorithm; return which edges are in the tree. */
+static std::vector<char>
+kruskal(
+    const size_t n,
+    const std::vector<int> &head,
+    const std::vector<int> &tail,
+    const std::vector<double> &weight)
+{
+    std::vector<int> order(head.size()), uf(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::iota(uf.begin(), uf.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int e, int f) {
+        return weight[e] < weight[f];
+    });
+    const auto find = [&](int v) {
+        while (uf[v] != v)
+            v = uf[v] = uf[uf[v]];
+        return v;
+    };
+    std::vector<char> in_tree(head.size(), 0);
+    for (const auto e : order) {
+        const auto ru = find(head[e]), rv = find(tail[e]);
+        if (ru != rv) {
+            uf[ru] = rv;
+            in_tree[e] = 1;
+        }
+    }
+    return in_tree;
+}
+
+
+/** Sum of the weights of the tree edges */
+template <typename Graph>
+static double
+tree_weight(const Graph &idx, const std::vector<int> &parent, const std::vector<double> &w)
+{
+    double sum = 0;
+    edges<int>(idx, [&](int u, int v, int e) {
+        if (u < v && (parent[u] == v || parent[v] == u))
+            sum += w[e];
+    });
+    return sum;
+}
+
+
+TEST_CASE("boruvka: demo3x7 (prim)")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    IncidenceIndex<int> idx {graph};
+    const std::vector<double> gamma = {
+        -0.0,  -1.0,  -0.24, -0.04, -0.43, -0.73, -0.7,  -0.28, -1.41, -1.43, -0.51,
+        -0.52, -1.14, -0.02, -0.11, -0.02, -0.79, -0.33, -0.74, -0.65, -1.11, -0.78,
+        -0.51, -0.14, -0.44, -0.78, -0.58, -0.80, -1.43, -0.13, -1.06, -0.38};
+    REQUIRE(gamma.size() == idx.num_edges());
+    // found by prim; gamma[10] == gamma[22] so (10, 11) instead of (7, 10) is fine
+    const std::vector<int> prim = {0, 4, 5,  0,  3,  4,  7,  8,  5,  6, 7,
+                                   8, 9, 14, 17, 12, 15, 16, 19, 16, 17};
+    std::vector<int> expect(prim);
+    expect[10] = 11;
+    for (const unsigned threads : {1u, 2u, 5u}) {
+        CAPTURE(threads);
+        std::vector<int> parent(idx.num_nodes(), -1);
+        boruvka_mst_edges(parent.data(), gamma.data(), idx, 0, threads);
+        REQUIRE(find_root(parent) == 0);
+        CHECK(parent == expect);
+        CHECK(doctest::Approx(tree_weight(idx, prim, gamma)) ==
+              tree_weight(idx, parent, gamma));
+    }
+}
+
+
+TEST_CASE("boruvka: random graph")
+{
+    TimerQuiet _;
+    const size_t n = 500, m = 3000;
+    std::mt19937 rng(2020);
+    std::uniform_int_distribution<int> node(0, int(n - 1));
+    std::uniform_real_distribution<double> unif;
+    std::vector<int> head, tail;
+    for (size_t v = 1; v < n; v++) {    // ensure connectedness
+        head.push_back(int(v));
+        tail.push_back(std::uniform_int_distribution<int>(0, int(v - 1))(rng));
+    }
+    while (head.size() < m) {
+        const int u = node(rng), v = node(rng);
+        if (u != v) {
+            head.push_back(std::min(u, v));
+            tail.push_back(std::max(u, v));
+        }
+    }
+    std::vector<double> weight(m);
+    for (auto &w : weight)
+        w = unif(rng);
+
+    IncidenceIndex<int> idx(head, tail);
+    BoruvkaMST<int> mst(idx);
+    REQUIRE(mst.mst(weight.data(), 1) == n - 1);
+    std::vector<int> parent1(n), parent4(n);
+    mst.orient(parent1.data(), 3);
+    REQUIRE(mst.mst(weight.data(), 4) == n - 1);
+    mst.orient(parent4.data(), 3);
+    CHECK(parent1 == parent4);
+    CHECK(find_root(parent1) == 3);
+
+    CHECK(kruskal(n, head, tail, weight) == mst.in_tree);
+}
+
+
+TEST_CASE("boruvka: disconnected")
+{
+    const std::vector<int> head {0, 2}, tail {1, 3};
+    const std::vector<double> weight {1.0, 2.0};
+    IncidenceIndex<int> idx(head, tail);
+    BoruvkaMST<int> mst(idx);
+    REQUIRE(mst.mst(weight.data(), 2) == 2);
+    std::vector<int> parent(4);
+    mst.orient(parent.data(), 1);
+    const std::vector<int> expect {1, 1, 2, 2};
+    CHECK(parent == expect);
+}
+
+
+TEST_CASE("boruvka: gaplas demo3x7")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const auto lam = Const<double>(0.1);
+    const size_t n = idx.num_nodes();
+    const double *y = (const double *)demo_3x7_y;
+    std::vector<double> x(n);
+    gaplas<Boruvka>(x.data(), y, idx, lam, 5, false);
+    for (size_t i = 0; i < n; i++)
+        CHECK(std::abs(x[i] - y[i]) <= 0.1 * 4 + 1e-9);
+}
@@ -0,0 +1,77 @@
+#include <doctest/doctest.h>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <bzlib.h>
+
+#include "../bz2_blocks.hpp"
+
+
+static std::vector<char>
+compress(const std::string &text, const int level)
+{
+    std::vector<char> buf(text.size() + text.size() / 100 + 600);
+    unsigned len = unsigned(buf.size());
+    REQUIRE(BZ2_bzBuffToBuffCompress(buf.data(), &len, const_cast<char *>(text.data()),
+                                     unsigned(text.size()), level, 0, 0) == BZ_OK);
+    buf.resize(len);
+    return buf;
+}
+
+
+TEST_CASE("bz2_blocks: as sequential")
+{
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<int> word(0, 9999);
+    std::string text;
+    while (text.size() < 700000)
+        text += std::to_string(word(rng)) + (word(rng) % 9 ? " " : "\n");
+
+    // two streams (as pbzip2), each with several 100k blocks
+    auto bz = compress(text, 1);
+    const auto bz2 = compress(text.substr(0, 150000), 2);
+    bz.insert(bz.end(), bz2.begin(), bz2.end());
+    const std::string expected = text + text.substr(0, 150000);
+
+    char fname[] = "/tmp/test_bz2_blocks-XXXXXX";
+    const int fd = mkstemp(fname);
+    REQUIRE(fd >= 0);
+    FILE *f = fdopen(fd, "wb");
+    REQUIRE(fwrite(bz.data(), 1, bz.size(), f) == bz.size());
+    fclose(f);
+
+    for (const unsigned threads : {1u, 3u}) {
+        for (const size_t batch : {size_t(1), size_t(0)}) {
+            CAPTURE(threads);
+            CAPTURE(batch);
+            Bz2Blocks blocks(fname, threads);
+            CHECK(blocks.num_blocks() >= 8);
+            std::string out;
+            blocks.decompress(
+                [&](const char *data, size_t len) { out.append(data, len); }, batch);
+            CHECK(out.size() == expected.size());
+            CHECK(out == expected);
+        }
+    }
+    std::remove(fname);
+}
+
+
+TEST_CASE("bz2_blocks: bits")
+{
+    std::vector<char> buf;
+    bz2blocks::BitWriter w(buf);
+    w.put(0x5, 3);                      // 101
+    w.put(bz2blocks::BLOCK_MAGIC, 48);
+    w.flush();
+    REQUIRE(buf.size() == 7);
+    const auto *data = reinterpret_cast<const uint8_t *>(buf.data());
+    CHECK(bz2blocks::get_bits(data, buf.size(), 3, 48) == bz2blocks::BLOCK_MAGIC);
+    std::vector<bz2blocks::Mark> marks;
+    bz2blocks::scan(data, buf.size(), 0, buf.size(), marks);
+    REQUIRE(marks.size() == 1);
+    CHECK(marks[0].bit == 3);
+    CHECK(marks[0].block);
+}
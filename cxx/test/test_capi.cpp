@@ -0,0 +1,190 @@
+#include <doctest/doctest.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>          // TimerQuiet
+
+#include "../line_dp.hpp"
+#include "../tree_dp.hpp"
+#include "../treelas.h"
+
+
+/** Random tree (parent[i] < i, i.e. rooted at 0) with some latent nodes */
+static void
+random_instance(const size_t n, std::vector<int> &parent, std::vector<double> &y,
+                std::vector<double> &lam, std::vector<double> &mu)
+{
+    std::mt19937 rng(2021);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    parent.resize(n);
+    y.resize(n);
+    lam.resize(n);
+    mu.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i == 0 ? 0 : int(unif(rng) * double(i));
+        y[i] = 4.0 * unif(rng) - 2.0;
+        lam[i] = 0.5 * unif(rng);
+        mu[i] = unif(rng) < 0.1 ? 0.0 : unif(rng) + 0.1;
+    }
+    mu[0] = 1.0;
+    mu[n-1] = 1.0;
+}
+
+
+TEST_CASE("capi: tree")
+{
+    TimerQuiet _;
+    const size_t n = 500;
+    std::vector<int> parent;
+    std::vector<double> y, lam, mu;
+    random_instance(n, parent, y, lam, mu);
+
+    std::vector<double> expected (n);
+    tree_dp<false, true>(n, expected.data(), y.data(), parent.data(),
+                         Array<const double>(lam.data()), Array<const double>(mu.data()), 0);
+
+    treelas_solver *s = treelas_create(n);
+    REQUIRE(s != nullptr);
+    CHECK(treelas_size(s) == n);
+
+    std::vector<double> x (n);
+    CHECK(treelas_tree_f64(s, x.data(), y.data(), nullptr, 1.0, nullptr, 1.0) != 0);
+    CHECK(std::string(treelas_error(s)).find("no tree") != std::string::npos);
+
+    REQUIRE(treelas_set_tree_i32(s, parent.data(), -1) == 0);
+    for (int rep = 0; rep < 2; rep++) {
+        REQUIRE(treelas_tree_f64(s, x.data(), y.data(), lam.data(), 0.0, mu.data(), 0.0) == 0);
+        for (size_t i = 0; i < n; i++)
+            CHECK(x[i] == expected[i]);
+    }
+
+    // x == y, int64 parents
+    const std::vector<int64_t> parent64 (parent.begin(), parent.end());
+    REQUIRE(treelas_set_tree_i64(s, parent64.data(), 0) == 0);
+    x = y;
+    REQUIRE(treelas_tree_f64(s, x.data(), x.data(), lam.data(), 0.0, mu.data(), 0.0) == 0);
+    for (size_t i = 0; i < n; i++)
+        CHECK(x[i] == expected[i]);
+
+    // float
+    const std::vector<float> yf (y.begin(), y.end()), lamf (lam.begin(), lam.end());
+    std::vector<float> xf (n);
+    std::vector<double> yd (yf.begin(), yf.end()), ld (lamf.begin(), lamf.end());
+    tree_dp<false, true>(n, expected.data(), yd.data(), parent.data(),
+                         Array<const double>(ld.data()), Ones<double>(), 0);
+    REQUIRE(treelas_tree_f32(s, xf.data(), yf.data(), lamf.data(), 0.0f, nullptr, 1.0f) == 0);
+    for (size_t i = 0; i < n; i++)
+        CHECK(xf[i] == float(expected[i]));
+
+    // batch
+    const double lams[] = {0.1, 0.7, 2.0};
+    std::vector<double> yb, xb (3*n);
+    for (int j = 0; j < 3; j++)
+        yb.insert(yb.end(), y.begin(), y.end());
+    REQUIRE(treelas_tree_batch_f64(s, 3, xb.data(), yb.data(), lams) == 0);
+    for (int j = 0; j < 3; j++) {
+        CAPTURE(j);
+        tree_dp<false, true>(n, expected.data(), y.data(), parent.data(),
+                             Const<double>(lams[j]), Ones<double>(), 0);
+        for (size_t i = 0; i < n; i++)
+            CHECK(xb[j*n + i] == expected[i]);
+    }
+
+    // errors
+    auto bad = parent;
+    bad[3] = int(n);
+    CHECK(treelas_set_tree_i32(s, bad.data(), 0) != 0);
+    bad[3] = 3;
+    CHECK(treelas_set_tree_i32(s, bad.data(), 0) != 0);
+    CHECK(treelas_set_tree_i32(s, parent.data(), 2) != 0);
+    treelas_destroy(s);
+}
+
+
+TEST_CASE("capi: tree dual")
+{
+    TimerQuiet _;
+    const size_t n = 400;
+    std::vector<int> parent;
+    std::vector<double> y, lam, mu;
+    random_instance(n, parent, y, lam, mu);
+
+    std::vector<double> expected (n), ealpha (n);
+    TreeDPStatus st (n);
+    TreeDPDual edual;
+    edual.alpha = ealpha.data();
+    tree_dp<false, true>(n, expected.data(), y.data(), parent.data(),
+                         Array<const double>(lam.data()), Array<const double>(mu.data()),
+                         0, st, nullptr, nullptr, nullptr, &edual);
+
+    treelas_solver *s = treelas_create(n);
+    REQUIRE(s != nullptr);
+    REQUIRE(treelas_set_tree_i32(s, parent.data(), 0) == 0);
+    std::vector<double> x (y), alpha (n);
+    treelas_objective obj;
+    REQUIRE(treelas_tree_dual_f64(s, x.data(), x.data(), lam.data(), 0.0, mu.data(), 0.0,
+                                  alpha.data(), &obj) == 0);
+    CHECK(obj.primal == edual.primal);
+    CHECK(obj.dual == edual.dual);
+    CHECK(obj.gap == edual.gap);
+    CHECK(obj.gap < 1e-8 * obj.primal);
+    for (size_t i = 1; i < n; i++) {
+        CHECK(x[i] == expected[i]);
+        CHECK(alpha[i] == ealpha[i]);
+    }
+    REQUIRE(treelas_tree_dual_f64(s, x.data(), y.data(), nullptr, 0.5, nullptr, 1.0,
+                                  nullptr, &obj) == 0);
+    CHECK(obj.gap >= -1e-9);
+
+    const std::vector<float> yf (y.begin(), y.end());
+    std::vector<float> xf (n), af (n);
+    REQUIRE(treelas_tree_dual_f32(s, xf.data(), yf.data(), nullptr, 0.5f, nullptr, 1.0f,
+                                  af.data(), nullptr) == 0);
+    for (size_t i = 1; i < n; i++)
+        CHECK(std::abs(af[i]) <= 0.5f * (1 + 1e-6f));
+    treelas_destroy(s);
+}
+
+
+TEST_CASE("capi: line")
+{
+    TimerQuiet _;
+    const size_t n = 300;
+    std::vector<int> parent;
+    std::vector<double> y, lam, mu;
+    random_instance(n, parent, y, lam, mu);
+
+    treelas_solver *s = treelas_create(n);
+    REQUIRE(s != nullptr);
+    std::vector<double> x (n), expected (n);
+    line_las(n, expected.data(), y.data(), Array<const double>(lam.data()),
+             Array<const double>(mu.data()));
+    REQUIRE(treelas_line_f64(s, x.data(), y.data(), lam.data(), 0.0, mu.data(), 0.0) == 0);
+    for (size_t i = 0; i < n; i++)
+        CHECK(x[i] == expected[i]);
+    x = y;
+    REQUIRE(treelas_line_f64(s, x.data(), x.data(), lam.data(), 0.0, mu.data(), 0.0) == 0);
+    for (size_t i = 0; i < n; i++)
+        CHECK(x[i] == expected[i]);
+
+    const std::vector<float> yf (y.begin(), y.end());
+    std::vector<float> xf (2*n);
+    std::vector<float> yb (yf);
+    yb.insert(yb.end(), yf.begin(), yf.end());
+    const float lams[] = {0.3f, 1.5f};
+    REQUIRE(treelas_line_batch_f32(s, 2, xf.data(), yb.data(), lams) == 0);
+    const std::vector<double> yd (yf.begin(), yf.end());
+    for (int j = 0; j < 2; j++) {
+        line_las(n, expected.data(), yd.data(), Const<double>(lams[j]), Ones<double>());
+        for (size_t i = 0; i < n; i++)
+            CHECK(xf[j*n + i] == float(expected[i]));
+    }
+
+    mu[n-1] = 0.0;
+    CHECK(treelas_line_f64(s, x.data(), y.data(), nullptr, 0.1, mu.data(), 0.0) != 0);
+    treelas_destroy(s);
+}
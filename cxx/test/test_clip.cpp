@@ -3,6 +3,7 @@
 
 #define DEBUG_CLIP false
 #include "../clip.hpp"
+#include "../merge.hpp"
 
 
 TEST_CASE("clip")
@@ -48,3 +49,37 @@ TEST_CASE("clip")
         }
     }
 }
+
+
+TEST_CASE("clip: compact events")
+{
+    std::vector<Event> event {
+        {0.0, 1.0}, {1.0, 2.0}, {1.0, -2.0}, {2.0, 1.0}, {2.0, 1.0}, {3.0, 0.5}};
+    const auto pq = compact_events(Range({0, 5}), event.data());
+    REQUIRE(Range({0, 2}) == pq);
+    CHECK(Event({0.0, 1.0}) == event[0]);
+    CHECK(Event({2.0, 2.0}) == event[1]);
+    CHECK(Event({3.0, 0.5}) == event[2]);
+}
+
+
+TEST_CASE("clip: merge2 compact")
+{
+    std::vector<Event> event {{0.0, 1.0}, {2.0, 1.0}, {}, {1.0, 1.0}, {2.0, -1.0}};
+    const auto pq = merge2(Range({0, 1}), Range({3, 4}), event, true);
+    REQUIRE(Range({0, 1}) == pq);
+    CHECK(Event({0.0, 1.0}) == event[0]);
+    CHECK(Event({1.0, 1.0}) == event[1]);
+}
+
+
+TEST_CASE("clip: compact on insert")
+{
+    std::vector<Event> event {{}, {1.0, 1.0}, {}};
+    Range pq {1, 1};
+    CHECK(1.0 == clip<+1, false>(event, pq, 1.0, -1.0, true));
+    REQUIRE(Range({1, 1}) == pq);
+    CHECK(Event({1.0, 2.0}) == event[1]);
+    CHECK(1.0 == clip<-1, false>(event, pq, -2.0, 2.0, true));
+    CHECK(!pq);
+}
@@ -0,0 +1,108 @@
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../boruvka.hpp"
+#include "../components.hpp"
+
+
+/** Random sparse graph (several components, isolated nodes, self loops) */
+static void
+random_graph(const size_t n, const size_t m, std::vector<int> &head, std::vector<int> &tail)
+{
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<int> node(0, int(n) - 1);
+    head.resize(m);
+    tail.resize(m);
+    for (size_t e = 0; e < m; e++) {
+        head[e] = node(rng);
+        tail[e] = node(rng);
+    }
+}
+
+
+/** Reference: repeated relaxation of the minimum label */
+static std::vector<int>
+min_labels(const size_t n, const std::vector<int> &head, const std::vector<int> &tail)
+{
+    std::vector<int> label(n);
+    for (size_t v = 0; v < n; v++)
+        label[v] = int(v);
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (size_t e = 0; e < head.size(); e++) {
+            const int l = std::min(label[head[e]], label[tail[e]]);
+            if (label[head[e]] != l || label[tail[e]] != l) {
+                label[head[e]] = label[tail[e]] = l;
+                changed = true;
+            }
+        }
+    }
+    return label;
+}
+
+
+TEST_CASE("components: union-find")
+{
+    const size_t n = 3000;
+    std::vector<int> head, tail;
+    random_graph(n, 1400, head, tail);
+    const auto expected = min_labels(n, head, tail);
+    for (const unsigned threads : {1u, 4u}) {
+        CAPTURE(threads);
+        const auto label = connected_labels(n, head.size(), head.data(), tail.data(), threads);
+        CHECK(label == expected);
+    }
+
+    const auto largest = largest_component(expected);
+    REQUIRE(largest.size() > 1);
+    for (size_t i = 0; i < largest.size(); i++) {
+        CHECK(expected[largest[i]] == expected[largest[0]]);
+        if (i > 0)
+            CHECK(largest[i-1] < largest[i]);
+    }
+
+    auto h = head, t = tail;
+    induced_edges(n, largest, h, t, 3);
+    size_t inside = 0;
+    for (size_t e = 0; e < head.size(); e++)
+        inside += expected[head[e]] == expected[largest[0]];
+    CHECK(h.size() == inside);
+    for (size_t e = 0; e < h.size(); e++) {
+        CHECK(h[e] >= 0);
+        CHECK(t[e] < int(largest.size()));
+    }
+}
+
+
+TEST_CASE("components: random Boruvka tree")
+{
+    const size_t n = 2000;
+    std::vector<int> head, tail;
+    random_graph(n, 8000, head, tail);
+    const auto largest = largest_component(min_labels(n, head, tail));
+    induced_edges(n, largest, head, tail, 2);
+    const size_t nn = largest.size();
+
+    const auto parent = boruvka_random_tree(nn, head, tail, 2018, 1);
+    CHECK(boruvka_random_tree(nn, head, tail, 2018, 4) == parent);
+    CHECK(boruvka_random_tree(nn, head, tail, 2019, 4) != parent);
+
+    // a spanning tree rooted at 0 that only uses edges of the graph
+    REQUIRE(parent.size() == nn);
+    CHECK(parent[0] == 0);
+    std::vector<std::vector<int>> adj(nn);
+    for (size_t e = 0; e < head.size(); e++) {
+        adj[head[e]].push_back(tail[e]);
+        adj[tail[e]].push_back(head[e]);
+    }
+    for (size_t v = 1; v < nn; v++) {
+        CAPTURE(v);
+        CHECK(std::find(adj[v].begin(), adj[v].end(), parent[v]) != adj[v].end());
+        size_t steps = 0;
+        for (int u = int(v); u != 0 && steps <= nn; u = parent[u])
+            steps++;
+        CHECK(steps <= nn);
+    }
+}
@@ -0,0 +1,96 @@
+#include <doctest/doctest.h>
+#include <cmath>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/edges.hpp>
+#include <graphidx/grid.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../cyclegap.hpp"
+#include "demo3x7.hpp"
+
+
+/** Lowest common ancestor by climbing up from `u` for every ancestor of `v` */
+static int
+naive_lca(const std::vector<int> &parent, int u, int v)
+{
+    for (int a = u; true; a = parent[a]) {
+        for (int b = v; true; b = parent[b]) {
+            if (a == b)
+                return a;
+            if (parent[b] == b)
+                break;
+        }
+        if (parent[a] == a)
+            break;
+    }
+    return -1;
+}
+
+
+TEST_CASE("cyclegap: demo3x7")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const std::vector<double> lamv = {
+        0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5, 1.6,
+        1.7, 1.8, 1.9, 2.0, 2.1, 2.2, 2.3, 2.4, 2.5, 2.6, 2.7, 2.8, 2.9, 3.0, 3.1, 3.2};
+    REQUIRE(lamv.size() == m);
+    const auto lam = Const<double>(0.1);
+    auto tlam = lam;
+    const double *y = (const double *)demo_3x7_y;
+    std::vector<double> x(n);
+    CycleGap<double> mem(x.data(), y, n, m, 0);
+    mem.init();
+    mem.gap_vec(idx, lam);
+    mem.template find_tree<Boruvka>(idx, tlam, lam);
+    mem.cycle_basis(idx);
+    REQUIRE(mem.order.size() == n);
+
+    SUBCASE("lowest common ancestors")
+    {
+        edges<int>(idx, [&](int u, int v, int e) {
+            if (u < v && mem.tree_edge[u] != e && mem.tree_edge[v] != e) {
+                CAPTURE(e);
+                CHECK(mem.lca[e] == naive_lca(mem.parent, u, v));
+            }
+        });
+    }
+    SUBCASE("rotate")
+    {
+        mem.rotate(idx, lamv.data());
+        std::vector<double> expect(n, 0.0);
+        for (size_t v = 0; v < n; v++)
+            if (mem.tree_edge[v] >= 0)
+                expect[v] = lamv[mem.tree_edge[v]];
+        edges<int>(idx, [&](int u, int v, int e) {
+            if (u < v && mem.tree_edge[u] != e && mem.tree_edge[v] != e) {
+                const auto r = naive_lca(mem.parent, u, v);
+                for (const int s : {u, v})
+                    for (int w = s; w != r; w = mem.parent[w])
+                        expect[w] += lamv[e];
+            }
+        });
+        for (size_t v = 0; v < n; v++) {
+            CAPTURE(v);
+            CHECK(doctest::Approx(expect[v]) == mem.tlam[v]);
+            CHECK(doctest::Approx(mem.tree_edge[v] >= 0 ? lamv[mem.tree_edge[v]] : 0.0) ==
+                  mem.tlam0[v]);
+        }
+    }
+    SUBCASE("iterate")
+    {
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 5, false, Ones<double>());
+        REQUIRE(res.obj.size() == 6);
+        for (size_t e = 0; e < m; e++) {
+            CAPTURE(e);
+            CHECK(std::abs(mem.alpha[e]) <= 0.1 + 1e-12);
+        }
+        for (size_t k = 0; k < res.obj.size(); k++)
+            CHECK(std::isfinite(res.obj[k]));
+    }
+}
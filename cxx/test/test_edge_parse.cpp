@@ -0,0 +1,78 @@
+#include <doctest/doctest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../edge_parse.hpp"
+
+
+TEST_CASE("edge_parse: parse_uint")
+{
+    for (const uint64_t v : {0ull, 7ull, 42ull, 12345678ull, 123456789ull,
+                             2147483647ull, 999999999999999ull}) {
+        CAPTURE(v);
+        for (const std::string pad : {"", "                "}) {   // scalar, SSE
+            const std::string s = std::to_string(v) + " x" + pad;
+            const char *p = s.data();
+            uint64_t r = 0;
+            CHECK(edgeparse::parse_uint(p, s.data() + s.size(), r));
+            CHECK(r == v);
+            CHECK(*p == ' ');
+            CHECK(!edgeparse::parse_uint(p, s.data() + s.size(), r));
+        }
+    }
+}
+
+
+TEST_CASE("edge_parse: dimacs10")
+{
+    const std::string graph =
+        "% comment\n"
+        "4 4 1\n"
+        "2 5 3 1\n"
+        "1 5 3 2\n"
+        "1 1 2 2 4 7\n"
+        "% another comment\n"
+        "3 7";
+    const std::vector<int> head = {0, 0, 1, 2}, tail = {1, 2, 2, 3};
+    for (const size_t chunk : {size_t(1), size_t(3), graph.size()}) {
+        CAPTURE(chunk);
+        EdgeParser parser(EdgeFormat::DIMACS10, 2);
+        for (size_t i = 0; i < graph.size(); i += chunk)
+            parser.feed(graph.data() + i, graph.data() + std::min(graph.size(), i + chunk));
+        parser.finish();
+        CHECK(parser.num_nodes() == 4);
+        CHECK(parser.head == head);
+        CHECK(parser.tail == tail);
+        CHECK(parser.bytes() == graph.size());
+    }
+
+    EdgeParser bad(EdgeFormat::DIMACS10, 1);
+    const std::string wrong = "2 1\n3\n\n";
+    CHECK_THROWS_AS(bad.feed(wrong.data(), wrong.data() + wrong.size()), std::runtime_error);
+}
+
+
+TEST_CASE("edge_parse: snap, threads")
+{
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<int> node(0, 1 << 24);
+    std::string graph = "# Directed graph\n# Nodes: ...\n";
+    std::vector<int> head, tail;
+    for (int i = 0; i < 50000; i++) {
+        head.push_back(node(rng));
+        tail.push_back(node(rng));
+        graph += std::to_string(head.back()) + (i % 3 ? "\t" : " ") +
+            std::to_string(tail.back()) + (i % 7 ? "\n" : "\r\n");
+    }
+    for (const unsigned threads : {1u, 3u}) {
+        CAPTURE(threads);
+        EdgeParser parser(EdgeFormat::SNAP, threads);
+        const size_t half = graph.size() / 2;
+        parser.feed(graph.data(), graph.data() + half);
+        parser.feed(graph.data() + half, graph.data() + graph.size());
+        parser.finish();
+        CHECK(parser.head == head);
+        CHECK(parser.tail == tail);
+    }
+}
@@ -1,20 +1,162 @@
-#ifdef HAVE_LEMON
 #include <doctest/doctest.h>
+#include <algorithm>   // std::min
 #include <type_traits> // std::remove_const
 
 #include <graphidx/bits/weights.hpp>
 #include <graphidx/edges.hpp>
 #include <graphidx/grid.hpp>
-#include <graphidx/heap/lemon_heap.hpp>
 #include <graphidx/idx/incidence.hpp>
 #include <graphidx/tree/root.hpp>
 #include <graphidx/utils/timer.hpp>
+#ifdef HAVE_LEMON
+#  include <graphidx/heap/lemon_heap.hpp>
+#endif
 
 #include "../gaplas.hpp"
 #include "demo3x7.hpp"
 #include "doctestx.hpp"
 
 
+TEST_CASE("gaplas: update_tree")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const auto lam = Const<double>(0.1);
+    auto tlam = lam;
+    const auto mu = Ones<double>();
+    const double *y = (const double *)demo_3x7_y;
+    std::vector<double> x(n);
+    GapMem<double> mem(x.data(), y, n, m, 0);
+    mem.incremental = true;
+    mem.init();
+    mem.gap_vec(idx, lam);
+    mem.template find_tree<Boruvka>(idx, tlam, lam);
+
+    const auto tree_weight = [&]() {
+        double sum = 0;
+        for (size_t v = 0; v < n; v++)
+            sum += mem.tree_edge[v] < 0 ? 0.0 : mem.gamma[mem.tree_edge[v]];
+        return sum;
+    };
+    for (int it = 0; it < 5; it++) {
+        CAPTURE(it);
+        mem.tree_opt(tlam, mu);
+        mem.update_duals(idx);
+        mem.gap_vec(idx, lam);
+        const double before = tree_weight();
+        mem.update_tree(idx, tlam, lam);
+        CHECK(tree_weight() <= before + 1e-12);
+
+        REQUIRE(find_root(mem.parent) == 0);
+        std::vector<double> y_tree(y, y + n);
+        edges<int>(idx, [&](int u, int v, int e) {
+            if (u < v) {
+                if (mem.parent[u] == v || mem.parent[v] == u) {
+                    CHECK(mem.tree_edge[mem.parent[u] == v ? u : v] == e);
+                } else {
+                    y_tree[u] += mem.alpha[e];
+                    y_tree[v] -= mem.alpha[e];
+                }
+            }
+        });
+        for (size_t v = 0; v < n; v++) {
+            CAPTURE(v);
+            CHECK(doctest::Approx(y_tree[v]) == mem.y_tree[v]);
+        }
+    }
+}
+
+
+TEST_CASE("gaplas: stopping criterion")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const auto lam = Const<double>(0.1);
+    const double *y = (const double *)demo_3x7_y;
+    std::vector<double> x(n);
+    GapMem<double> mem(x.data(), y, n, m, 0);
+
+    SUBCASE("tolerance")
+    {
+        mem.tol = 1e-6;
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 100, false, Ones<double>());
+        REQUIRE(res.converged);
+        REQUIRE(res.iterations() < 100);
+        REQUIRE(res.obj.size() == res.iterations() + 1);
+        CHECK(res.gap.back() <= 1e-6 * res.obj.back());
+        for (size_t k = 1; k < res.time.size(); k++)
+            CHECK(res.time[k - 1] <= res.time[k]);
+    }
+    SUBCASE("max_iter")
+    {
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 2, false, Ones<double>());
+        CHECK(!res.converged);
+        CHECK(res.iterations() == 2);
+    }
+    SUBCASE("momentum")
+    {
+        mem.tol = 1e-6;
+        mem.learn = 0.75;
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 100, false, Ones<double>());
+        REQUIRE(res.converged);
+        CHECK(res.gap.back() <= 1e-6 * res.obj.back());
+        for (size_t e = 0; e < m; e++) {
+            CAPTURE(e);
+            CHECK(std::abs(mem.alpha[e]) <= 0.1 + 1e-12);
+        }
+    }
+    SUBCASE("time budget")
+    {
+        mem.max_time = 0.0;
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 100, false, Ones<double>());
+        CHECK(res.iterations() == 0);
+    }
+    SUBCASE("cancelled")
+    {
+        Cancel cancel;
+        cancel.cancel();
+        mem.cancel = &cancel;
+        const auto res = gaplas<Boruvka>(mem, idx, lam, 100, false, Ones<double>());
+        CHECK(res.cancelled);
+        CHECK(!res.converged);
+        CHECK(res.iterations() == 0);
+    }
+}
+
+
+TEST_CASE("gaplas: parallel orders and duals")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const auto lam = Const<double>(0.1);
+    const double *y = (const double *)demo_3x7_y;
+    std::vector<double> x(n), x2(n);
+    GapMem<double> mem_par(x.data(), y, n, m, 0), mem_seq(x2.data(), y, n, m, 0);
+    mem_par.threads = mem_seq.threads = 3;
+    mem_par.par_tree_min = 0;
+    const auto res = gaplas<Boruvka>(mem_par, idx, lam, 10, false, Ones<double>());
+    const auto expected = gaplas<Boruvka>(mem_seq, idx, lam, 10, false, Ones<double>());
+
+    // a gap of (almost) zero may be rounded to either side
+    const size_t iters = std::min(res.obj.size(), expected.obj.size());
+    REQUIRE(iters > 1);
+    for (size_t k = 0; k < iters; k++) {
+        CAPTURE(k);
+        CHECK(res.obj[k] == doctest::Approx(expected.obj[k]));
+        CHECK(res.gap[k] == doctest::Approx(expected.gap[k]).epsilon(1e-6));
+    }
+}
+
+
+#ifdef HAVE_LEMON
+
+
 TEST_CASE("gaplas: demo3x7")
 {
     using Queue = lemo::QuadHeapT;
@@ -0,0 +1,98 @@
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/edges.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../boruvka.hpp"
+#include "../cyclegap.hpp"
+#include "../gaplas.hpp"
+#include "../grid_index.hpp"
+#include "demo3x7.hpp"
+
+
+TEST_CASE("grid_index: edges, head, tail and neighbors agree")
+{
+    for (const auto &d : std::vector<std::pair<size_t, size_t>> {
+             {3, 7}, {7, 3}, {1, 5}, {5, 1}, {1, 1}, {4, 4}}) {
+        CAPTURE(d.first);
+        CAPTURE(d.second);
+        const GridIndex<int> grid(d.first, d.second);
+        const auto n = grid.num_nodes(), m = grid.num_edges();
+        std::vector<int> head, tail;
+        edges<int>(grid, [&](int u, int v, int e) {
+            REQUIRE(e == int(head.size()));
+            CHECK(u < v);
+            CHECK((v == u + 1 || v == u + int(d.first)));
+            CHECK(grid.head(e) == u);
+            CHECK(grid.tail(e) == v);
+            head.push_back(u);
+            tail.push_back(v);
+        });
+        REQUIRE(head.size() == m);
+
+        size_t degrees = 0;
+        for (size_t u = 0; u < n; u++) {
+            for (const auto &ve : grid[int(u)]) {
+                const auto v = ve.first, e = ve.second;
+                REQUIRE(e >= 0);
+                REQUIRE(size_t(e) < m);
+                CHECK(std::min(int(u), v) == head[e]);
+                CHECK(std::max(int(u), v) == tail[e]);
+                degrees++;
+            }
+        }
+        CHECK(degrees == 2 * m);
+    }
+}
+
+
+TEST_CASE("grid_index: gaplas as with incidence index")
+{
+    TimerQuiet _;
+    const GridIndex<int> grid(3, 7);
+    std::vector<int> head, tail;
+    edges<int>(grid, [&](int u, int v, int) {
+        head.push_back(u);
+        tail.push_back(v);
+    });
+    const IncidenceIndex<int> idx(head, tail);
+    const size_t n = grid.num_nodes(), m = grid.num_edges();
+    const double *y = (const double *)demo_3x7_y;
+    const auto lam = Const<double>(0.1);
+
+    SUBCASE("GapMem")
+    {
+        std::vector<double> xi(n), xg(n);
+        GapMem<double> mi(xi.data(), y, n, m, 0), mg(xg.data(), y, n, m, 0);
+        mi.incremental = mg.incremental = true;
+        const auto ri = gaplas<Boruvka>(mi, idx, lam, 10, false, Ones<double>());
+        const auto rg = gaplas<Boruvka>(mg, grid, lam, 10, false, Ones<double>());
+        REQUIRE(ri.iterations() == rg.iterations());
+        CHECK(ri.gap.back() == doctest::Approx(rg.gap.back()));
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(xi[i] == doctest::Approx(xg[i]));
+        }
+        for (size_t e = 0; e < m; e++) {
+            CAPTURE(e);
+            CHECK(mi.alpha[e] == doctest::Approx(mg.alpha[e]));
+        }
+    }
+
+    SUBCASE("CycleGap")
+    {
+        std::vector<double> xi(n), xg(n);
+        CycleGap<double> mi(xi.data(), y, n, m, 0), mg(xg.data(), y, n, m, 0);
+        gaplas<Boruvka>(mi, idx, lam, 3, false, Ones<double>());
+        gaplas<Boruvka>(mg, grid, lam, 3, false, Ones<double>());
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(xi[i] == doctest::Approx(xg[i]));
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/grid.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../gaplas.hpp"
+#include "../grid_tv.hpp"
+#include "../line_dp.hpp"
+#include "../strided.hpp"
+#include "demo3x7.hpp"
+
+
+TEST_CASE("grid_tv: line_las on strided view")
+{
+    const std::vector<double> y = {1.0, 3.0, 2.0, 5.0, 4.0, 4.5, 0.0, 1.0};
+    const auto lam = Const<double>(0.7);
+    std::vector<double> x(y.size());
+    line_las(y.size(), x.data(), y.data(), lam);
+
+    // embed `y` as column 1 of a 8x3 matrix (C-order)
+    std::vector<double> ym(3 * y.size(), -1.0), xm(ym.size(), -1.0);
+    for (size_t i = 0; i < y.size(); i++)
+        ym[3 * i + 1] = y[i];
+    uvector<Event> event;
+    uvector<double> ub;
+    event.reserve(2 * y.size());
+    ub.reserve(y.size());
+    line_las<true>(y.size(),
+                   strided(xm.data() + 1, 3),
+                   strided(ym.data() + 1, 3),
+                   lam,
+                   Ones<double>(),
+                   event.data(),
+                   ub.data());
+    for (size_t i = 0; i < y.size(); i++) {
+        CAPTURE(i);
+        CHECK(x[i] == doctest::Approx(xm[3 * i + 1]));
+        CHECK(xm[3 * i] == -1.0);
+        CHECK(xm[3 * i + 2] == -1.0);
+    }
+}
+
+
+TEST_CASE("grid_tv: demo3x7")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const double lam = 0.1;
+    const double *y = (const double *)demo_3x7_y;
+
+    std::vector<double> xg(n);
+    GapMem<double> mem(xg.data(), y, n, m, 0);
+    mem.tol = 1e-12;
+    REQUIRE(gaplas<Boruvka>(mem, idx, Const<double>(lam), 100, false, Ones<double>())
+                .converged);
+
+    for (const unsigned threads : {1u, 3u}) {
+        CAPTURE(threads);
+        ThreadPool pool(threads);
+        GridTV<double> tv({7, 3});
+        std::vector<double> x(n);
+        const auto res = tv.solve(x.data(), y, lam, 5000, 1e-10, pool);
+        REQUIRE(res.converged);
+        CHECK(res.obj.back() == doctest::Approx(tv.objective(xg.data(), y, lam, pool)));
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(doctest::Approx(xg[i]).epsilon(1e-5) == x[i]);
+        }
+    }
+}
+
+
+TEST_CASE("grid_tv: 3d")
+{
+    TimerQuiet _;
+    const std::vector<size_t> dims {3, 4, 5};
+    const size_t n = 3 * 4 * 5;
+    std::vector<int> head, tail;
+    for (size_t i = 0; i < n; i++) {
+        const size_t c[3] = {i / 20, (i / 5) % 4, i % 5}, s[3] = {20, 5, 1};
+        for (size_t d = 0; d < 3; d++) {
+            if (c[d] + 1 < dims[d]) {
+                head.push_back(int(i));
+                tail.push_back(int(i + s[d]));
+            }
+        }
+    }
+    std::mt19937 rng(2021);
+    std::normal_distribution<double> normal;
+    std::vector<double> y(n);
+    for (auto &yi : y)
+        yi = normal(rng);
+    const double lam = 0.3;
+
+    const IncidenceIndex<int> idx(head, tail);
+    std::vector<double> xg(n);
+    GapMem<double> mem(xg.data(), y.data(), n, head.size(), 0);
+    mem.tol = 1e-12;
+    REQUIRE(gaplas<Boruvka>(mem, idx, Const<double>(lam), 500, false, Ones<double>())
+                .converged);
+
+    ThreadPool pool(4);
+    GridTV<double> tv(dims);
+    std::vector<double> x(n);
+    REQUIRE(tv.solve(x.data(), y.data(), lam, 10000, 1e-10, pool).converged);
+    for (size_t i = 0; i < n; i++) {
+        CAPTURE(i);
+        CHECK(doctest::Approx(xg[i]).epsilon(1e-4) == x[i]);
+    }
+}
+
+
+TEST_CASE("grid_tv: box and weights")
+{
+    const std::vector<double> y = {1, -2, 3, 0.5, -1, 2, 0, 4, 1, -1, 2, 3};
+    const double lam = 0.7;
+    ThreadPool pool(2);
+
+    GridTV<double> sub({2, 4});             // last two rows only
+    std::vector<double> xs(8);
+    REQUIRE(sub.solve(xs.data(), y.data() + 4, lam, 2000, 1e-12, pool).converged);
+
+    SUBCASE("box")
+    {
+        GridTV<double> tv({3, 4});
+        tv.lo = {1, 0};
+        tv.hi = {3, 4};
+        std::vector<double> x(y.size());
+        REQUIRE(tv.solve(x.data(), y.data(), lam, 2000, 1e-12, pool).converged);
+        for (size_t i = 0; i < y.size(); i++) {
+            CAPTURE(i);
+            CHECK(x[i] == doctest::Approx(i < 4 ? y[i] : xs[i - 4]));
+        }
+    }
+
+    SUBCASE("mu")
+    {
+        const std::vector<double> mu(8, 2.0);
+        std::vector<double> x(8);
+        REQUIRE(sub.solve(x.data(), y.data() + 4, 2 * lam, 2000, 1e-12, pool, false,
+                          mu.data())
+                    .converged);
+        for (size_t i = 0; i < x.size(); i++) {
+            CAPTURE(i);
+            CHECK(x[i] == doctest::Approx(xs[i]));
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../line_dp.hpp"
+#include "../line_stream.hpp"
+
+
+TEST_CASE("line_stream: as line_las")
+{
+    TimerQuiet _;
+    std::mt19937 rng(2021);
+    std::normal_distribution<double> normal;
+    for (const size_t n : {1, 2, 13, 1000}) {
+        std::vector<double> y(n);
+        for (auto &yi : y)
+            yi = normal(rng);
+        const Const<double> lam(0.4);
+        const auto x = line_las(y, lam);
+
+        for (const size_t block : {1, 7, 64, 5000}) {
+            CAPTURE(n);
+            CAPTURE(block);
+            std::vector<double> xs(n, -1.0);
+            size_t reads = 0, writes = 0;
+            line_las_stream(
+                n,
+                [&](size_t offset, size_t count, double *buf) {
+                    REQUIRE(count <= block);
+                    REQUIRE(offset + count <= n);
+                    std::copy(y.begin() + offset, y.begin() + offset + count, buf);
+                    reads++;
+                },
+                [&](size_t offset, size_t count, const double *buf) {
+                    REQUIRE(count <= block);
+                    std::copy(buf, buf + count, xs.begin() + offset);
+                    writes++;
+                },
+                lam,
+                block);
+            CHECK(reads == (n + block - 1) / block);
+            CHECK(writes == reads);
+            for (size_t i = 0; i < n; i++) {
+                CAPTURE(i);
+                CHECK(xs[i] == x[i]);
+            }
+        }
+    }
+}
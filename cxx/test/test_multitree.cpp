@@ -0,0 +1,170 @@
+#include <doctest/doctest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/grid.hpp>
+#include <graphidx/idx/incidence.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../gaplas.hpp"
+#include "../multitree.hpp"
+#include "demo3x7.hpp"
+
+
+/** Every edge in exactly one forest; every part is a tree over its edges. */
+template <typename int_t>
+static void
+check_forests(const MultiTree<int_t> &mt, const size_t max_degree)
+{
+    for (size_t e = 0; e < mt.m; e++) {
+        CAPTURE(e);
+        REQUIRE(mt.forest[e] >= 0);
+        REQUIRE(size_t(mt.forest[e]) < mt.num_forests);
+    }
+    std::vector<size_t> covered(mt.m, 0);
+    for (const auto &P : mt.parts) {
+        CAPTURE(P.begin);
+        REQUIRE(P.end - P.begin >= 2);
+        for (size_t i = P.begin; i < P.end; i++) {
+            if (P.line) {
+                if (i + 1 == P.end) {
+                    CHECK(mt.edge[i] < 0);
+                    continue;
+                }
+                const auto e = mt.edge[i];
+                const auto u = mt.node[i], v = mt.node[i + 1];
+                CHECK(std::min(u, v) == mt.head[e]);
+                CHECK(std::max(u, v) == mt.tail[e]);
+                covered[e]++;
+            } else if (i > P.begin) {
+                const auto e = mt.edge[i];
+                const auto u = mt.node[i], v = mt.node[P.begin + mt.local[i]];
+                CHECK(size_t(mt.local[i]) < i - P.begin);
+                CHECK(std::min(u, v) == mt.head[e]);
+                CHECK(std::max(u, v) == mt.tail[e]);
+                CHECK(max_degree != 2);
+                covered[e]++;
+            }
+        }
+    }
+    for (size_t e = 0; e < mt.m; e++) {
+        CAPTURE(e);
+        CHECK(covered[e] == 1);
+    }
+}
+
+
+TEST_CASE("multitree: grid decomposition")
+{
+    TimerQuiet _;
+    GridGraph graph {4, 6};
+    const IncidenceIndex<int> idx {graph};
+    for (const size_t max_degree : {2, 0}) {
+        CAPTURE(max_degree);
+        MultiTree<int> mt(idx, max_degree);
+        check_forests(mt, max_degree);
+        CHECK(mt.num_forests == 2);
+    }
+    MultiTree<int> mt(idx, 2, 4);
+    check_forests(mt, 2);
+    CHECK(mt.max_line <= 4);
+}
+
+
+TEST_CASE("multitree: demo3x7")
+{
+    TimerQuiet _;
+    GridGraph graph {3, 7};
+    const IncidenceIndex<int> idx {graph};
+    const size_t n = idx.num_nodes(), m = idx.num_edges();
+    const auto lam = Const<double>(0.1);
+    const double *y = (const double *)demo_3x7_y;
+
+    std::vector<double> xg(n);
+    GapMem<double> mem(xg.data(), y, n, m, 0);
+    mem.tol = 1e-12;
+    REQUIRE(gaplas<Boruvka>(mem, idx, lam, 100, false, Ones<double>()).converged);
+
+    for (const size_t max_degree : {2, 0}) {
+        for (const unsigned threads : {1u, 3u}) {
+            CAPTURE(max_degree);
+            CAPTURE(threads);
+            MultiTree<int> mt(idx, max_degree);
+            std::vector<double> x(n);
+            const auto res = mt.solve(x.data(), y, lam, 5000, 1e-10, threads);
+            CHECK(res.converged);
+            for (size_t i = 0; i < n; i++) {
+                CAPTURE(i);
+                CHECK(doctest::Approx(xg[i]).epsilon(1e-5) == x[i]);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("multitree: random graph")
+{
+    TimerQuiet _;
+    const size_t n = 200, m = 800;
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<int> node(0, int(n - 1));
+    std::normal_distribution<double> normal;
+    std::vector<int> head, tail;
+    for (size_t v = 1; v < n; v++) {
+        head.push_back(int(v));
+        tail.push_back(std::uniform_int_distribution<int>(0, int(v - 1))(rng));
+    }
+    while (head.size() < m) {
+        const int u = node(rng), v = node(rng);
+        if (u != v) {
+            head.push_back(u);
+            tail.push_back(v);
+        }
+    }
+    std::vector<double> y(n);
+    for (auto &yi : y)
+        yi = normal(rng);
+    const IncidenceIndex<int> idx(head, tail);
+    MultiTree<int> mt(idx, 2);
+    check_forests(mt, 2);
+    std::vector<double> x(n);
+    const auto res = mt.solve(x.data(), y.data(), Const<double>(0.2), 200, 1e-8, 4);
+    for (size_t k = 1; k < res.obj.size(); k++)
+        CHECK(res.obj[k] <= res.obj[0] + 1e-9);
+}
+
+
+TEST_CASE("multitree: tree parts on all threads")
+{
+    TimerQuiet _;
+    const size_t n = 3000, m = 9000;
+    std::mt19937 rng(2022);
+    std::uniform_int_distribution<int> node(0, int(n - 1));
+    std::normal_distribution<double> normal;
+    std::vector<int> head, tail;
+    while (head.size() < m) {
+        const int u = node(rng), v = node(rng);
+        if (u != v) {
+            head.push_back(u);
+            tail.push_back(v);
+        }
+    }
+    std::vector<double> y(n);
+    for (auto &yi : y)
+        yi = normal(rng);
+    const IncidenceIndex<int> idx(head, tail);
+    MultiTree<int> mt(idx, 0, 50);
+    check_forests(mt, 0);
+    size_t trees = 0;
+    for (const auto &P : mt.parts)
+        trees += !P.line;
+    REQUIRE(trees > 8);
+
+    std::vector<double> x1(n), x4(n);
+    const auto lam = Const<double>(0.3);
+    mt.solve(x1.data(), y.data(), lam, 20, 0.0, 1);
+    mt.solve(x4.data(), y.data(), lam, 20, 0.0, 4);
+    CHECK(x1 == x4);
+}
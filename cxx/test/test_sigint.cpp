@@ -0,0 +1,68 @@
+#include <doctest/doctest.h>
+#include <csignal>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>          // TimerQuiet
+
+#include "../sigint.hpp"
+#include "../tree_dp.hpp"
+
+
+TEST_CASE("sigint: token")
+{
+    Cancel none;
+    CHECK(!none.stop());
+    Cancel expired (0.0);
+    CHECK(expired.timed_out());
+    CHECK(!expired.cancelled());
+    Cancel later (3600.0);
+    CHECK(!later.stop());
+    later.cancel();
+    CHECK(later.stop());
+    CHECK(!Cancel(std::numeric_limits<double>::infinity()).stop());
+}
+
+
+TEST_CASE("sigint: Ctrl-C within scope")
+{
+    Cancel cancel;
+    {
+        SigintScope outer;
+        {
+            SigintScope inner;
+            CHECK(!cancel.stop());
+            std::raise(SIGINT);
+            CHECK(SigintScope::raised());
+            CHECK(cancel.stop());
+        }
+        CHECK(SigintScope::raised());
+    }
+    CHECK(!SigintScope::raised());
+    CHECK(!cancel.stop());
+}
+
+
+TEST_CASE("sigint: tree_dp")
+{
+    TimerQuiet _;
+    const size_t n = 10000;
+    std::vector<int> parent (n);
+    std::vector<double> y (n), x (n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = int(i / 2);
+        y[i] = double(i % 7);
+    }
+    TreeDPStatus s (n);
+    const auto solve = [&](const Cancel &cancel) {
+        tree_dp<false, true>(n, x.data(), y.data(), parent.data(), Const<double>(0.5),
+                             Ones<double>(), 0, s, nullptr, nullptr, &cancel);
+    };
+    Cancel cancel;
+    solve(cancel);
+    const auto expected = x;
+    cancel.cancel();
+    CHECK_THROWS_AS(solve(cancel), Interrupted);
+    solve(Cancel());
+    CHECK(x == expected);
+}
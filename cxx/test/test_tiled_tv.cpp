@@ -0,0 +1,108 @@
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+#include "../grid_tv.hpp"
+#include "../tiled_tv.hpp"
+
+
+static void
+check_tiled(
+    const std::vector<size_t> &dims,
+    const size_t tile,
+    const size_t overlap,
+    const double lam,
+    const unsigned threads)
+{
+    size_t n = 1;
+    for (const auto d : dims)
+        n *= d;
+    std::mt19937 rng(2021);
+    std::normal_distribution<double> normal;
+    std::vector<double> y(n);
+    for (auto &yi : y)
+        yi = normal(rng);
+
+    ThreadPool pool(threads);
+    GridTV<double> tv(dims);
+    std::vector<double> x(n);
+    REQUIRE(tv.solve(x.data(), y.data(), lam, 5000, 1e-11, pool).converged);
+
+    TiledTV<double> tiled(dims, tile, overlap);
+    REQUIRE(tiled.tiles.size() > 1);
+    tiled.inner_tol = 1e-10;
+    tiled.inner_iter = 2000;
+    tiled.load([&](size_t t, double *yt) {
+        const auto &T = tiled.tiles[t];
+        size_t k = 0;
+        for (size_t i = 0; i < n; i++) {    // C-order: i runs fastest in last dim
+            bool inside = true;
+            size_t r = i;
+            for (size_t d = dims.size(); d-- > 0;) {
+                const size_t c = r % dims[d];
+                r /= dims[d];
+                inside = inside && T.lo[d] <= c && c < T.hi[d];
+            }
+            if (inside)
+                yt[k++] = y[i];
+        }
+        REQUIRE(k == T.size());
+    });
+    const auto res = tiled.solve(lam, 1000, 1e-8, pool);
+    REQUIRE(res.converged);
+    CHECK(res.obj.back() == doctest::Approx(tv.objective(x.data(), y.data(), lam, pool)));
+
+    // assemble the cores
+    std::vector<double> xt(n, -1e10);
+    for (size_t t = 0; t < tiled.tiles.size(); t++) {
+        const auto &T = tiled.tiles[t];
+        const auto c = tiled.core(t);
+        size_t k = 0;
+        for (size_t i = 0; i < n; i++) {
+            bool inside = true;
+            size_t r = i;
+            for (size_t d = dims.size(); d-- > 0;) {
+                const size_t cd = r % dims[d];
+                r /= dims[d];
+                inside = inside && T.core_lo[d] <= cd && cd < T.core_hi[d];
+            }
+            if (inside)
+                xt[i] = c[k++];
+        }
+        REQUIRE(k == c.size());
+    }
+    for (size_t i = 0; i < n; i++) {
+        CAPTURE(i);
+        CHECK(doctest::Approx(x[i]).epsilon(1e-5) == xt[i]);
+    }
+}
+
+
+TEST_CASE("tiled_tv: tiles")
+{
+    TiledTV<double> tiled({7, 10}, 4, 2);
+    REQUIRE(tiled.tiles.size() == 2 * 3);
+    const auto &T = tiled.tiles[4];         // second row, second column
+    CHECK(T.core_lo == std::vector<size_t>({4, 4}));
+    CHECK(T.core_hi == std::vector<size_t>({7, 8}));
+    CHECK(T.lo == std::vector<size_t>({2, 2}));
+    CHECK(T.hi == std::vector<size_t>({7, 10}));
+    CHECK(T.size() == 5 * 8);
+    CHECK(T.core_size() == 3 * 4);
+    CHECK_THROWS_AS(TiledTV<double>({7, 10}, 4, 0), std::invalid_argument);
+    const TiledTV<double> single({3, 3}, 4, 0);
+    CHECK(single.tiles.size() == 1);
+}
+
+
+TEST_CASE("tiled_tv: 2d")
+{
+    SUBCASE("overlap 1") { check_tiled({9, 11}, 4, 1, 0.4, 1); }
+    SUBCASE("overlap 3") { check_tiled({9, 11}, 5, 3, 0.4, 3); }
+}
+
+
+TEST_CASE("tiled_tv: 3d")
+{
+    check_tiled({4, 5, 6}, 3, 1, 0.3, 2);
+}
@@ -0,0 +1,118 @@
+#include <doctest/doctest.h>
+#include <cstddef>          // offsetof
+#include <cstdio>           // std::remove
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../tree_bin.hpp"
+#include "../tree_dp.hpp"
+
+
+TEST_CASE("tree_bin: write, map and solve")
+{
+    TimerQuiet _;
+    const char *fname = "test_tree_bin.bin";
+    const size_t n = 1000;
+    std::mt19937 rng(2021);
+    std::normal_distribution<double> normal;
+    std::vector<int> parent(n, 0);
+    std::vector<double> y(n);
+    for (size_t i = 1; i < n; i++)
+        parent[i] = int(rng() % i);
+    for (auto &yi : y)
+        yi = normal(rng);
+    const std::vector<double> lam {0.3};
+
+    TreeBinWriter(n, 0)
+        .add("y", y)
+        .add("lam", lam)
+        .add("parent", parent)
+        .write(fname);
+    REQUIRE(TreeBin::is_treebin(fname));
+
+    {
+        const TreeBin tb(fname);
+        REQUIRE(tb.size() == n);
+        CHECK(tb.root() == 0);
+        CHECK(tb.has("y"));
+        CHECK(!tb.has("dfs"));
+        CHECK(tb.get<int>("dfs") == nullptr);
+        CHECK_THROWS_AS(tb.at<int>("dfs"), std::runtime_error);
+        CHECK_THROWS_AS(tb.get<double>("parent"), std::runtime_error);
+        REQUIRE(tb.length("lam") == 1);
+
+        const double *ty = tb.at<double>("y");
+        const int *tp = tb.at<int>("parent");
+        CHECK(reinterpret_cast<uintptr_t>(ty) % TreeBin::ALIGN == 0);
+        CHECK(reinterpret_cast<uintptr_t>(tp) % TreeBin::ALIGN == 0);
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            REQUIRE(ty[i] == y[i]);
+            REQUIRE(tp[i] == parent[i]);
+        }
+
+        std::vector<double> x(n), xm(n);
+        const Const<double> clam(lam[0]);
+        tree_dp<true, false>(n, x.data(), y.data(), parent.data(), clam, Ones<double>(), 0);
+        tree_dp<true, false>(n,
+                             xm.data(),
+                             ty,
+                             tp,
+                             Const<double>(tb.at<double>("lam")[0]),
+                             Ones<double>(),
+                             int(tb.root()));
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(xm[i] == x[i]);
+        }
+    }
+    std::remove(fname);
+    CHECK(!TreeBin::is_treebin(fname));
+}
+
+
+TEST_CASE("tree_bin: reject other files")
+{
+    const char *fname = "test_tree_bin.txt";
+    FILE *f = fopen(fname, "w");
+    REQUIRE(f != nullptr);
+    fprintf(f, "no tree in here, just some text\n");
+    fclose(f);
+    CHECK(!TreeBin::is_treebin(fname));
+    CHECK_THROWS_AS(TreeBin {fname}, std::runtime_error);
+    std::remove(fname);
+    CHECK_THROWS_AS(TreeBin {fname}, std::runtime_error);
+}
+
+
+TEST_CASE("tree_bin: check array lengths")
+{
+    const char *fname = "test_tree_bin_len.bin";
+    const std::vector<double> y(10, 1.0), lam;
+    const std::vector<int> parent(9, 0);
+    TreeBinWriter(10, 0).add("y", y).add("lam", lam).add("parent", parent).write(fname);
+    {
+        const TreeBin tb(fname);
+        CHECK(tb.at<double>("y", 10) != nullptr);
+        CHECK_THROWS_AS(tb.at<int>("parent", 10), std::runtime_error);
+        CHECK_THROWS_AS(tb.get<int>("parent", 10), std::runtime_error);
+        CHECK(tb.get<int>("postorder", 10) == nullptr);
+        CHECK_THROWS_AS(tb.first<double>("lam"), std::runtime_error);
+        CHECK(tb.first<double>("y") == 1.0);
+    }
+
+    // an array length whose byte size overflows
+    FILE *f = fopen(fname, "r+b");
+    REQUIRE(f != nullptr);
+    const uint64_t huge = uint64_t(1) << 61;
+    const long pos = long(sizeof(treebin::Header) + offsetof(treebin::Entry, length));
+    REQUIRE(fseek(f, pos, SEEK_SET) == 0);
+    REQUIRE(fwrite(&huge, sizeof(huge), 1, f) == 1);
+    fclose(f);
+    CHECK_THROWS_AS(TreeBin {fname}, std::runtime_error);
+    std::remove(fname);
+}
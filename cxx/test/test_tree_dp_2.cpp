@@ -1,8 +1,12 @@
 #include <doctest/doctest.h>
+#include <cmath>
+#include <random>
+#include <thread>
 #include <vector>
 #include <graphidx/utils/timer.hpp>          // TimerQuiet
 #include <graphidx/bits/weights.hpp>
 
+#include "../strided.hpp"
 #include "../tree_dp.hpp"
 
 
@@ -15,3 +19,202 @@ TEST_CASE("tree_dp: two nodes")
     const double lam = 0.2;
     auto x = tree_dp<>(y, parent, lam, root);
 }
+
+
+TEST_CASE("tree_dp: stored orders")
+{
+    TimerQuiet _;
+    const std::vector<int> parent = {0, 0, 0, 1, 1, 2, 2};
+    const std::vector<double> y = {0.0, 0.5, 0.0, 1.0, 3.0, 0.0, 2.0};
+    const size_t n = parent.size();
+    const int root = 0;
+    std::vector<int> postorder, queue_start;
+    tree_orders(n, parent.data(), root, postorder, queue_start);
+    REQUIRE(postorder == std::vector<int>({6, 5, 2, 4, 3, 1, 0}));
+    REQUIRE(queue_start.size() == n);
+
+    for (const double lam : {0.01, 0.3, 1.0, 5.0}) {
+        CAPTURE(lam);
+        const auto x = tree_dp<true, false>(y, parent, lam, root);
+        std::vector<double> xs(n);
+        TreeDPStatus s(n, false);
+        tree_dp<true, false>(n,
+                             xs.data(),
+                             y.data(),
+                             parent.data(),
+                             Const<double>(lam),
+                             Ones<double>(),
+                             -1,
+                             s,
+                             postorder.data(),
+                             queue_start.data());
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(xs[i] == x[i]);
+        }
+    }
+}
+
+
+TEST_CASE("tree_dp: strided views")
+{
+    TimerQuiet _;
+    const std::vector<int> parent = {0, 0, 0, 1, 1, 2, 2};
+    const std::vector<double> y = {0.0, 0.5, 0.0, 1.0, 3.0, 0.0, 2.0};
+    const size_t n = parent.size();
+    const double lam = 0.3;
+    const auto x = tree_dp<false, true>(y, parent, lam, 0);
+
+    // y in every other element, x as float in every third element
+    std::vector<double> y2 (2*n);
+    std::vector<float> x3 (3*n, -1.0f);
+    for (size_t i = 0; i < n; i++)
+        y2[2*i] = y[i];
+    TreeDPStatus s(n);
+    tree_dp<false, true>(n,
+                         strided(x3.data(), 3),
+                         strided(static_cast<const double *>(y2.data()), 2),
+                         parent.data(),
+                         Const<double>(lam),
+                         Ones<double>(),
+                         0,
+                         s);
+    for (size_t i = 0; i < n; i++) {
+        CAPTURE(i);
+        CHECK(x3[3*i] == doctest::Approx(x[i]).epsilon(1e-6));
+        CHECK(x3[3*i+1] == -1.0f);
+    }
+}
+
+
+TEST_CASE("tree_dp: fused dual")
+{
+    TimerQuiet _;
+    const size_t n = 2000;
+    std::mt19937 rng(2021);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::vector<int> parent (n);
+    std::vector<double> y (n), lam (n), mu (n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i == 0 ? 0 : int(unif(rng) * double(i));
+        y[i] = std::round(8.0 * unif(rng));
+        lam[i] = 0.5 * unif(rng);
+        mu[i] = unif(rng) < 0.1 ? 0.0 : unif(rng) + 0.1;
+    }
+    mu[0] = 1.0;
+    const Array<const double> l (lam.data()), m (mu.data());
+
+    std::vector<double> x (n), xd (n), alpha (n);
+    TreeDPStatus s(n);
+    tree_dp<false, true>(n, x.data(), y.data(), parent.data(), l, m, 0, s);
+    TreeDPDual dual;
+    dual.alpha = alpha.data();
+    tree_dp<false, true>(n, xd.data(), y.data(), parent.data(), l, m, 0, s,
+                         nullptr, nullptr, nullptr, &dual);
+    CHECK(xd == x);
+
+    // reference: subtree sums of the residuals (parent[i] < i), edge gaps
+    std::vector<double> z (n);
+    double primal = 0.0, gap = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        z[i] = mu[i] * (x[i] - y[i]);
+        primal += 0.5 * mu[i] * (x[i] - y[i]) * (x[i] - y[i]) +
+            lam[i] * std::abs(x[i] - x[parent[i]]);
+    }
+    for (size_t i = n-1; i > 0; i--) {
+        CAPTURE(i);
+        CHECK(alpha[i] == doctest::Approx(z[i]).epsilon(1e-9));
+        CHECK(std::abs(alpha[i]) <= lam[i] + 1e-9);
+        const double d = x[i] - x[parent[i]];
+        gap += z[i] * d + lam[i] * std::abs(d);
+        z[parent[i]] += z[i];
+    }
+    CHECK(std::isnan(alpha[0]));
+    CHECK(dual.primal == doctest::Approx(primal).epsilon(1e-12));
+    CHECK(std::abs(dual.gap - gap) < 1e-9 * dual.primal);
+    CHECK(std::abs(dual.gap) < 1e-8 * dual.primal);
+    CHECK(std::abs(dual.primal - dual.dual - dual.gap) < 1e-9 * dual.primal);
+}
+
+
+TEST_CASE("tree_dp: compact queues")
+{
+    TimerQuiet _;
+    // quantized signal (many equal events) on a random tree
+    const size_t n = 5000;
+    std::mt19937 rng(2021);
+    std::uniform_int_distribution<int> level(0, 7);
+    std::vector<int> parent(n);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i == 0 ? 0 : int(rng() % i);
+        y[i] = double(level(rng));
+    }
+    const auto solve = [&](bool merge_sort, bool lazy_sort, bool compact,
+                           std::vector<double> &x) {
+        x.resize(n);
+        TreeDPStatus s(n);
+        s.compact = compact;
+        const Const<double> lam(0.5);
+        const Ones<double> mu;
+        if (merge_sort)
+            tree_dp<true, false>(n, x.data(), y.data(), parent.data(), lam, mu, 0, s);
+        else if (lazy_sort)
+            tree_dp<false, true>(n, x.data(), y.data(), parent.data(), lam, mu, 0, s);
+        else
+            tree_dp<false, false>(n, x.data(), y.data(), parent.data(), lam, mu, 0, s);
+        return s.merged;
+    };
+    std::vector<double> x, xc;
+    for (const bool merge_sort : {true, false}) {
+        for (const bool lazy_sort : {true, false}) {
+            CAPTURE(merge_sort);
+            CAPTURE(lazy_sort);
+            const size_t merged = solve(merge_sort, lazy_sort, false, x);
+            const size_t merged_c = solve(merge_sort, lazy_sort, true, xc);
+            CHECK(merged_c < merged);
+            // not bit-identical: coalesced slopes change the rounding
+            for (size_t i = 0; i < n; i++) {
+                CAPTURE(i);
+                CHECK(std::abs(xc[i] - x[i]) < 1e-12);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("tree_dp: concurrent merge2 solves")
+{
+    TimerQuiet _;
+    const size_t n = 20000;
+    const unsigned threads = 4;
+    std::mt19937 rng(2022);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::vector<int> parent(n);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i == 0 ? 0 : int(rng() % i);
+        y[i] = unif(rng);
+    }
+    const auto solve = [&](std::vector<double> &x, const double lam) {
+        x.resize(n);
+        TreeDPStatus s(n);
+        tree_dp<true, false>(n, x.data(), y.data(), parent.data(), Const<double>(lam),
+                             Ones<double>(), 0, s);
+    };
+    std::vector<std::vector<double>> expected(threads), x(threads);
+    for (unsigned t = 0; t < threads; t++)
+        solve(expected[t], 0.1 * (t + 1));
+    for (int rep = 0; rep < 3; rep++) {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++)
+            pool.emplace_back([&, t]() { solve(x[t], 0.1 * (t + 1)); });
+        for (auto &th : pool)
+            th.join();
+        for (unsigned t = 0; t < threads; t++) {
+            CAPTURE(rep);
+            CAPTURE(t);
+            CHECK(x[t] == expected[t]);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <doctest/doctest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>          // TimerQuiet
+
+#include "../merge.hpp"
+#include "../tree_dual_par.hpp"
+
+
+TEST_CASE("tree_dual_par: subtree sums")
+{
+    TimerQuiet _;
+    const size_t n = 20000;
+    std::mt19937 rng(2021);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::vector<int> parent (n);
+    std::vector<double> z (n), x (n), lam (n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i == 0 ? 0 : int(unif(rng) * double(i));
+        z[i] = unif(rng) - 0.5;
+        x[i] = std::round(4.0 * unif(rng));
+        lam[i] = unif(rng) + 0.1;
+    }
+    const int root = 0;
+
+    // orders with the subtree starts recorded by the DFS
+    uvector<Range> pq (n);
+    std::vector<int> postorder, first (n), first2 (n);
+    ChildrenIndex childs (n, parent.data(), root);
+    stack<int> stack;
+    init_queues(n, pq, postorder, childs, stack, root, first.data());
+    REQUIRE(postorder.size() == n - 1);
+    subtree_first(n, parent.data(), postorder.data(), root, first2.data());
+    CHECK(first == first2);
+
+    // reference: sequential sweep (parent[i] < i)
+    std::vector<double> expected (z);
+    for (size_t i = n-1; i > 0; i--)
+        expected[parent[i]] += expected[i];
+
+    std::vector<double> prefix;
+    for (const unsigned threads : {1u, 4u}) {
+        CAPTURE(threads);
+        std::vector<double> alpha (n);
+        tree_dual_par(n, alpha.data(), z.data(), postorder.data(), first.data(), root,
+                      prefix, threads);
+        for (size_t i = 0; i < n; i++) {
+            CAPTURE(i);
+            CHECK(std::abs(alpha[i] - expected[i]) < 1e-9);
+        }
+        auto inplace = z;
+        tree_dual_par(n, inplace.data(), inplace.data(), postorder.data(), first.data(),
+                      root, prefix, threads);
+        CHECK(inplace == alpha);
+    }
+
+    std::vector<double> gamma (n), gamma2 (n);
+    double gap = 0.0;
+    for (size_t i = 1; i < n; i++) {
+        const double diff = x[i] - x[parent[i]];
+        gamma[i] = expected[i] / lam[i] * diff + std::abs(diff);
+        gap += lam[i] * gamma[i];
+    }
+    gamma[0] = -1.0;
+    const double gap2 = tree_dual_gap_par(n, gamma2.data(), x.data(), expected.data(),
+                                          Array<const double>(lam.data()),
+                                          parent.data(), -1.0, 3);
+    CHECK(gamma2 == gamma);
+    CHECK(std::abs(gap2 - gap) < 1e-9 * std::abs(gap));
+}
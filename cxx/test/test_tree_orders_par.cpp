@@ -0,0 +1,110 @@
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>          // TimerQuiet
+
+#include "../merge.hpp"
+#include "../tree_orders_par.hpp"
+
+
+/** Random tree (`kind` 0), star (1) or line (2) with shuffled labels */
+static std::vector<int>
+shuffled_tree(const size_t n, const int kind, const unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<int> label (n), parent (n);
+    std::iota(label.begin(), label.end(), 0);
+    std::shuffle(label.begin(), label.end(), rng);
+    for (size_t i = 0; i < n; i++) {
+        const size_t p = i == 0 ? 0
+            : kind == 0 ? std::uniform_int_distribution<size_t>(0, i-1)(rng)
+            : kind == 1 ? 0 : i-1;
+        parent[label[i]] = label[p];
+    }
+    return parent;
+}
+
+
+static void
+check_orders(const std::vector<int> &parent, const unsigned threads)
+{
+    const size_t n = parent.size();
+    const int root = find_root(n, parent.data());
+    CHECK(find_root_par(n, parent.data(), threads) == root);
+
+    uvector<Range> pq (n), pq2 (n);
+    std::vector<int> proc_order, proc_order2, first (n), first2 (n);
+    ChildrenIndex childs (n, parent.data(), root);
+    stack<int> stack;
+    init_queues(n, pq, proc_order, childs, stack, root, first.data());
+
+    TreeOrdersPar<int> orders (threads);
+    orders.reset(n, parent.data());
+    REQUIRE(orders.root == root);
+    orders.init_queues(pq2, proc_order2, first2.data());
+    CHECK(proc_order2 == proc_order);
+    CHECK(first2 == first);
+    for (size_t i = 0; i < n; i++) {
+        CAPTURE(i);
+        CHECK(pq2[i] == pq[i]);
+    }
+
+    std::vector<int> postorder, queue_start, postorder2, queue_start2;
+    tree_orders(n, parent.data(), root, postorder, queue_start);
+    orders.tree_orders(postorder2, queue_start2);
+    CHECK(postorder2 == postorder);
+    CHECK(queue_start2 == queue_start);
+
+    // reversed BFS: every node after its children, root last
+    std::vector<int> order (n), pos (n);
+    orders.reversed_bfs(order.data());
+    for (size_t k = 0; k < n; k++)
+        pos[order[k]] = int(k);
+    CHECK(order[n-1] == root);
+    for (size_t i = 0; i < n; i++)
+        if (int(i) != root)
+            CHECK(pos[i] < pos[parent[i]]);
+}
+
+
+TEST_CASE("tree_orders_par: same orders as init_queues")
+{
+    TimerQuiet _;
+    const size_t n = 30000;
+    for (const int kind : {0, 1, 2}) {
+        CAPTURE(kind);
+        const auto parent = shuffled_tree(n, kind, 2021 + kind);
+        for (const unsigned threads : {1u, 4u}) {
+            CAPTURE(threads);
+            check_orders(parent, threads);
+        }
+    }
+}
+
+
+TEST_CASE("tree_orders_par: small trees")
+{
+    TimerQuiet _;
+    for (const size_t n : {1, 2, 3, 10}) {
+        CAPTURE(n);
+        check_orders(shuffled_tree(n, 0, 7), 2);
+    }
+}
+
+
+TEST_CASE("tree_orders_par: not a tree")
+{
+    // two roots: the subtree of 3 is not reached from the first root 0
+    const std::vector<int> parent {0, 0, 1, 3, 3};
+    TreeOrdersPar<int> orders (2);
+    CHECK_THROWS_AS(orders.reset(parent.size(), parent.data()), std::invalid_argument);
+
+    const std::vector<int> cycle {1, 2, 0};
+    CHECK(find_root_par(cycle.size(), cycle.data(), 2) == -1);
+    CHECK_THROWS_AS(orders.reset(cycle.size(), cycle.data()), std::invalid_argument);
+}
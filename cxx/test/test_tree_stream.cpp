@@ -0,0 +1,85 @@
+#include <doctest/doctest.h>
+#include <numeric>          // std::iota
+#include <random>
+#include <vector>
+
+#include <graphidx/bits/weights.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "../tree_dp.hpp"
+#include "../tree_stream.hpp"
+
+
+TEST_CASE("tree_stream: as tree_dp")
+{
+    TimerQuiet _;
+    std::mt19937 rng(2021);
+    std::normal_distribution<double> normal;
+    for (const size_t n : {1, 2, 7, 500}) {
+        // random tree with shuffled labels
+        std::vector<int> label(n), parent(n);
+        std::iota(label.begin(), label.end(), 0);
+        std::shuffle(label.begin(), label.end(), rng);
+        for (size_t i = 0; i < n; i++)
+            parent[label[i]] =
+                label[i > 0 ? std::uniform_int_distribution<size_t>(0, i-1)(rng) : 0];
+        const int root = label[0];
+        std::vector<double> y(n), mu(n);
+        for (size_t i = 0; i < n; i++) {
+            y[i] = normal(rng);
+            mu[i] = i % 5 == 1 ? 0.0 : 1.0;
+        }
+        std::vector<int> postorder, queue_start;
+        tree_orders(n, parent.data(), root, postorder, queue_start);
+
+        const Const<double> lam(0.3);
+        const Array<const double> amu(mu.data());
+        std::vector<double> x(n);
+        tree_dp<true, false>(n, x.data(), y.data(), parent.data(), lam, amu, root);
+
+        for (const size_t block : {1, 3, 64, 5000}) {
+            CAPTURE(n);
+            CAPTURE(block);
+            std::vector<double> xs(n, -1.0);
+            size_t written = 0;
+            tree_dp_stream(
+                n,
+                y.data(),
+                parent.data(),
+                postorder.data(),
+                queue_start.data(),
+                lam,
+                amu,
+                [&](const int *nodes, const double *xb, size_t count) {
+                    REQUIRE(count <= block);
+                    for (size_t j = 0; j < count; j++)
+                        xs[nodes[j]] = xb[j];
+                    written += count;
+                },
+                block);
+            CHECK(written == n);
+            for (size_t i = 0; i < n; i++) {
+                CAPTURE(i);
+                CHECK(xs[i] == x[i]);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("tree_stream: invalid postorder")
+{
+    TimerQuiet _;
+    const std::vector<int> parent = {0, 0, 0};
+    const std::vector<double> y = {0.0, 1.0, 2.0};
+    const std::vector<int> postorder = {1, 0, 2}, queue_start = {6, 2, 4};
+    CHECK_THROWS_AS(tree_dp_stream(3,
+                                   y.data(),
+                                   parent.data(),
+                                   postorder.data(),
+                                   queue_start.data(),
+                                   Const<double>(1.0),
+                                   Ones<double>(),
+                                   [](const int *, const double *, size_t) {}),
+                    std::invalid_argument);
+}
@@ -0,0 +1,378 @@
+/**
+   Total variation (as in grid_tv.hpp) of images too large to be solved as
+   a whole: the image is partitioned into tiles; every tile owns the data
+   term of its core and the edges starting there and is extended by
+   `overlap` nodes on every side (at least one, so that it contains the
+   edges leaving its core).  The tiles are solved independently (in
+   parallel, by `GridTV`) and coordinated by consensus ADMM
+   (Boyd et al., "Distributed Optimization and Statistical Learning via
+   the Alternating Direction Method of Multipliers", 2011, Section 7.2):
+
+       x_t = argmin f_t(x) + ρ/2 ||x - z_t + u_t||²
+       z   = mean_t (x_t + u_t)
+       u_t = u_t + x_t - z_t
+
+   until the primal residual max |x_t - z_t| and the dual residual
+   ρ max |z - z_prev| are below `tol`.
+ */
+#pragma once
+#include <algorithm>        // std::min, std::max
+#include <chrono>
+#include <cmath>            // std::abs
+#include <iostream>
+#include <memory>           // std::unique_ptr
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_tv.hpp"
+#include "parallel.hpp"
+#include "split.hpp"
+
+
+template <typename float_t = double>
+struct TiledTV
+{
+    /** Boxes in global coordinates (per dimension, end exclusive) */
+    struct Tile
+    {
+        std::vector<size_t> lo, hi;         // tile including the overlap
+        std::vector<size_t> core_lo, core_hi;
+
+        size_t size() const;
+        size_t core_size() const;
+    };
+
+    std::vector<size_t> dims;               // C-order
+    std::vector<Tile> tiles;
+    double rho = 1.0;                       // ADMM penalty
+    size_t inner_iter = 10;                 // GridTV iterations per tile solve
+    double inner_tol = 1e-10;               // (warm started)
+
+    /** Cores of (at most) `tile` nodes per dimension */
+    TiledTV(const std::vector<size_t> &dims, const size_t tile, const size_t overlap);
+
+    /** Call `load(t, y_t)` for every tile `t` (sequentially, e.g. to read
+        a HDF5 hyperslab) whereby `y_t` has to be filled in C-order. */
+    template <typename Load>
+    void load(Load load);
+
+    SplitResult solve(
+        const double lam,
+        const size_t max_iter,
+        const double tol,
+        ThreadPool &pool,
+        const bool verbose = false);
+
+    /** Solution on the core of tile `t` (C-order) */
+    std::vector<float_t> core(const size_t t) const;
+
+private:
+    std::vector<std::vector<float_t>> y, x, u;
+    std::vector<float_t> z;
+    std::vector<GridTV<float_t>> tvs;
+    std::vector<std::vector<size_t>> near;  // tiles overlapping the core of t
+
+    size_t global(const Tile &T, size_t k) const;  // index of local node k
+    GridTV<float_t> tile_tv(const Tile &T) const;  // edges of the core
+};
+
+
+template <typename float_t>
+size_t
+TiledTV<float_t>::Tile::size() const
+{
+    size_t s = 1;
+    for (size_t d = 0; d < lo.size(); d++)
+        s *= hi[d] - lo[d];
+    return s;
+}
+
+
+template <typename float_t>
+size_t
+TiledTV<float_t>::Tile::core_size() const
+{
+    size_t s = 1;
+    for (size_t d = 0; d < lo.size(); d++)
+        s *= core_hi[d] - core_lo[d];
+    return s;
+}
+
+
+template <typename float_t>
+TiledTV<float_t>::TiledTV(
+    const std::vector<size_t> &dims, const size_t tile, const size_t overlap)
+    : dims(dims)
+{
+    const size_t D = dims.size();
+    if (D == 0 || D > 3)
+        throw std::invalid_argument(
+            std::string("TiledTV: need 1 to 3 dimensions, got ") + std::to_string(D));
+    if (tile == 0)
+        throw std::invalid_argument("TiledTV: tile size must be positive");
+    std::vector<size_t> num(D), c(D, 0);
+    size_t total = 1;
+    for (size_t d = 0; d < D; d++) {
+        num[d] = (dims[d] + tile - 1) / tile;
+        if (num[d] > 1 && overlap == 0)
+            throw std::invalid_argument("TiledTV: need an overlap of at least 1");
+        total *= num[d];
+    }
+    for (size_t t = 0; t < total; t++) {
+        Tile T;
+        for (size_t d = 0; d < D; d++) {
+            T.core_lo.push_back(c[d] * tile);
+            T.core_hi.push_back(std::min(dims[d], (c[d] + 1) * tile));
+            T.lo.push_back(T.core_lo[d] - std::min(T.core_lo[d], overlap));
+            T.hi.push_back(std::min(dims[d], T.core_hi[d] + overlap));
+        }
+        tiles.push_back(T);
+        for (size_t d = D; d-- > 0;) {      // next tile in C-order
+            if (++c[d] < num[d])
+                break;
+            c[d] = 0;
+        }
+    }
+
+    near.resize(tiles.size());
+    for (size_t t = 0; t < tiles.size(); t++) {
+        for (size_t s = 0; s < tiles.size(); s++) {
+            bool overlaps = true;
+            for (size_t d = 0; d < D; d++)
+                overlaps = overlaps && tiles[s].lo[d] < tiles[t].core_hi[d] &&
+                           tiles[t].core_lo[d] < tiles[s].hi[d];
+            if (overlaps)
+                near[t].push_back(s);
+        }
+    }
+}
+
+
+template <typename float_t>
+size_t
+TiledTV<float_t>::global(const Tile &T, size_t k) const
+{
+    size_t g = 0, s = 1;
+    for (size_t d = dims.size(); d-- > 0;) {
+        const size_t len = T.hi[d] - T.lo[d];
+        g += (T.lo[d] + k % len) * s;
+        k /= len;
+        s *= dims[d];
+    }
+    return g;
+}
+
+
+template <typename float_t>
+GridTV<float_t>
+TiledTV<float_t>::tile_tv(const Tile &T) const
+{
+    std::vector<size_t> len(dims.size());
+    for (size_t d = 0; d < dims.size(); d++)
+        len[d] = T.hi[d] - T.lo[d];
+    GridTV<float_t> tv(len);
+    for (size_t d = 0; d < dims.size(); d++) {
+        tv.lo.push_back(T.core_lo[d] - T.lo[d]);
+        tv.hi.push_back(T.core_hi[d] - T.lo[d]);
+    }
+    return tv;
+}
+
+
+template <typename float_t>
+template <typename Load>
+void
+TiledTV<float_t>::load(Load load)
+{
+    size_t n = 1;
+    for (const auto d : dims)
+        n *= d;
+    z.assign(n, 0);
+    y.resize(tiles.size());
+    x.resize(tiles.size());
+    u.resize(tiles.size());
+    tvs.clear();
+    for (size_t t = 0; t < tiles.size(); t++) {
+        tvs.push_back(tile_tv(tiles[t]));
+        tvs.back().warm = true;
+        y[t].resize(tiles[t].size());
+        load(t, y[t].data());
+        x[t] = y[t];
+        u[t].assign(y[t].size(), 0);
+        for (size_t k = 0; k < y[t].size(); k++)
+            z[global(tiles[t], k)] = y[t][k];
+    }
+}
+
+
+template <typename float_t>
+SplitResult
+TiledTV<float_t>::solve(
+    const double lam,
+    const size_t max_iter,
+    const double tol,
+    ThreadPool &pool,
+    const bool verbose)
+{
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const size_t D = dims.size();
+    if (z.empty())
+        throw std::runtime_error("TiledTV::solve(): call load() first");
+
+    std::vector<std::unique_ptr<ThreadPool>> inner;  // one thread per tile
+    for (unsigned th = 0; th < pool.size(); th++)
+        inner.emplace_back(new ThreadPool(1));
+    std::vector<double> rs(tiles.size()), ss(tiles.size()), objs(tiles.size());
+    std::vector<std::vector<float_t>> zt(pool.size()), mu(pool.size());
+
+    const auto in_core = [&](const Tile &T, const size_t g) {
+        size_t r = g;
+        for (size_t d = D; d-- > 0;) {
+            const size_t c = r % dims[d];
+            r /= dims[d];
+            if (c < T.core_lo[d] || c >= T.core_hi[d])
+                return false;
+        }
+        return true;
+    };
+    const auto contains = [&](const Tile &T, size_t g, size_t &k) {
+        size_t s = 1;
+        k = 0;
+        for (size_t d = D; d-- > 0;) {
+            const size_t c = g % dims[d];
+            g /= dims[d];
+            if (c < T.lo[d] || c >= T.hi[d])
+                return false;
+            k += (c - T.lo[d]) * s;
+            s *= T.hi[d] - T.lo[d];
+        }
+        return true;
+    };
+
+    // objective of the consensus `z`: every tile contributes its core
+    const auto objective = [&]() {
+        pool.run(tiles.size(), [&](size_t t, unsigned th) {
+            const auto &T = tiles[t];
+            const auto &tv = tvs[t];
+            zt[th].resize(T.size());
+            mu[th].resize(T.size());
+            for (size_t k = 0; k < T.size(); k++) {
+                const size_t g = global(T, k);
+                zt[th][k] = z[g];
+                mu[th][k] = in_core(T, g) ? float_t(1) : float_t(0);
+            }
+            objs[t] =
+                tv.objective(zt[th].data(), y[t].data(), lam, *inner[th], mu[th].data());
+        });
+        double s = 0.0;
+        for (const auto o : objs)
+            s += o;
+        return s;
+    };
+
+    SplitResult res;
+    double delta = 0.0;
+    for (size_t it = 0; true; it++) {
+        const double secs = std::chrono::duration<double>(clock::now() - start).count();
+        res.obj.push_back(objective());
+        res.delta.push_back(it == 0 ? 0.0 : delta);
+        res.time.push_back(secs);
+        if (verbose)
+            std::cout << it << '\t' << res.obj.back() << '\t' << res.delta.back() << '\t'
+                      << secs << std::endl;
+        if (it > 0 && delta <= tol) {
+            res.converged = true;
+            break;
+        }
+        if (it >= max_iter)
+            break;
+
+        // x-update: weighted TV of the tile (data term only on the core)
+        pool.run(tiles.size(), [&](size_t t, unsigned th) {
+            const auto &T = tiles[t];
+            auto &tv = tvs[t];
+            auto &v = zt[th];
+            v.resize(T.size());
+            mu[th].resize(T.size());
+            for (size_t k = 0; k < T.size(); k++) {
+                const size_t g = global(T, k);
+                const double m = in_core(T, g) ? 1.0 : 0.0;
+                mu[th][k] = float_t(m + rho);
+                v[k] = float_t((m * y[t][k] + rho * (z[g] - u[t][k])) / (m + rho));
+            }
+            tv.solve(
+                x[t].data(),
+                v.data(),
+                lam,
+                inner_iter,
+                inner_tol,
+                *inner[th],
+                false,
+                mu[th].data());
+        });
+
+        // z-update on the cores (disjoint); dual residual
+        pool.run(tiles.size(), [&](size_t t, unsigned) {
+            const auto &T = tiles[t];
+            double s = 0.0;
+            for (size_t k = 0; k < T.size(); k++) {
+                const size_t g = global(T, k);
+                if (!in_core(T, g))
+                    continue;
+                double sum = 0.0;
+                size_t cnt = 0, kk = 0;
+                for (const auto o : near[t]) {
+                    if (contains(tiles[o], g, kk)) {
+                        sum += double(x[o][kk]) + double(u[o][kk]);
+                        cnt++;
+                    }
+                }
+                const double zg = sum / double(cnt);
+                s = std::max(s, std::abs(zg - double(z[g])));
+                z[g] = float_t(zg);
+            }
+            ss[t] = rho * s;
+        });
+
+        // u-update; primal residual
+        pool.run(tiles.size(), [&](size_t t, unsigned) {
+            double r = 0.0;
+            for (size_t k = 0; k < tiles[t].size(); k++) {
+                const double diff = double(x[t][k]) - double(z[global(tiles[t], k)]);
+                u[t][k] += float_t(diff);
+                r = std::max(r, std::abs(diff));
+            }
+            rs[t] = r;
+        });
+        delta = 0.0;
+        for (size_t t = 0; t < tiles.size(); t++)
+            delta = std::max(delta, std::max(rs[t], ss[t]));
+    }
+    return res;
+}
+
+
+template <typename float_t>
+std::vector<float_t>
+TiledTV<float_t>::core(const size_t t) const
+{
+    const auto &T = tiles.at(t);
+    const size_t D = dims.size();
+    std::vector<float_t> c;
+    c.reserve(T.core_size());
+    std::vector<size_t> pos(T.core_lo);
+    for (size_t k = 0; k < T.core_size(); k++) {
+        size_t g = 0;
+        for (size_t d = 0; d < D; d++)
+            g = g * dims[d] + pos[d];
+        c.push_back(z[g]);
+        for (size_t d = D; d-- > 0;) {
+            if (++pos[d] < T.core_hi[d])
+                break;
+            pos[d] = T.core_lo[d];
+        }
+    }
+    return c;
+}
@@ -13,4 +13,5 @@ struct TreeLasso
     std::vector<int_> dfs, bfs;
     std::vector<int_> postorder, ipostord;
     std::vector<int_> preorder;     // maybe deleted in the future
+    std::vector<int_> queue_start;  // see `tree_orders` in merge.hpp
 };
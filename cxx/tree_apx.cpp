@@ -13,7 +13,9 @@ tree_apx(
     const int max_iter,
     const bool print_timings,
     const bool reorder,
-    const bool dfs_order);
+    const bool dfs_order,
+    const int *postorder,
+    const Cancel *cancel);
 
 
 template
@@ -28,4 +30,6 @@ tree_apx(
     const int max_iter,
     const bool print_timings,
     const bool reorder,
-    const bool dfs_order);
+    const bool dfs_order,
+    const int *postorder,
+    const Cancel *cancel);
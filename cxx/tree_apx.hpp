@@ -8,10 +8,16 @@
 #include <graphidx/utils/perm.hpp>
 #include <graphidx/utils/timer.hpp>
 
+#include "sigint.hpp"
+
 #undef DEBUG_ID
 constexpr auto PRINT_MAX = 20;
 
 
+/**
+   Perform `max_iter` approximation iterations; if `cancel` stops earlier,
+   `x` is the current iterate.
+ */
 template<typename float_ = float, typename int_ = int>
 void
 tree_apx(
@@ -24,7 +30,9 @@ tree_apx(
     const int max_iter = 3,
     const bool print_timings = true,
     const bool reorder = true,
-    const bool dfs_order = false);
+    const bool dfs_order = false,
+    const int_ *postorder = nullptr,
+    const Cancel *cancel = nullptr);
 
 
 extern template
@@ -39,7 +47,9 @@ tree_apx(
     const int max_iter,
     const bool print_timings,
     const bool reorder,
-    const bool dfs_order);
+    const bool dfs_order,
+    const int *postorder,
+    const Cancel *cancel);
 
 
 extern template
@@ -54,7 +64,9 @@ tree_apx(
     const int max_iter,
     const bool print_timings,
     const bool reorder,
-    const bool dfs_order);
+    const bool dfs_order,
+    const int *postorder,
+    const Cancel *cancel);
 
 
 /**
@@ -192,11 +204,13 @@ tree_apx(
     const int max_iter,
     const bool print_timings,
     const bool reorder,
-    const bool dfs_order)
+    const bool dfs_order,
+    const int_ *postorder,
+    const Cancel *cancel)
 {
     Timer _ ("tree_apx:\n");
 
-    std::vector<int_> porder;    // post order (forward)
+    std::vector<int_> porder;    // post order (forward), unless `postorder`
     std::vector<int_> iorder;    // inverse of porder
     ChildrenIndex cidx;
     int_ root = root_;
@@ -209,41 +223,52 @@ tree_apx(
         porder.reserve(n);
         iorder.reserve(n);
     }
+    const int_ *order = postorder ? postorder : porder.data();
     Timer tim ("TreeApx::alloc");
-    TreeApx<float_, int_> s (n, porder.data(), reorder);
+    TreeApx<float_, int_> s (n, order, reorder);
     tim.stop();
     if (root < 0) {
         Timer _ ("find_root");
-        root = find_root(n, parent);
-    }
-    {
-        Timer _ ("children idx");
-        cidx.reset(n, parent, root);
+        root = postorder ? postorder[n-1] : find_root(n, parent);
     }
 
-    if (dfs_order) {
-        Timer _ ("dfs");
-        stack<int_> stack;
-        reversed_dfs_discover_pi(porder.data(), cidx, stack, s.parent_);
+    if (postorder) {
+        Timer _ ("stored order");
+        if (reorder) {
+            iorder.resize(n);
+            invperm(n, iorder.data(), postorder);
+            for (size_t i = 0; i < n; i++)
+                s.parent_[i] = iorder[parent[postorder[i]]];
+        }
     } else {
-        Timer _ ("bfs");
-        reversed_bfs_pi(porder.data(), cidx, s.parent_);
+        {
+            Timer _ ("children idx");
+            cidx.reset(n, parent, root);
+        }
+        if (dfs_order) {
+            Timer _ ("dfs");
+            stack<int_> stack;
+            reversed_dfs_discover_pi(porder.data(), cidx, stack, s.parent_);
+        } else {
+            Timer _ ("bfs");
+            reversed_bfs_pi(porder.data(), cidx, s.parent_);
+        }
     }
     {
         Timer _ ("parent bit");
         for (size_t i = 0; i < n; i++)
             s.parent_[i] |= decltype(s)::one;
     }
-    if (porder[n-1] != root)
+    if (order[n-1] != root)
         throw std::runtime_error(
             std::string("tree_apx(): FATAL: ") +
             "forder[" + std::to_string(n-1) + "] = " +
-            std::to_string(porder[n-1]) + " != " +
+            std::to_string(order[n-1]) + " != " +
             std::to_string(root) + " = root");
 
     if (n <= PRINT_MAX) {
         Timer _ ("inverse order");
-        invperm(n, iorder.data(), porder.data());
+        invperm(n, iorder.data(), order);
     }
     {   Timer _ ("init x,y");
 #ifdef DEBUG_ID
@@ -251,7 +276,7 @@ tree_apx(
 #endif
         if (reorder) {
             for (size_t i = 0; i < n; i++) {
-                const auto ii = porder[i];
+                const auto ii = order[i];
 #ifdef DEBUG_ID
                 s.id[i] = ii;
 #endif
@@ -279,7 +304,7 @@ tree_apx(
         printf("   parent: ");
         print_int_list(Vec(parent, n));
         printf("postorder: ");
-        print_int_list(Vec(porder.data(), n));
+        print_int_list(Vec(order, n));
         printf("   iorder: ");
         print_int_list(Vec(iorder.data(), n));
     }
@@ -297,6 +322,10 @@ tree_apx(
     {   Timer _ ("iterations:\n");
         float_ delta = float_((max_y - min_y) * 0.5);
         for (int k = 0; k < max_iter; k++) {
+            if (cancel && cancel->stop()) {
+                Timer::log("stopped after %d iterations\n", k);
+                break;
+            }
             size_t changed = 0;
             Timer::log("%2ld ...%s", k+1, print_timings ? "\n" : "");
 
@@ -326,7 +355,7 @@ tree_apx(
     {   Timer _ ("extract x");
         if (reorder) {
             for (size_t i = 0; i < n; i++)
-                x[porder[i]] = s.x[i];
+                x[order[i]] = s.x[i];
         } else {
             for (size_t i = 0; i < n; i++)
                 x[i] = s.x[i];
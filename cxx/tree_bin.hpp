@@ -0,0 +1,260 @@
+/**
+   Binary container for tree instances that can be memory-mapped and used
+   without copying:
+
+       header   (magic "TREELAS", version, n, root, number of arrays)
+       table    (name, type, length and file offset of every array)
+       arrays   (each aligned to `TreeBin::ALIGN` bytes)
+
+   All values are stored in native byte order.  Typical arrays are "y",
+   "lam", "parent" and optionally "mu", "dfs", "bfs" or "postorder".
+ */
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mmap_file.hpp"
+
+
+namespace treebin {
+
+enum Type : uint32_t { F64 = 1, I32 = 2, F32 = 3, I64 = 4 };
+
+template <typename T> struct type_of;
+template <> struct type_of<double> { static constexpr uint32_t value = F64; };
+template <> struct type_of<float> { static constexpr uint32_t value = F32; };
+template <> struct type_of<int32_t> { static constexpr uint32_t value = I32; };
+template <> struct type_of<int64_t> { static constexpr uint32_t value = I64; };
+
+constexpr char MAGIC[8] = "TREELAS";
+constexpr uint32_t VERSION = 1;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_arrays;
+    uint64_t n;
+    int64_t root;
+};
+
+struct Entry
+{
+    char name[16];
+    uint32_t type;
+    uint32_t elsize;
+    uint64_t length;
+    uint64_t offset;
+};
+
+}   // namespace treebin
+
+
+/** Tree instance in a mapped binary container; arrays point into the map */
+class TreeBin
+{
+public:
+    static constexpr size_t ALIGN = 64;
+
+    TreeBin(const char *fname) : file(fname)
+    {
+        if (file.size() < sizeof(treebin::Header))
+            throw std::runtime_error(std::string("Too short for a TREELAS file: ") +
+                                     fname);
+        std::memcpy(&head, file.data(), sizeof(head));
+        if (std::memcmp(head.magic, treebin::MAGIC, sizeof(head.magic)) != 0)
+            throw std::runtime_error(std::string("Not a TREELAS file: ") + fname);
+        if (head.version != treebin::VERSION)
+            throw std::runtime_error(std::string("Unsupported TREELAS version ") +
+                                     std::to_string(head.version));
+        const size_t table = sizeof(head) + head.num_arrays * sizeof(treebin::Entry);
+        if (file.size() < table)
+            throw std::runtime_error("TREELAS: truncated table");
+        entries.resize(head.num_arrays);
+        std::memcpy(entries.data(), file.data() + sizeof(head), table - sizeof(head));
+        for (const auto &e : entries)
+            if (e.offset % ALIGN != 0 || e.offset > file.size() ||
+                (e.elsize > 0 && e.length > (file.size() - e.offset) / e.elsize))
+                throw std::runtime_error(std::string("TREELAS: corrupt array ") +
+                                         std::string(e.name, strnlen(e.name, 16)));
+    }
+
+    size_t size() const { return size_t(head.n); }
+    int64_t root() const { return head.root; }
+
+    bool has(const char *name) const { return find(name) != nullptr; }
+
+    /** Number of elements of array `name` */
+    size_t length(const char *name) const
+    {
+        const auto *e = find(name);
+        return e ? size_t(e->length) : 0;
+    }
+
+    static constexpr size_t ANY = size_t(-1);
+
+    /** Pointer into the map; `nullptr` if `name` does not exist.
+        Throw if the type or the length (unless `ANY`) differs. */
+    template <typename T>
+    const T *get(const char *name, const size_t expected_len = ANY) const
+    {
+        const auto *e = find(name);
+        if (!e)
+            return nullptr;
+        if (e->type != treebin::type_of<T>::value || e->elsize != sizeof(T))
+            throw std::runtime_error(std::string("TREELAS: wrong type of ") + name);
+        if (expected_len != ANY && e->length != expected_len)
+            throw std::runtime_error(std::string("TREELAS: length of ") + name +
+                                     " is " + std::to_string(e->length) + " != " +
+                                     std::to_string(expected_len));
+        return reinterpret_cast<const T *>(file.data() + e->offset);
+    }
+
+    /** Like `get` but throw if `name` does not exist */
+    template <typename T>
+    const T *at(const char *name, const size_t expected_len = ANY) const
+    {
+        const T *p = get<T>(name, expected_len);
+        if (!p)
+            throw std::runtime_error(std::string("TREELAS: no array ") + name);
+        return p;
+    }
+
+    /** First element of `name`; throw if it does not exist or is empty */
+    template <typename T>
+    T first(const char *name) const
+    {
+        const T *p = at<T>(name);
+        if (length(name) == 0)
+            throw std::runtime_error(std::string("TREELAS: empty array ") + name);
+        return p[0];
+    }
+
+    /** All arrays, e.g. to copy them (see `TreeBinWriter::add`) */
+    const std::vector<treebin::Entry> &arrays() const { return entries; }
+
+    const void *data(const treebin::Entry &e) const { return file.data() + e.offset; }
+
+    /** Prefetch all arrays (`madvise(MADV_WILLNEED)`) */
+    void willneed() const
+    {
+        for (const auto &e : entries)
+            file.willneed(size_t(e.offset), size_t(e.length * e.elsize));
+    }
+
+    /** Whether `fname` starts with the TREELAS magic */
+    static bool is_treebin(const char *fname)
+    {
+        char magic[sizeof(treebin::MAGIC)] = {0};
+        FILE *f = fopen(fname, "rb");
+        if (!f)
+            return false;
+        const bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                        std::memcmp(magic, treebin::MAGIC, sizeof(magic)) == 0;
+        fclose(f);
+        return ok;
+    }
+
+private:
+    MappedFile file;
+    treebin::Header head;
+    std::vector<treebin::Entry> entries;
+
+    const treebin::Entry *find(const char *name) const
+    {
+        for (const auto &e : entries)
+            if (std::strncmp(e.name, name, sizeof(e.name)) == 0)
+                return &e;
+        return nullptr;
+    }
+};
+
+
+/** Collect arrays (by reference) and write them as one container */
+class TreeBinWriter
+{
+public:
+    TreeBinWriter(const size_t n, const int64_t root) : n(n), root(root) { }
+
+    template <typename T>
+    TreeBinWriter &add(const char *name, const T *data, const size_t length)
+    {
+        if (std::strlen(name) >= sizeof(treebin::Entry::name))
+            throw std::invalid_argument(std::string("TREELAS: name too long: ") + name);
+        treebin::Entry e;
+        std::memset(&e, 0, sizeof(e));
+        std::strncpy(e.name, name, sizeof(e.name) - 1);
+        e.type = treebin::type_of<T>::value;
+        e.elsize = sizeof(T);
+        e.length = length;
+        return add(e, data);
+    }
+
+    template <typename T>
+    TreeBinWriter &add(const char *name, const std::vector<T> &data)
+    {
+        return add(name, data.data(), data.size());
+    }
+
+    /** Array as described by `e` (the offset is ignored) */
+    TreeBinWriter &add(const treebin::Entry &e, const void *data)
+    {
+        entries.push_back(e);
+        ptrs.push_back(data);
+        return *this;
+    }
+
+
+    void write(const char *fname)
+    {
+        treebin::Header head;
+        std::memset(&head, 0, sizeof(head));
+        std::memcpy(head.magic, treebin::MAGIC, sizeof(head.magic));
+        head.version = treebin::VERSION;
+        head.num_arrays = uint32_t(entries.size());
+        head.n = n;
+        head.root = root;
+
+        uint64_t offset = sizeof(head) + entries.size() * sizeof(treebin::Entry);
+        for (auto &e : entries) {
+            offset = align(offset);
+            e.offset = offset;
+            offset += e.length * e.elsize;
+        }
+
+        FILE *f = fopen(fname, "wb");
+        if (!f)
+            throw std::runtime_error(std::string("Could not create ") + fname);
+        bool ok = fwrite(&head, sizeof(head), 1, f) == 1;
+        if (!entries.empty())
+            ok = ok && fwrite(entries.data(), sizeof(treebin::Entry), entries.size(), f) ==
+                           entries.size();
+        uint64_t pos = sizeof(head) + entries.size() * sizeof(treebin::Entry);
+        static const char zeros[TreeBin::ALIGN] = {0};
+        for (size_t i = 0; ok && i < entries.size(); i++) {
+            const auto &e = entries[i];
+            ok = ok && fwrite(zeros, 1, e.offset - pos, f) == e.offset - pos;
+            const size_t bytes = e.length * e.elsize;
+            ok = ok && (bytes == 0 || fwrite(ptrs[i], 1, bytes, f) == bytes);
+            pos = e.offset + bytes;
+        }
+        ok = (fclose(f) == 0) && ok;
+        if (!ok)
+            throw std::runtime_error(std::string("Could not write ") + fname);
+    }
+
+private:
+    size_t n;
+    int64_t root;
+    std::vector<treebin::Entry> entries;
+    std::vector<const void *> ptrs;
+
+    static uint64_t align(const uint64_t k)
+    {
+        return (k + TreeBin::ALIGN - 1) / TreeBin::ALIGN * TreeBin::ALIGN;
+    }
+};
@@ -3,9 +3,12 @@
  */
 #pragma once
 
+#include <cmath>            // std::abs
 #include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <string>
+#include <type_traits>     // std::decay_t
 
 #include <graphidx/bits/clamp.hpp>
 #include <graphidx/bits/weights.hpp>
@@ -17,100 +20,243 @@
 
 #include "clip.hpp"
 #include "merge.hpp"
+#include "sigint.hpp"
+#include "tree_orders_par.hpp"
 
 
 struct TreeDPStatus
 {
-    TreeDPStatus(const size_t n) : childs(n)
+    /** `topology = false`: orders will be passed to `tree_dp` (see below) */
+    TreeDPStatus(const size_t n, const bool topology = true)
+        : childs(topology ? n : 0)
     {
         lb.reserve(n);
         elements_.reserve(2*n);
         pq.reserve(n);
-        proc_order.reserve(n);
-        dfs_stack.reserve(n);
+        if (topology) {
+            proc_order.reserve(n);
+            dfs_stack.reserve(n);
+        }
     }
 
     ChildrenIndex childs;
     stack<int> dfs_stack;
+    unsigned threads = 1;               // > 1: `orders` instead of the DFS
+    TreeOrdersPar<int> orders {1};
+    bool compact = false;               // coalesce equal events (not bit-exact)
+    size_t merged = 0;                  // total length of the merged queues
 
     std::vector<int> proc_order;
+    std::vector<int> subtree_first;     // filled by the DFS if of size n
     uvector<Event> elements_;
+    uvector<Event> merge_buf;           // merge2(): copy of the parent queue
     uvector<Range> pq;
     uvector<double> lb;
 };
 
 
-template <bool merge_sort, bool lazy_sort, typename Wlam, typename Wmu>
-inline const double*
+/**
+   Certificate computed along with `tree_dp` (if passed): the edge flows
+   `alpha` (as `tree_dual` with `tree_orientation`; may be NULL), the
+   primal and dual objective and the duality gap (computed edge by edge,
+   i.e. without cancellation).  Nodes with `mu = 0` do not contribute to
+   the dual objective.
+ */
+struct TreeDPDual
+{
+    double *alpha = nullptr;
+    double primal = 0.0;
+    double dual = 0.0;
+    double gap = 0.0;
+};
+
+
+/**
+   If `postorder` and `queue_start` (see `tree_orders` in merge.hpp) are
+   given, the children index and the DFS are skipped.  Otherwise, with
+   `s.threads > 1`, they are computed by `TreeOrdersPar` (same orders).
+
+   `x` and `y` may also be views (e.g. `Strided<float>`, see strided.hpp);
+   `x` stores the upper bounds in the meantime.
+
+   With `s.compact`, events at equal positions are coalesced in the
+   queues (see `compact_events` in merge.hpp): the result is the same
+   only up to rounding, not bit-identical.  `s.merged` reports the total
+   length of the merged queues.
+
+   If `cancel` is given, it is polled between the phases and every few
+   thousand nodes; on `cancel->stop()`, `Interrupted` is thrown.
+
+   If `dual` is given, the backtrace also evaluates the primal objective
+   and the node residuals `mu*(x - y)`, which one more post-order sweep
+   accumulates into `dual->alpha` and the dual objective (instead of the
+   separate passes of `tree_dual` and `tree_dual_gap`); then `x` must not
+   alias `y`.
+ */
+template <bool merge_sort, bool lazy_sort, typename Wlam, typename Wmu,
+          typename X = double *, typename Y = const double *>
+inline X
 tree_dp(
     const size_t n,
-    double *x,
-    const double *y,
+    X x,
+    const Y &y,
     const int *parent,
     const Wlam &lam,
     const Wmu &mu,
     const int root,
-    TreeDPStatus &s)
+    TreeDPStatus &s,
+    const int *postorder = nullptr,
+    const int *queue_start = nullptr,
+    const Cancel *cancel = nullptr,
+    TreeDPDual *dual = nullptr)
 {
     if (root < 0) {
         int new_root = -1;
         {
             Timer _ ("find root");
-            new_root = find_root(n, parent);
+            new_root = postorder ? postorder[n-1]
+                : s.threads > 1 ? find_root_par(n, parent, s.threads)
+                : find_root(n, parent);
         }
-        return tree_dp<merge_sort, lazy_sort>(n, x, y, parent, lam, mu, new_root, s);
+        return tree_dp<merge_sort, lazy_sort>(
+            n, x, y, parent, lam, mu, new_root, s, postorder, queue_start, cancel,
+            dual);
     }
+    const auto poll = [cancel]() {
+        if (cancel && cancel->stop())
+            throw Interrupted("tree_dp");
+    };
 
     auto *elements = s.elements_.data();
     auto &pq = s.pq;
-    auto
-        *lb = s.lb.data(),
-        *ub = x;
+    auto *lb = s.lb.data();
+    auto ub = x;
+    using x_t = std::decay_t<decltype(x[0])>;     // e.g. float for Strided<float>
     auto *sig = lb;
-    const auto &childs = s.childs;
-    const auto &proc_order = s.proc_order;
+    const int *proc_order = postorder;
     constexpr bool check = !Wmu::is_const();
+    const bool compact = s.compact;
+    size_t merged = 0;
 
     {   Timer _ ("lb init");
         std::fill(lb, lb + n, 0);
     }
-    {   Timer _ ("children index");
-        s.childs.reset(n, parent, root);
+    if (postorder && queue_start) {
+        if (postorder[n-1] != root)
+            throw std::invalid_argument(
+                std::string("tree_dp(): postorder[n-1] = ") +
+                std::to_string(postorder[n-1]) + " != root = " +
+                std::to_string(root));
+        init_queues(n, pq, queue_start);
+    } else if (s.threads > 1) {
+        {   Timer _ ("children index (parallel)");
+            s.orders.threads = s.threads;
+            s.orders.reset(n, parent, root);
+        }
+        {   Timer _ ("init_queue: parallel");
+            s.orders.init_queues(
+                pq, s.proc_order,
+                s.subtree_first.size() == n ? s.subtree_first.data() : nullptr);
+        }
+        proc_order = s.proc_order.data();
+    } else {
+        {   Timer _ ("children index");
+            s.childs.reset(n, parent, root);
+        }
+        init_queues(n, pq, s.proc_order, s.childs, s.dfs_stack, root,
+                    s.subtree_first.size() == n ? s.subtree_first.data() : nullptr);
+        proc_order = s.proc_order.data();
     }
-
-    init_queues(n, pq, s.proc_order, childs, s.dfs_stack, root);
+    poll();
     {   Timer _ ("forward");
-        for (auto i : proc_order) {
+        for (size_t k = 0; k+1 < n; k++) {
+            if ((k & 0xfff) == 0xfff)
+                poll();
+            const auto i = proc_order[k];
             const auto sig_i = sig[i];  // backup before it is set in next line
-            if (!merge_sort && lazy_sort)
+            if (!merge_sort && lazy_sort) {
                 sort_events(pq[i], elements);
-            lb[i] = clip<+1, check>(elements, pq[i], +mu[i], -mu[i]*y[i] - sig_i + lam[i]);
-            ub[i] = clip<-1, check>(elements, pq[i], -mu[i], +mu[i]*y[i] - sig_i + lam[i]);
+                if (compact)
+                    pq[i] = compact_events(pq[i], elements);
+            }
+            lb[i] = clip<+1, check>(elements, pq[i], +mu[i],
+                                    -mu[i]*y[i] - sig_i + lam[i], compact);
+            ub[i] = x_t(clip<-1, check>(elements, pq[i], -mu[i],
+                                        +mu[i]*y[i] - sig_i + lam[i], compact));
             sig[parent[i]] +=
                 (check && mu[i] <= EPS) ? std::min(lam[i], sig_i) : lam[i];
             if (merge_sort)
-                pq[parent[i]] = merge2(pq[parent[i]], pq[i], elements);
+                pq[parent[i]] = merge2(pq[parent[i]], pq[i], elements, compact,
+                                       &s.merge_buf);
             else {
                 pq[parent[i]] = merge(pq[parent[i]], pq[i], elements);
-                if (!lazy_sort)
+                if (!lazy_sort) {
                     sort_events(pq[parent[i]], elements);
+                    if (compact)
+                        pq[parent[i]] = compact_events(pq[parent[i]], elements);
+                }
             }
+            merged += pq[parent[i]].length();
         }
+        s.merged = merged;
     }
 
+    poll();
+    const auto r = root;
+    auto *z = lb;                       // lb[v] is not needed after x[v]
+    double primal = 0.0, dual_obj = 0.0;
+    const auto residual = [&](const int v) {
+        const double d = double(x[v]) - double(y[v]);
+        z[v] = mu[v] > 0 ? mu[v] * d : 0.0;
+        primal += 0.5 * mu[v] * d * d;
+    };
     {   Timer _ ("backtrace");
-        const auto r = root;
         if (!merge_sort && lazy_sort)
             sort_events(pq[r], elements);
-        x[r] = clip<+1, check>(elements, pq[r],
-                               +mu[r], -mu[r]*y[r] -sig[r] + 0.0);
+        x[r] = x_t(clip<+1, check>(elements, pq[r],
+                                   +mu[r], -mu[r]*y[r] -sig[r] + 0.0));
+        if (!dual) {
+            for (long int j = (long int)(n-2); j >= 0; j--) {
+                const auto v = proc_order[j];
+                x[v] = x_t(clamp(double(x[parent[v]]), lb[v], double(ub[v])));
+            }
+            return x;
+        }
         for (long int j = (long int)(n-2); j >= 0; j--) {
             const auto v = proc_order[j];
-            x[v] = clamp(x[parent[v]], lb[v], ub[v]);
+            x[v] = x_t(clamp(double(x[parent[v]]), lb[v], double(ub[v])));
+            residual(v);
+            primal += lam[v] * std::abs(double(x[v]) - double(x[parent[v]]));
+            if (mu[v] > 0)
+                dual_obj -= z[v] * double(y[v]) + 0.5 * z[v] * z[v] / mu[v];
         }
+        residual(r);
+    }
+
+    {   Timer _ ("dual");
+        const double z_root = z[r];
+        double gap = 0.0;
+        double *alpha = dual->alpha;
+        for (size_t k = 0; k+1 < n; k++) {
+            const auto c = proc_order[k];
+            const auto p = parent[c];
+            const double d = double(x[c]) - double(x[p]);
+            if (alpha)
+                alpha[c] = z[c];
+            gap += z[c] * d + lam[c] * std::abs(d);
+            z[p] += z[c];
+        }
+        if (alpha)
+            alpha[r] = std::numeric_limits<double>::quiet_NaN();
+        if (mu[r] > 0) {                // the root takes the remaining flow
+            const double z_r = z_root - z[r];
+            dual_obj -= z_r * double(y[r]) + 0.5 * z_r * z_r / mu[r];
+        }
+        dual->primal = primal;
+        dual->dual = dual_obj;
+        dual->gap = gap;
     }
 
-    Timer::startit("free");
     return x;
 }
 
@@ -135,8 +281,9 @@ tree_dp(
         x = new double[n];
     TreeDPStatus s(n);
     timer.stop();
-    return tree_dp<merge_sort, lazy_sort, Wlam, Wmu>(
-        n, x, y, parent, lam, mu, root, s);
+    tree_dp<merge_sort, lazy_sort, Wlam, Wmu>(n, x, y, parent, lam, mu, root, s);
+    Timer::startit("free");     // until `s` is destructed
+    return x;
 }
 
 
@@ -2,12 +2,40 @@
 
 #include <vector>
 #include <stdexcept>
+#include <string>
 #include <cmath>
 
 #include <graphidx/tree/root.hpp>
 #include <graphidx/tree/postorder.hpp>
 
 
+template <typename It>
+static inline void
+dual_postorder(It begin,
+               It end,
+               double *x,
+               const int *parent,
+               double *alpha,
+               const bool tree_orientation)
+{
+    if (tree_orientation) {
+        for (auto it = begin; it != end; ++it) {
+            const auto c = *it;
+            const auto v = parent[c];
+            alpha[c] = x[c];
+            x[v]    += x[c];
+        }
+    } else {
+        for (auto it = begin; it != end; ++it) {
+            const auto c = *it;
+            const auto v = parent[c];
+            alpha[c] = c > v ? -x[c] : +x[c];
+            x[v]    += x[c];
+        }
+    }
+}
+
+
 double*
 tree_dual(const size_t n,
           double *x,
@@ -27,24 +55,23 @@ tree_dual(const size_t n,
                                  " != " + std::to_string(parent[root]) +
                                  " = parent[root]");
     }
-    PostOrder postorder (n, parent, _postord, root, /* include_root= */ false);
+    if (_postord != nullptr && _postord[n-1] != root)
+        throw std::runtime_error(std::string("dp_dual(): ") +
+                                 "postorder[n-1] = " +
+                                 std::to_string(_postord[n-1]) +
+                                 " != " + std::to_string(root) + " = root");
     if (alpha == nullptr)
         alpha = new double[n];
 
     alpha[root] = std::nan("");
 
-    if (tree_orientation) {
-        for (const auto c : postorder) {
-            const auto v = parent[c];
-            alpha[c] = x[c];
-            x[v]    += x[c];
-        }
+    if (_postord != nullptr) {      // stored order (root last): no copy
+        dual_postorder(_postord, _postord + n - 1, x, parent, alpha,
+                       tree_orientation);
     } else {
-        for (const auto c : postorder) {
-            const auto v = parent[c];
-            alpha[c] = c > v ? -x[c] : +x[c];
-            x[v]    += x[c];
-        }
+        PostOrder postorder (n, parent, nullptr, root, /* include_root= */ false);
+        dual_postorder(postorder.begin(), postorder.end(), x, parent, alpha,
+                       tree_orientation);
     }
 
     return alpha;
@@ -0,0 +1,118 @@
+/**
+   Parallel versions of `tree_dual` and `tree_dual_gap` (tree_dual.hpp).
+
+   In a post order, the subtree of every node `v` is a contiguous block
+   ending at `v`.  Hence, with the prefix sums `P` of the values along the
+   post order, the subtree sum of `v` at position `k` is
+   `P[k+1] - P[subtree_first[v]]`: two parallel sweeps and a parallel
+   difference instead of one sequential sweep along the post order.
+
+   The sums are accumulated in a different order than in `tree_dual`,
+   i.e. the results agree up to rounding only (the prefix sums are
+   always `double`).
+ */
+#pragma once
+#include <algorithm>        // std::min, std::max
+#include <cmath>            // std::abs
+#include <vector>
+
+#include "parallel.hpp"
+
+
+/**
+   `subtree_first[v]`: position in `postorder` where the subtree of `v`
+   starts.  `postorder` holds the `n - 1` non-root nodes (children before
+   parents, as `proc_order` of `init_queues`, which can compute the same
+   while it runs).  Sequential; only depends on the topology.
+ */
+template <typename int_t = int>
+void
+subtree_first(
+    const size_t n,
+    const int_t *parent,
+    const int_t *postorder,
+    const int_t root,
+    int_t *first)
+{
+    std::fill(first, first + n, int_t(1));     // subtree sizes until finished
+    for (size_t k = 0; k+1 < n; k++) {
+        const auto v = postorder[k];
+        const auto size = first[v];
+        first[parent[v]] += size;
+        first[v] = int_t(k + 1) - size;
+    }
+    first[root] = 0;
+}
+
+
+/**
+   Subtree sums of `z`, i.e. `alpha[v] = sum(z[u] for u in subtree(v))`
+   (like the templated `tree_dual` in gaplas.hpp; `alpha[root]` is the
+   total).  `alpha` may be `z`; `prefix` is a buffer (resized to `n`).
+ */
+template <typename float_t = double, typename int_t = int>
+void
+tree_dual_par(
+    const size_t n,
+    float_t *alpha,
+    const float_t *z,
+    const int_t *postorder,
+    const int_t *first,
+    const int_t root,
+    std::vector<double> &prefix,
+    const unsigned threads = default_threads())
+{
+    if (n == 0)
+        return;
+    const size_t m = n - 1;
+    prefix.resize(n);
+    double *P = prefix.data();
+    parallel_scan(m, threads, P, [&](size_t k) { return double(z[postorder[k]]); });
+    const double total = P[m] + double(z[root]);
+    const unsigned parts = parallel_parts(m, threads);
+    parallel_blocks(m, parts, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; k++) {
+            const auto v = postorder[k];
+            alpha[v] = float_t(P[k+1] - P[first[v]]);
+        }
+    });
+    alpha[root] = float_t(total);
+}
+
+
+/**
+   Like `tree_dual_gap` (with `lam` a weight view, e.g. `Const<double>`),
+   distributed over `threads`; returns the sum of `lam[i] * gamma[i]`
+   over all non-root nodes, i.e. the duality gap of the tree problem.
+ */
+template <typename Wlam>
+double
+tree_dual_gap_par(
+    const size_t n,
+    double *gamma,
+    const double *x,
+    const double *alpha,
+    const Wlam &lam,
+    const int *parent,
+    const double root_val = 0.0,
+    const unsigned threads = default_threads())
+{
+    const unsigned parts = parallel_parts(n, threads);
+    std::vector<double> sum (parts, 0.0);
+    parallel_blocks(n, parts, [&](size_t begin, size_t end, unsigned t) {
+        double s = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            const auto p = parent[i];
+            const double diff = x[i] - x[p];
+            const double g = alpha[i] / lam[i] * diff + std::abs(diff);
+            const bool is_root = size_t(p) == i;
+            gamma[i] = is_root ? root_val : g;
+            s += is_root ? 0.0 : lam[i] * g;
+        }
+        sum[t] = s;
+    });
+    double gap = 0.0;
+    for (const auto s : sum)
+        gap += s;
+    return gap;
+}
@@ -1,14 +1,54 @@
 #pragma once
+#include <stdexcept>
+#include <string>
+#include <type_traits>      // std::decay_t
+
 #include <minih5.hpp>
 
 #include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>
 #include "tree.hpp"
+#include "tree_bin.hpp"
+
+
+/** Copy the arrays of a binary instance (see `tree_bin.hpp`) */
+template <typename float_, typename int_>
+TreeLasso<float_, int_>
+load_treelasso_bin(const char *fname)
+{
+    TreeLasso<float_, int_> t;
+    Timer _ ("Loading Tree");
+    const TreeBin bin (fname);
+    const size_t n = bin.size();
+    const auto copy = [&](const char *name, auto &vec, const size_t len) {
+        using T = typename std::decay_t<decltype(vec)>::value_type;
+        const T *p = bin.get<T>(name, len);
+        if (p)
+            vec.assign(p, p + bin.length(name));
+    };
+    copy("y", t.y, n);
+    copy("lam", t.lam, TreeBin::ANY);
+    copy("parent", t.parent, n);
+    copy("mu", t.mu, TreeBin::ANY);
+    copy("dfs", t.dfs, n);
+    copy("bfs", t.bfs, n);
+    copy("postorder", t.postorder, n);
+    copy("queue_start", t.queue_start, n);
+    if (t.y.size() != bin.size() || t.parent.size() != bin.size() || t.lam.empty())
+        throw std::runtime_error(std::string("Incomplete tree instance: ") + fname);
+    t.root = int_(bin.root());
+    if (t.mu.empty())
+        t.mu = {0.5};
+    return t;
+}
 
 
 template <typename float_, typename int_>
 TreeLasso<float_, int_>
 load_treelasso(const char *fname, const char *group)
 {
+    if (TreeBin::is_treebin(fname))
+        return load_treelasso_bin<float_, int_>(fname);
     if (std::string("/") != group)
         throw std::logic_error("Not implemented yet");
 
@@ -22,8 +62,15 @@ load_treelasso(const char *fname, const char *group)
 
         if (io.has("dfs"))
             t.dfs = io.read<typename decltype(t.dfs)::value_type>("dfs");
+        if (io.has("postorder") && io.has("queue_start")) {
+            t.postorder = io.read<typename decltype(t.postorder)::value_type>("postorder");
+            t.queue_start =
+                io.read<typename decltype(t.queue_start)::value_type>("queue_start");
+        }
         if (t.dfs.size() >= 1)
             t.root = t.dfs[0];
+        else if (t.postorder.size() >= 1)
+            t.root = t.postorder.back();
         else
             t.root = find_root(t.parent);
         
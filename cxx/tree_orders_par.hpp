@@ -0,0 +1,234 @@
+/**
+   Parallel preprocessing of trees given by `parent`: root scan, children
+   index (counting sort), breadth-first levels, subtree sizes and the
+   post order of `init_queues` (merge.hpp).
+
+   The post order is numbered without a DFS: bottom-up over the levels
+   the subtree sizes are accumulated, top-down every node hands out the
+   consecutive position ranges to its children (in the order in which
+   the DFS of `init_queues` visits them, i.e. by descending index).
+   Every level is processed in parallel, small ones in the calling
+   thread; so deep, narrow trees (e.g. lines) do not profit.
+ */
+#pragma once
+#include <algorithm>        // std::sort, std::min_element
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <graphidx/std/uvector.hpp>
+
+#include "parallel.hpp"
+#include "range.hpp"
+
+
+/** Like `find_root`: the first `i` with `parent[i] == i` (-1 if none) */
+template <typename int_t = int>
+int_t
+find_root_par(const size_t n, const int_t *parent, const unsigned threads)
+{
+    const unsigned parts = parallel_parts(n, threads);
+    std::vector<size_t> first (parts, n);
+    parallel_blocks(n, parts, [&](size_t begin, size_t end, unsigned t) {
+        for (size_t i = begin; i < end; i++) {
+            if (size_t(parent[i]) == i) {
+                first[t] = i;
+                return;
+            }
+        }
+    });
+    const size_t r = *std::min_element(first.begin(), first.end());
+    return r < n ? int_t(r) : int_t(-1);
+}
+
+
+template <typename int_t = int>
+struct TreeOrdersPar
+{
+    explicit TreeOrdersPar(const unsigned threads = default_threads())
+        : threads(threads) { }
+
+    /** Compute everything below; `root < 0`: search for it */
+    void reset(const size_t n, const int_t *parent, int_t root = -1);
+
+    /** Same as `init_queues` (with the `ChildrenIndex` of `parent`) */
+    void init_queues(uvector<Range> &pq,
+                     std::vector<int_t> &proc_order,
+                     int_t *subtree_first = nullptr) const;
+
+    /** Same as `tree_orders` in merge.hpp */
+    void tree_orders(std::vector<int_t> &postorder,
+                     std::vector<int_t> &queue_start) const;
+
+    /** Reversed breadth-first order (children before parents, root last) */
+    void reversed_bfs(int_t *order) const;
+
+    /** Call `f(v, depth)` for every node, level by level in parallel */
+    template <typename F>
+    void each_level(const size_t first_level, F f) const;
+
+    const int_t *children_begin(int_t v) const { return value.data() + index[v]; }
+    const int_t *children_end(int_t v) const { return value.data() + index[v+1]; }
+
+    unsigned threads;
+    size_t n = 0;
+    int_t root = -1;
+    std::vector<int_t> index, value;    // ascending children of v in value[index[v]:]
+    std::vector<int_t> bfs;             // level d: bfs[level[d]:level[d+1]]
+    std::vector<size_t> level;
+    std::vector<int_t> size, start;     // subtree size, first post-order position
+
+private:
+    std::vector<std::atomic<int_t>> cursor;
+    std::vector<int_t> offset;
+};
+
+
+template <typename int_t>
+template <typename F>
+void
+TreeOrdersPar<int_t>::each_level(const size_t first_level, F f) const
+{
+    for (size_t d = first_level; d+1 < level.size(); d++) {
+        const size_t lo = level[d], width = level[d+1] - lo;
+        parallel_blocks(width, parallel_parts(width, threads),
+                        [&](size_t begin, size_t end, unsigned) {
+                            for (size_t j = begin; j < end; j++)
+                                f(bfs[lo + j], d);
+                        });
+    }
+}
+
+
+template <typename int_t>
+void
+TreeOrdersPar<int_t>::reset(const size_t n_, const int_t *parent, int_t root_)
+{
+    n = n_;
+    root = root_ < 0 ? find_root_par(n, parent, threads) : root_;
+    if (root < 0 || size_t(root) >= n || parent[root] != root)
+        throw std::invalid_argument("TreeOrdersPar: no root");
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    // children index: count, scan, scatter, sort within every parent
+    if (cursor.size() != n)
+        cursor = std::vector<std::atomic<int_t>>(n);
+    parallel_for(n, threads, [&](size_t v) { cursor[v].store(0, relaxed); });
+    parallel_for(n, threads, [&](size_t i) {
+        if (int_t(i) != root)
+            cursor[parent[i]].fetch_add(1, relaxed);
+    });
+    index.resize(n + 1);
+    parallel_scan(n, threads, index.data(), [&](size_t v) {
+        return cursor[v].load(relaxed);
+    });
+    parallel_for(n, threads, [&](size_t v) { cursor[v].store(index[v], relaxed); });
+    value.resize(n - 1);
+    parallel_for(n, threads, [&](size_t i) {
+        if (int_t(i) != root)
+            value[cursor[parent[i]].fetch_add(1, relaxed)] = int_t(i);
+    });
+    parallel_for(n, threads, [&](size_t v) {
+        if (index[v+1] - index[v] > 1)
+            std::sort(value.data() + index[v], value.data() + index[v+1]);
+    });
+
+    // breadth-first levels: every level is the concatenation of the
+    // children of the previous one
+    bfs.resize(n);
+    bfs[0] = root;
+    level.assign({0, 1});
+    for (size_t d = 0; level[d] < level[d+1]; d++) {
+        const size_t lo = level[d], hi = level[d+1], width = hi - lo;
+        offset.resize(width + 1);
+        parallel_scan(width, threads, offset.data(), [&](size_t j) {
+            const auto v = bfs[lo + j];
+            return index[v+1] - index[v];
+        });
+        parallel_blocks(width, parallel_parts(width, threads),
+                        [&](size_t begin, size_t end, unsigned) {
+                            for (size_t j = begin; j < end; j++) {
+                                const auto v = bfs[lo + j];
+                                std::copy(children_begin(v), children_end(v),
+                                          bfs.data() + hi + offset[j]);
+                            }
+                        });
+        level.push_back(hi + size_t(offset[width]));
+    }
+    level.pop_back();                   // the empty level
+    if (level.back() != n)
+        throw std::invalid_argument("parent does not describe a tree");
+
+    // subtree sizes (bottom-up), then the post-order ranges (top-down)
+    size.resize(n);
+    for (size_t d = level.size() - 1; d-- > 0; ) {
+        const size_t lo = level[d], width = level[d+1] - lo;
+        parallel_blocks(width, parallel_parts(width, threads),
+                        [&](size_t begin, size_t end, unsigned) {
+                            for (size_t j = begin; j < end; j++) {
+                                const auto v = bfs[lo + j];
+                                int_t s = 1;
+                                const auto *c = children_begin(v);
+                                for (; c != children_end(v); ++c)
+                                    s += size[*c];
+                                size[v] = s;
+                            }
+                        });
+    }
+    start.resize(n);
+    start[root] = 0;
+    each_level(0, [&](const int_t v, size_t) {
+        int_t next = start[v];
+        for (auto c = children_end(v); c != children_begin(v); ) {
+            --c;
+            start[*c] = next;
+            next += size[*c];
+        }
+    });
+}
+
+
+template <typename int_t>
+void
+TreeOrdersPar<int_t>::init_queues(
+    uvector<Range> &pq,
+    std::vector<int_t> &proc_order,
+    int_t *subtree_first) const
+{
+    // `init_queues` counts the stack operations: the node at post-order
+    // position k with depth d is finished after 2(k+1) + d of them
+    proc_order.resize(n - 1);
+    each_level(0, [&](const int_t v, const size_t depth) {
+        const int_t k = start[v] + size[v] - 1;
+        const int q = int(2*(k + 1) + int_t(depth));
+        pq[v] = Range({q, q-1});
+        if (v != root)
+            proc_order[k] = v;
+        if (subtree_first)
+            subtree_first[v] = start[v];
+    });
+}
+
+
+template <typename int_t>
+void
+TreeOrdersPar<int_t>::tree_orders(
+    std::vector<int_t> &postorder,
+    std::vector<int_t> &queue_start) const
+{
+    postorder.resize(n);
+    queue_start.resize(n);
+    each_level(0, [&](const int_t v, const size_t depth) {
+        const int_t k = start[v] + size[v] - 1;
+        postorder[k] = v;
+        queue_start[v] = 2*(k + 1) + int_t(depth);
+    });
+}
+
+
+template <typename int_t>
+void
+TreeOrdersPar<int_t>::reversed_bfs(int_t *order) const
+{
+    parallel_for(n, threads, [&](size_t i) { order[i] = bfs[n-1-i]; });
+}
@@ -0,0 +1,182 @@
+/**
+   `tree_dp` for trees that do not fit into memory.
+
+   The nodes are processed in post-order blocks (the orders stored by
+   `tree_prep`, see `tree_orders` in merge.hpp, are required).  In
+   post-order, the nodes whose queue is non-empty but not yet clipped are
+   ancestors of the current node and are opened and closed in LIFO order:
+   their `sig` and queue ranges are kept on a stack instead of the arrays
+   `lb` and `pq` of size n.  The events stay in the layout of
+   `queue_start`, but in a memory-mapped scratch file (see mmap_file.hpp)
+   where the pages below the active queues are released after each
+   block.  The bounds `lb`, `ub` are written by post-order position, so
+   each block is spilled sequentially; the backtrace reads them backwards
+   and hands `x` to the caller block by block.
+
+   Scratch space: 2n events, n lower and n upper bounds; in memory: one
+   block and the stacks (at most the height of the tree).
+ */
+#pragma once
+#include <algorithm>        // std::min
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <graphidx/bits/clamp.hpp>
+#include <graphidx/utils/timer.hpp>
+
+#include "clip.hpp"
+#include "event.hpp"
+#include "merge.hpp"
+#include "mmap_file.hpp"
+
+
+/**
+   Solve the tree problem whereby `postorder` and `queue_start` are as
+   computed by `tree_orders`.  The solution is handed to
+   `write_x(const int *nodes, const double *x, size_t count)` in reverse
+   post-order blocks of at most `block` nodes.
+
+   The inputs are only read; they may be memory-mapped (see tree_bin.hpp).
+ */
+template <typename Wlam, typename Wmu, typename Write>
+void
+tree_dp_stream(
+    const size_t n,
+    const double *y,
+    const int *parent,
+    const int *postorder,
+    const int *queue_start,
+    const Wlam &lam,
+    const Wmu &mu,
+    Write write_x,
+    size_t block = size_t(1) << 20,
+    const char *scratch_dir = nullptr)
+{
+    struct Open             // ancestor that got events from a child
+    {
+        int node;
+        double sig;
+        Range pq;
+    };
+    struct Solved           // ancestor during the backtrace
+    {
+        int node;
+        double x;
+    };
+
+    if (n == 0)
+        return;
+    block = std::max<size_t>(block, 1);
+    const int root = postorder[n-1];
+    if (parent[root] != root)
+        throw std::invalid_argument(
+            std::string("tree_dp_stream(): postorder[n-1] = ") +
+            std::to_string(root) + " is not the root");
+    constexpr bool check = !Wmu::is_const();
+    const size_t
+        ev_bytes = 2 * n * sizeof(Event),
+        lb_bytes = n * sizeof(double);
+    Timer timer ("scratch");
+    ScratchFile scratch (ev_bytes + 2 * lb_bytes, scratch_dir);
+    auto *elements = reinterpret_cast<Event *>(scratch.data());
+    auto *lb = reinterpret_cast<double *>(scratch.data() + ev_bytes);
+    auto *ub = lb + n;
+    timer.stop();
+
+    std::vector<Open> open;
+    uvector<Event> merge_buf;
+    {   Timer _ ("forward");
+        size_t released = 0;            // events below are dead
+        for (size_t k0 = 0; k0 + 1 < n; k0 += block) {
+            const size_t k1 = std::min(k0 + block, n - 1);
+            for (size_t k = k0; k < k1; k++) {
+                const auto i = postorder[k];
+                double sig_i = 0.0;
+                Range pq_i {queue_start[i], queue_start[i]-1};
+                if (!open.empty() && open.back().node == i) {
+                    sig_i = open.back().sig;
+                    pq_i = open.back().pq;
+                    open.pop_back();
+                }
+                lb[k] = clip<+1, check>(
+                    elements, pq_i, +mu[i], -mu[i]*y[i] - sig_i + lam[i]);
+                ub[k] = clip<-1, check>(
+                    elements, pq_i, -mu[i], +mu[i]*y[i] - sig_i + lam[i]);
+                const auto p = parent[i];
+                const double s =
+                    (check && mu[i] <= EPS) ? std::min(lam[i], sig_i) : lam[i];
+                if (!open.empty() && open.back().node == p) {
+                    open.back().sig += s;
+                    open.back().pq =
+                        merge2(open.back().pq, pq_i, elements, false, &merge_buf);
+                } else {
+                    open.push_back(Open{p, s, pq_i});
+                }
+            }
+            scratch.spill(ev_bytes + k0 * sizeof(double), (k1 - k0) * sizeof(double));
+            scratch.spill(ev_bytes + lb_bytes + k0 * sizeof(double),
+                          (k1 - k0) * sizeof(double));
+            // all future queues start at or above the bottom open queue
+            const size_t low = size_t(std::max(open.front().pq.start - 1, 0));
+            if (low > released) {
+                scratch.discard(released * sizeof(Event), (low - released) * sizeof(Event));
+                released = low;
+            }
+        }
+    }
+
+    std::vector<int> nodes;
+    std::vector<double> xs;
+    nodes.reserve(std::min(block, n));
+    xs.reserve(std::min(block, n));
+    const auto emit = [&](const int v, const double x_v) {
+        nodes.push_back(v);
+        xs.push_back(x_v);
+        if (nodes.size() >= block) {
+            write_x(nodes.data(), static_cast<const double *>(xs.data()), nodes.size());
+            nodes.clear();
+            xs.clear();
+        }
+    };
+    {   Timer _ ("backtrace");
+        const auto r = root;
+        double sig_r = 0.0;
+        Range pq_r {queue_start[r], queue_start[r]-1};
+        if (!open.empty()) {
+            if (open.size() != 1 || open.back().node != r)
+                throw std::invalid_argument("tree_dp_stream(): invalid postorder");
+            sig_r = open.back().sig;
+            pq_r = open.back().pq;
+        }
+        const double x_r =
+            clip<+1, check>(elements, pq_r, +mu[r], -mu[r]*y[r] - sig_r + 0.0);
+        scratch.discard(0, ev_bytes);
+
+        std::vector<Solved> path {Solved{r, x_r}};
+        emit(r, x_r);
+        for (size_t k1 = n - 1; k1 > 0; ) {
+            const size_t k0 = k1 > block ? k1 - block : 0;
+            scratch.willneed(ev_bytes + k0 * sizeof(double), (k1 - k0) * sizeof(double));
+            scratch.willneed(ev_bytes + lb_bytes + k0 * sizeof(double),
+                             (k1 - k0) * sizeof(double));
+            for (size_t k = k1; k-- > k0; ) {
+                const auto v = postorder[k];
+                const auto p = parent[v];
+                while (!path.empty() && path.back().node != p)
+                    path.pop_back();
+                if (path.empty())
+                    throw std::invalid_argument("tree_dp_stream(): invalid postorder");
+                const double x_v = clamp(path.back().x, lb[k], ub[k]);
+                path.push_back(Solved{v, x_v});
+                emit(v, x_v);
+            }
+            scratch.discard(ev_bytes + k0 * sizeof(double), (k1 - k0) * sizeof(double));
+            scratch.discard(ev_bytes + lb_bytes + k0 * sizeof(double),
+                            (k1 - k0) * sizeof(double));
+            k1 = k0;
+        }
+        if (!nodes.empty())
+            write_x(nodes.data(), static_cast<const double *>(xs.data()), nodes.size());
+    }
+}
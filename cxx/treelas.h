@@ -0,0 +1,97 @@
+/**
+   C interface of libtreelas.
+
+   A solver is created once for problems of `n` nodes and keeps all the
+   memory that the solvers need, i.e. solving the same kind of problem
+   repeatedly does not allocate.  A tree is registered with
+   `treelas_set_tree_*` (its processing orders are computed once) and can
+   then be solved for many signals.
+
+   Weights `lam`, `mu`: if the pointer is NULL, the scalar (`lam_c`,
+   `mu_c`) is used for every node (edge); `lam[i]` belongs to the edge
+   (i, parent[i]) on trees and (i, i+1) on lines.
+   Signals `x`, `y` may be the same array.
+
+   All functions returning `int` return 0 on success; otherwise the
+   message is available via `treelas_error`.  A solver must not be used
+   by several threads at the same time.
+ */
+#ifndef TREELAS_H
+#define TREELAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TREELAS_API
+#  define TREELAS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct treelas_solver treelas_solver;
+
+/** Objectives of a solution (`gap` is summed edge by edge) */
+typedef struct treelas_objective
+{
+    double primal, dual, gap;
+} treelas_objective;
+
+/** NULL if the memory could not be allocated */
+TREELAS_API treelas_solver *treelas_create(size_t n);
+TREELAS_API void treelas_destroy(treelas_solver *s);
+TREELAS_API size_t treelas_size(const treelas_solver *s);
+TREELAS_API const char *treelas_error(const treelas_solver *s);
+
+/** Register the tree; `root < 0`: search for it */
+TREELAS_API int treelas_set_tree_i32(treelas_solver *s, const int32_t *parent,
+                                     int32_t root);
+TREELAS_API int treelas_set_tree_i64(treelas_solver *s, const int64_t *parent,
+                                     int64_t root);
+
+/** Solve on the registered tree */
+TREELAS_API int treelas_tree_f64(treelas_solver *s, double *x, const double *y,
+                                 const double *lam, double lam_c,
+                                 const double *mu, double mu_c);
+TREELAS_API int treelas_tree_f32(treelas_solver *s, float *x, const float *y,
+                                 const float *lam, float lam_c,
+                                 const float *mu, float mu_c);
+
+/** As above; in the same passes, compute the edge flows `alpha` (see
+    `tree_dual`; `alpha[root]` is NaN) and the objectives `obj`.
+    Either may be NULL. */
+TREELAS_API int treelas_tree_dual_f64(treelas_solver *s, double *x, const double *y,
+                                      const double *lam, double lam_c,
+                                      const double *mu, double mu_c, double *alpha,
+                                      treelas_objective *obj);
+TREELAS_API int treelas_tree_dual_f32(treelas_solver *s, float *x, const float *y,
+                                      const float *lam, float lam_c,
+                                      const float *mu, float mu_c, float *alpha,
+                                      treelas_objective *obj);
+
+/** `k` signals (each of length n, consecutive in `y` and `x`) on the
+    registered tree; signal j with the scalar `lam[j]` and `mu = 1` */
+TREELAS_API int treelas_tree_batch_f64(treelas_solver *s, size_t k, double *x,
+                                       const double *y, const double *lam);
+TREELAS_API int treelas_tree_batch_f32(treelas_solver *s, size_t k, float *x,
+                                       const float *y, const float *lam);
+
+/** Solve on the line 0 - 1 - ... - (n-1); `mu[n-1]` must be positive */
+TREELAS_API int treelas_line_f64(treelas_solver *s, double *x, const double *y,
+                                 const double *lam, double lam_c,
+                                 const double *mu, double mu_c);
+TREELAS_API int treelas_line_f32(treelas_solver *s, float *x, const float *y,
+                                 const float *lam, float lam_c,
+                                 const float *mu, float mu_c);
+
+TREELAS_API int treelas_line_batch_f64(treelas_solver *s, size_t k, double *x,
+                                       const double *y, const double *lam);
+TREELAS_API int treelas_line_batch_f32(treelas_solver *s, size_t k, float *x,
+                                       const float *y, const float *lam);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* TREELAS_H */
@@ -117,6 +117,61 @@ public:
     void owrite(const char *data_name, const std::vector<T> &data,
                 Dims *dims = nullptr);
 
+    /** Read the hyperslab `[offset, offset + count)` of an existing
+        dataset (in C-order, like `read`), e.g. one tile of an image. */
+    template<typename T>
+    std::vector<T> read_slab(const char *data_name, const Dims &offset,
+                             const Dims &count);
+
+    /** Create a new dataset without writing data (to be filled by
+        `write_slab`); `overwrite` an existing one. */
+    template<typename T>
+    void create(const char *data_name, const Dims &dims,
+                bool overwrite = false);
+
+    /** Write `data` into the hyperslab `[offset, offset + count)` of an
+        existing dataset */
+    template<typename T>
+    void write_slab(const char *data_name, const std::vector<T> &data,
+                    const Dims &offset, const Dims &count);
+
+    /** Blockwise access to a one-dimensional dataset that may not fit
+        into memory.  The dataset stays open as long as the stream exists;
+        the file (`HDF5` object) has to outlive it as well. */
+    template<typename T>
+    class Stream
+    {
+    public:
+        Stream(hid_t loc_id, const char *data_name, bool writable);
+        Stream(Stream &&other);
+        Stream(const Stream &) = delete;
+       ~Stream();
+
+        /** Number of elements */
+        size_t size() const { return n; }
+
+        /** Read the elements `[offset, offset + count)` into `buf` */
+        void read(size_t offset, size_t count, T *buf);
+
+        /** Write `buf` to the elements `[offset, offset + count)` */
+        void write(size_t offset, size_t count, const T *buf);
+
+    private:
+        hid_t did = -1, fsid = -1;
+        size_t n = 0;
+        bool writable = false;
+        std::string name;
+        void _io(size_t offset, size_t count, void *buf, bool write);
+    };
+
+    /** Open an existing one-dimensional dataset for blockwise reading
+        (and writing unless the file was opened with "r").  New datasets
+        can be made by `create`. */
+    template<typename T>
+    Stream<T> stream(const char *data_name) {
+        return Stream<T>(group_id, data_name, !read_only());
+    }
+
     /** Disable libhdf5 warnings/errors */
     static void shutup();
 
@@ -768,6 +823,197 @@ HDF5::owrite(const char *name, const std::vector<T> &data, Dims *dims)
 }
 
 
+inline herr_t
+_slab_io(hid_t loc_id,
+         const char *dset_name,
+         hid_t tid,
+         const HDF5::Dims &offset,
+         const HDF5::Dims &count,
+         void *data,
+         bool write)
+{
+    hid_t
+        did = -1,
+        fsid = -1,
+        msid = -1;
+
+    if (dset_name == NULL || offset.size() != count.size())
+        return -1;
+    if ((did = H5Dopen2(loc_id, dset_name, H5P_DEFAULT)) < 0)
+        return -1;
+    if ((fsid = H5Dget_space(did)) < 0)
+        goto out;
+    if (H5Sget_simple_extent_ndims(fsid) != int(count.size()))
+        goto out;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, offset.data(), NULL,
+                            count.data(), NULL) < 0)
+        goto out;
+    if ((msid = H5Screate_simple(int(count.size()), count.data(), NULL)) < 0)
+        goto out;
+    if (write) {
+        if (H5Dwrite(did, tid, msid, fsid, H5P_DEFAULT, data) < 0)
+            goto out;
+    } else {
+        if (H5Dread(did, tid, msid, fsid, H5P_DEFAULT, data) < 0)
+            goto out;
+    }
+    if (H5Sclose(msid) < 0 || H5Sclose(fsid) < 0)
+        goto out;
+    msid = fsid = -1;
+    if (H5Dclose(did) < 0)
+        return -1;
+    return 0;
+
+out:
+    H5E_BEGIN_TRY {
+        H5Sclose(msid);
+        H5Sclose(fsid);
+        H5Dclose(did);
+    } H5E_END_TRY;
+    return -1;
+}
+
+
+template<typename T>
+std::vector<T>
+HDF5::read_slab(const char *data_name, const Dims &offset, const Dims &count)
+{
+    if (!has(data_name))
+        throw std::runtime_error(std::string("Does not exist \"") +
+                                 data_name + "\"");
+    std::vector<T> buf (size(count));
+    status = _slab_io(group_id, data_name, h5t<T>(), offset, count,
+                      buf.data(), false);
+    check_error(std::string("read_slab: '") + data_name + "'");
+    return buf;
+}
+
+
+template<typename T>
+void
+HDF5::create(const char *name, const Dims &dims, bool overwrite)
+{
+    if (read_only())
+        throw std::runtime_error(std::string("Cannot create \"") + name +
+                                 "\": file is opened read-only");
+    if (overwrite && has(name))
+        H5Ldelete(group_id, name, H5P_DEFAULT);
+    // no compression: it would need chunks of the size of `dims`
+    status = make_dataset(group_id, name, int(dims.size()), dims.data(),
+                          h5t<T>(), nullptr);
+    check_error(std::string("create: '") + name + "'");
+}
+
+
+template<typename T>
+void
+HDF5::write_slab(const char *name, const std::vector<T> &data,
+                 const Dims &offset, const Dims &count)
+{
+    if (read_only())
+        throw std::runtime_error(std::string("Cannot write \"") + name +
+                                 "\": file is opened read-only");
+    if (data.size() != size(count))
+        throw std::runtime_error(std::string("write_slab: '") + name +
+                                 "': size mismatch");
+    status = _slab_io(group_id, name, h5t<T>(), offset, count,
+                      const_cast<T*>(data.data()), true);
+    check_error(std::string("write_slab: '") + name + "'");
+}
+
+
+template<typename T>
+HDF5::Stream<T>::Stream(hid_t loc_id, const char *data_name, bool writable)
+    : writable(writable), name(data_name)
+{
+    hsize_t dim = 0;
+    {
+        ShutUp _;
+        did = H5Dopen2(loc_id, data_name, H5P_DEFAULT);
+    }
+    if (did < 0)
+        throw std::runtime_error(std::string("stream: '") + data_name +
+                                 "' does not exist");
+    if ((fsid = H5Dget_space(did)) < 0 ||
+        H5Sget_simple_extent_ndims(fsid) != 1 ||
+        H5Sget_simple_extent_dims(fsid, &dim, NULL) < 0) {
+        H5E_BEGIN_TRY {
+            H5Sclose(fsid);
+            H5Dclose(did);
+        } H5E_END_TRY;
+        throw std::runtime_error(std::string("stream: '") + data_name +
+                                 "' is not one-dimensional");
+    }
+    n = size_t(dim);
+}
+
+
+template<typename T>
+HDF5::Stream<T>::Stream(Stream &&other)
+    : did(other.did), fsid(other.fsid), n(other.n),
+      writable(other.writable), name(other.name)
+{
+    other.did = other.fsid = -1;
+}
+
+
+template<typename T>
+HDF5::Stream<T>::~Stream()
+{
+    if (fsid >= 0)
+        H5Sclose(fsid);
+    if (did >= 0)
+        H5Dclose(did);
+}
+
+
+template<typename T>
+void
+HDF5::Stream<T>::_io(size_t offset, size_t count, void *buf, bool write)
+{
+    if (offset + count > n)
+        throw std::runtime_error(std::string("stream: '") + name + "': [" +
+                                 std::to_string(offset) + ", " +
+                                 std::to_string(offset + count) +
+                                 ") out of range");
+    if (count == 0)
+        return;
+    const hsize_t off = offset, cnt = count;
+    hid_t msid = -1;
+    herr_t status = -1;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, &off, NULL, &cnt, NULL) >= 0 &&
+        (msid = H5Screate_simple(1, &cnt, NULL)) >= 0) {
+        status = write ?
+            H5Dwrite(did, h5t<T>(), msid, fsid, H5P_DEFAULT, buf) :
+            H5Dread(did, h5t<T>(), msid, fsid, H5P_DEFAULT, buf);
+    }
+    if (msid >= 0)
+        H5Sclose(msid);
+    if (status < 0)
+        throw std::runtime_error(std::string("stream: could not ") +
+                                 (write ? "write '" : "read '") + name + "'");
+}
+
+
+template<typename T>
+void
+HDF5::Stream<T>::read(size_t offset, size_t count, T *buf)
+{
+    _io(offset, count, buf, false);
+}
+
+
+template<typename T>
+void
+HDF5::Stream<T>::write(size_t offset, size_t count, const T *buf)
+{
+    if (!writable)
+        throw std::runtime_error(std::string("Cannot write \"") + name +
+                                 "\": file is opened read-only");
+    _io(offset, count, const_cast<T*>(buf), true);
+}
+
+
 std::string
 HDF5::libversion()
 {
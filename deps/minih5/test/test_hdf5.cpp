@@ -1,4 +1,5 @@
 #include <doctest/doctest.h>
+#include <algorithm>
 #include <cerrno>
 #include <regex>
 
@@ -205,3 +206,79 @@ TEST_CASE_FIXTURE(HDF5Test, "write_readonly")
                           std::runtime_error);
     }
 }
+
+
+TEST_CASE_FIXTURE(HDF5Test, "slab")
+{
+    // 3x4 matrix in C-order
+    const std::vector<double> x ({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
+    HDF5::Dims dims {3, 4};
+    {
+        HDF5 io (fname, "w");
+        io.write("x", x, &dims);
+        io.create<double>("z", dims);
+        REQUIRE_THROWS_AS(io.create<double>("z", dims), std::runtime_error);
+        io.create<double>("z", dims, true);
+        for (hsize_t i = 0; i < 3; i++)
+            io.write_slab("z", std::vector<double>({1.0*i, 2.0*i, 3.0*i, 4.0*i}),
+                          {i, 0}, {1, 4});
+        REQUIRE_THROWS_AS(io.write_slab("z", std::vector<double>({1.0}),
+                                        {0, 0}, {1, 2}),
+                          std::runtime_error);
+    }
+    {
+        HDF5 io (fname, "r");
+        const auto s = io.read_slab<double>("x", {1, 1}, {2, 2});
+        REQUIRE(s == std::vector<double>({5, 6, 9, 10}));
+        const auto c = io.read_slab<double>("x", {0, 3}, {3, 1});
+        REQUIRE(c == std::vector<double>({3, 7, 11}));
+        REQUIRE_THROWS_AS(io.read_slab<double>("x", {2, 2}, {2, 2}),
+                          std::runtime_error);
+        const auto z = io.read<double>("z");
+        REQUIRE(z == std::vector<double>({0, 0, 0, 0, 1, 2, 3, 4, 2, 4, 6, 8}));
+        REQUIRE_THROWS_AS(io.write_slab("z", std::vector<double>({1.0}),
+                                        {0, 0}, {1, 1}),
+                          std::runtime_error);
+    }
+}
+
+
+TEST_CASE_FIXTURE(HDF5Test, "stream")
+{
+    std::vector<double> x (1000);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = 0.5 * double(i);
+    {
+        HDF5 io (fname, "w");
+        io.write("x", x);
+        io.create<double>("z", {x.size()});
+    }
+    {
+        HDF5 io (fname, "r+");
+        auto xs = io.stream<double>("x");
+        auto zs = io.stream<double>("z");
+        REQUIRE(xs.size() == x.size());
+        std::vector<double> buf (64);
+        for (size_t i = 0; i < x.size(); i += buf.size()) {     // backwards
+            const size_t count = std::min(buf.size(), x.size() - i);
+            const size_t offset = x.size() - i - count;
+            xs.read(offset, count, buf.data());
+            REQUIRE(buf[0] == x[offset]);
+            for (size_t k = 0; k < count; k++)
+                buf[k] *= 2;
+            zs.write(offset, count, buf.data());
+        }
+        REQUIRE_THROWS_AS(xs.read(990, 11, buf.data()), std::runtime_error);
+        REQUIRE_THROWS_AS(io.stream<double>("nope"), std::runtime_error);
+    }
+    {
+        HDF5 io (fname, "r");
+        const auto z = io.read<double>("z");
+        REQUIRE(z.size() == x.size());
+        for (size_t i = 0; i < x.size(); i++)
+            REQUIRE(z[i] == 2 * x[i]);
+        auto zs = io.stream<double>("z");
+        double z0 = 1;
+        REQUIRE_THROWS_AS(zs.write(0, 1, &z0), std::runtime_error);
+    }
+}
@@ -14,6 +14,7 @@ namespace py = pybind11;
 
 void reg_line(py::module &m);
 void reg_tree(py::module &m);
+void reg_solver(py::module &m);
 void reg_timer(py::module &m);
 
 /**
@@ -104,5 +105,6 @@ PYBIND11_MODULE(_treelas, m)
 
     reg_line(m);
     reg_tree(m);
+    reg_solver(m);
     reg_timer(m);
 }
@@ -0,0 +1,45 @@
+/**
+   Cooperative cancellation of the solvers from Python (see sigint.hpp)
+ */
+#pragma once
+#include <limits>
+#include <pybind11/pybind11.h>
+
+#include "../cxx/sigint.hpp"
+
+namespace py = pybind11;
+
+
+constexpr double NO_TIMEOUT = std::numeric_limits<double>::infinity();
+
+
+/**
+   Run `f(const Cancel &)` without the GIL; [Ctrl-C] and the `timeout`
+   (seconds) stop it via the token.  Afterwards `KeyboardInterrupt` is
+   raised on [Ctrl-C], `TimeoutError` if `f` threw `Interrupted`.
+ */
+template <typename F>
+inline void
+interruptible(const double timeout, F f)
+{
+    Cancel cancel (timeout);
+    bool sigint = false, interrupted = false;
+    {
+        py::gil_scoped_release release;
+        SigintScope scope;
+        try {
+            f(static_cast<const Cancel &>(cancel));
+        } catch (const Interrupted &) {
+            interrupted = true;
+        }
+        sigint = SigintScope::raised();
+    }
+    if (sigint) {
+        PyErr_SetNone(PyExc_KeyboardInterrupt);
+        throw py::error_already_set();
+    }
+    if (interrupted) {
+        PyErr_SetString(PyExc_TimeoutError, "timeout exceeded");
+        throw py::error_already_set();
+    }
+}
@@ -9,6 +9,7 @@
 #include "../deps/condat/condat_tv_v2.hpp"
 
 #include "../cxx/line_dp.hpp"
+#include "../cxx/parallel.hpp"
 #include "../cxx/line/line_para.hpp"
 #include "../cxx/line/line_c.hpp"
 #include "../cxx/line/line_c2.hpp"
@@ -18,46 +19,63 @@
 namespace py = pybind11;
 
 
-template <typename LamFrom = py::array_f64&,
-          typename LamTo = Array<const double>,
-          typename MuFrom = py::array_f64&,
-          typename MuTo = Array<const double>,
+/**
+   `line_las` on views (e.g. `Numbers`, `Strided<float>`); allocates the
+   workspace like the pointer version in line_dp.hpp.
+ */
+template <bool CHECK, typename X, typename Y, typename Wlam, typename Wmu>
+inline void
+line_las_view(const size_t n, X x, const Y &y, const Wlam &lam, const Wmu &mu)
+{
+    if (n == 0)
+        return;
+    if (mu[n-1] <= 0)
+        throw std::invalid_argument("End node must not be latent");
+    uvector<Event> event;
+    uvector<double> ub;
+    {
+        Timer _ ("alloc");
+        event.reserve(2*n);
+        ub.reserve(n);
+    }
+    {
+        Timer _ ("dp");
+        line_las<CHECK>(n, x, y, lam, mu, event.data(), ub.data());
+    }
+}
+
+
+/**
+   `lam`, `mu` are either `double` or `py::array` (float64, float32 or
+   converted, any stride); so are `y` and `out`.
+ */
+template <typename LamFrom = py::array,
+          typename MuFrom = py::array,
           bool CHECK = true>
 void
 reg_line_las(py::module &m, const char *doc = "")
 {
     m.def("line_dp",
-          [](const py::array_f64 &y,
-             const LamFrom lam,
-             const MuFrom mu,
-             py::array_f64 &out,
+          [](py::array y,
+             LamFrom lam,
+             MuFrom mu,
+             py::array out,
              const bool verbose,
-             PerfTimer *timer) -> py::array_t<double>
+             PerfTimer *timer) -> py::array
           {
-              // printf("check = %s: %s %f\n", CHECK ? "true" : "false",
-              //        typeid(MuTo).name(),
-              //        convert(mu)[0]);
-              // fflush(stdout);
               TimerQuiet _ (verbose);
               const auto n = check_1d_len(y);
               check_len(n-0, mu, "mu1");
               check_len(n-1, lam, "lam");
-              if (is_empty(out)) {
-                  Timer _ ("alloc out");
-                  out = py::array_f64({n}, {sizeof(double)});
-              }
-              check_len(n, out, "out");
-              {
+              const auto yv = convert(y);
+              const auto lv = convert(lam);
+              const auto mv = convert(mu);
+              with_output({ssize_t(n)}, out, y, "out", [&](auto xv) {
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
-                  line_las<double, LamTo, MuTo, CHECK>(
-                      n,
-                      out.mutable_data(),
-                      y.data(),
-                      convert(lam),
-                      convert(mu)
-                  );
+                  line_las_view<CHECK>(n, xv, yv, lv, mv);
                   if (timer) timer->stop();
-              }
+              });
               return out;
           },
           doc,
@@ -86,10 +104,12 @@ reg_line(py::module &m)
                   out = py::array_t<double>({{n}}, {{sizeof(double)}});
               check_len(n, out, "out");
               {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
                   TV1D_denoise_v2(
                       y.data(),
-                      out.mutable_data(),
+                      xp,
                       (unsigned int)n,
                       lam);
                   if (timer) timer->stop();
@@ -125,12 +145,14 @@ reg_line(py::module &m)
               }
               check_len(n, out, "out");
               {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
                   glmgen::tf_dp(
                       int(n),
                       y.data(),
                       lam,
-                      out.mutable_data());
+                      xp);
                   if (timer) timer->stop();
               }
               return out;
@@ -166,12 +188,14 @@ reg_line(py::module &m)
               }
               check_len(n, out, "out");
               {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
                   dp_line_c(
                       n,
                       y.data(),
                       lam,
-                      out.mutable_data());
+                      xp);
                   if (timer) timer->stop();
               }
               return out;
@@ -200,12 +224,14 @@ reg_line(py::module &m)
                   out = py::array_t<double>({n}, {sizeof(double)});
               check_len(n, out, "out");
               {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
                   dp_line_c2(
                       n,
                       y.data(),
                       lam,
-                      out.mutable_data());
+                      xp);
                   if (timer) timer->stop();
               }
               return out;
@@ -236,9 +262,13 @@ reg_line(py::module &m)
                   out = py::array_t<double>({n}, {sizeof(double)});
               check_len(n, out, "out");
 
-              if (timer) timer->start();
-              line_para(n, y.data(), lam, out.mutable_data(), parallel);
-              if (timer) timer->stop();
+              {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
+                  if (timer) timer->start();
+                  line_para(n, y.data(), lam, xp, parallel);
+                  if (timer) timer->stop();
+              }
               return out;
           },
           R"pbdoc(
@@ -255,30 +285,21 @@ reg_line(py::module &m)
 
 
     m.def("line_dp",
-          [](const py::array_f64 &y,
+          [](py::array y,
              const double lam,
-             py::array_f64 &out,
+             py::array out,
              const bool verbose,
-             PerfTimer *timer) -> py::array_t<double>
+             PerfTimer *timer) -> py::array
           {
               TimerQuiet _ (verbose);
               const auto n = check_1d_len(y);
-              if (is_empty(out)) {
-                  Timer _ ("alloc out");
-                  out = py::array_f64({n}, {sizeof(double)});
-              }
-              check_len(n, out, "out");
-              {
+              const auto yv = convert(y);
+              with_output({ssize_t(n)}, out, y, "out", [&](auto xv) {
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
-                  line_las<double, Const<double>, Ones<double>, false>(
-                      n,
-                      out.mutable_data(),
-                      y.data(),
-                      convert(lam),
-                      convert()
-                  );
+                  line_las_view<false>(n, xv, yv, convert(lam), convert());
                   if (timer) timer->stop();
-              }
+              });
               return out;
           },
           "",
@@ -288,23 +309,62 @@ reg_line(py::module &m)
           py::arg("verbose") = false,
           py::arg("timer").none(true) = py::none());
 
-    reg_line_las<double, Const<double>,
-                 double, Const<double>, false>(m);
+    reg_line_las<double, double, false>(m);
 
-    reg_line_las<py::array_f64&, Array<const double>,
-                 double, Const<double>, false>(m);
+    reg_line_las<py::array, double, false>(m);
 
-    reg_line_las<double, Const<double>,
-                 py::array_f64&, Array<const double>, true>(m);
+    reg_line_las<double, py::array, true>(m);
 
-    reg_line_las<py::array_f64&, Array<const double>,
-                 py::array_f64&, Array<const double>, true>(m,
+    reg_line_las<py::array, py::array, true>(m,
             R"pbdoc(
                 Line solver (weights).
 
                 Memory: ??*len(y)*sizeof(uint32_t)
             )pbdoc");
 
+    m.def("line_dp_batch",
+          [](py::array y,
+             py::array lam,
+             py::array out,
+             const unsigned threads) -> py::array
+          {
+              TimerQuiet _ (false);
+              if (y.ndim() != 2)
+                  throw std::length_error("y must be of shape (k, n)");
+              const auto k = size_t(y.shape(0)), n = size_t(y.shape(1));
+              check_len(ssize_t(k), lam, "lam");
+              const auto yv = convert(y), lv = convert(lam);
+              const ssize_t ystep = y.strides(0);
+              with_output({ssize_t(k), ssize_t(n)}, out, y, "out", [&](auto xv) {
+                  const ssize_t xstep = out.strides(0) / out.itemsize();
+                  py::gil_scoped_release release;
+                  const unsigned nt = threads > 0 ? threads : default_threads();
+                  parallel_blocks(k, nt, [&](size_t begin, size_t end, unsigned) {
+                      uvector<Event> event;
+                      uvector<double> ub;
+                      event.reserve(2*n);
+                      ub.reserve(n);
+                      for (size_t j = begin; j < end && n > 0; j++) {
+                          auto xj = xv;
+                          xj.ptr += ssize_t(j) * xstep;
+                          line_las<false>(n, xj, yv.shift(ssize_t(j) * ystep),
+                                          Const<double>(lv[j]), Ones<double>(),
+                                          event.data(), ub.data());
+                      }
+                  });
+              });
+              return out;
+          },
+          R"pbdoc(
+              Solve the rows of `y` (shape `(k, n)`), row `j` with `lam[j]`,
+              distributed over `threads` native threads (default: all cores).
+              The GIL is released meanwhile.
+          )pbdoc",
+          py::arg("y"),
+          py::arg("lam"),
+          py::arg("out") = py::none(),
+          py::arg("threads") = 0);
+
 
     m.def("line_las3",
           [](const py::array_f64 &y,
@@ -329,12 +389,14 @@ reg_line(py::module &m)
                   check_len(n, out, "out");
               }
               {
+                  double *xp = out.mutable_data();
+                  py::gil_scoped_release release;
                   if (timer) timer->start();
                   dp_line_c3(
                       n,
                       y.data(),
                       lam,
-                      out.mutable_data());
+                      xp);
                   if (timer) timer->stop();
               }
               return out;
@@ -3,13 +3,19 @@
  */
 #pragma once
 #include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
 #include <pybind11/numpy.h>
 
+#include "../cxx/strided.hpp"
+
 
 namespace pybind11 {
 
 typedef array_t<double,  array::c_style | array::forcecast> array_f64;
 typedef array_t<int32_t, array::c_style | array::forcecast> array_i32;
+typedef array_t<float,   array::c_style | array::forcecast> array_f32;
 
 } // namespace pybind11::
 
@@ -66,3 +72,77 @@ check_1d_len(const py::array &a, const std::string &a_str = "?")
     }
     return a.shape(0);
 }
+
+
+/**
+   View on the last axis of a writable float64 (`T = double`) or float32
+   array without copying it; the strides must be a multiple of `sizeof(T)`.
+ */
+template <typename T>
+inline Strided<T>
+as_strided(py::array &a, const std::string &a_str = "?")
+{
+    const ssize_t stride = a.ndim() > 0 ? a.strides(a.ndim()-1) : ssize_t(sizeof(T));
+    if (stride % ssize_t(sizeof(T)) != 0)
+        throw std::invalid_argument(a_str + ": unaligned stride " +
+                                    std::to_string(stride));
+    return Strided<T>(static_cast<T *>(a.mutable_data()), stride / ssize_t(sizeof(T)));
+}
+
+
+/**
+   Call `f(x)` with a `Strided<double>` or `Strided<float>` view on `a`
+   (according to its dtype).  If `a` is empty, it is allocated with the
+   given `shape` and the same type as `like`.
+ */
+template <typename F>
+inline void
+with_output(const std::vector<ssize_t> &shape,
+            py::array &a,
+            const py::array &like,
+            const std::string &a_str,
+            F f)
+{
+    if (is_empty(a)) {
+        if (py::isinstance<py::array_t<float>>(like))
+            a = py::array_t<float>(shape);
+        else
+            a = py::array_t<double>(shape);
+    }
+    bool ok = a.ndim() == ssize_t(shape.size());
+    for (size_t d = 0; ok && d < shape.size(); d++)
+        ok = a.shape(ssize_t(d)) == shape[d];
+    if (!ok)
+        throw std::length_error(a_str + " has the wrong shape");
+    if (py::isinstance<py::array_t<double>>(a))
+        f(as_strided<double>(a, a_str));
+    else if (py::isinstance<py::array_t<float>>(a))
+        f(as_strided<float>(a, a_str));
+    else
+        throw py::type_error(a_str + " must be of type float64 or float32");
+}
+
+
+/**
+   The parent array as `const int *`: int32 C-contiguous arrays are used
+   directly, others (e.g. int64) are narrowed into `buf`.
+ */
+inline const int*
+as_parent(const py::array &parent, std::vector<int> &buf)
+{
+    if (py::isinstance<py::array_t<int32_t, py::array::c_style>>(parent))
+        return static_cast<const int *>(parent.data());
+    const auto p = py::array_t<int64_t, py::array::forcecast>::ensure(parent);
+    if (!p)
+        throw py::type_error("parent must be an integer array");
+    const auto pp = p.unchecked<1>();
+    const ssize_t n = pp.shape(0);
+    buf.resize(size_t(n));
+    for (ssize_t i = 0; i < n; i++) {
+        if (pp(i) < 0 || pp(i) >= n || pp(i) > std::numeric_limits<int>::max())
+            throw std::invalid_argument("parent[" + std::to_string(i) + "] = " +
+                                        std::to_string(pp(i)) + " out of range");
+        buf[size_t(i)] = int(pp(i));
+    }
+    return buf.data();
+}
@@ -19,6 +19,7 @@ sources = [
     "_treelas.cpp",
     "line.cpp",
     "tree.cpp",
+    "solver.cpp",
     "../cxx/tree_apx.cpp",
     "../deps/graphidx/python/timer.cpp",
     "../deps/condat/condat_tv_v2.cpp",
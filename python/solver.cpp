@@ -0,0 +1,141 @@
+#include <mutex>
+#include <vector>
+#include <pybind11/pybind11.h>
+
+#include <graphidx/tree/root.hpp>
+#include <graphidx/utils/timer.hpp>       // for TimerQuiet
+
+#include "../cxx/tree_dp.hpp"
+
+#include "interrupt.hpp"
+#include "py_np.hpp"
+#include "weights.hpp"
+
+namespace py = pybind11;
+
+
+/**
+   Tree topology (parent, root, post-order, queue positions) together with
+   the workspace of `tree_dp`: solving again does not allocate anything
+   except for the output (if not given).
+ */
+class TreeSolver
+{
+public:
+    TreeSolver(const py::array &parent_, int root_)
+        : n(check_1d_len(parent_, "parent")), status(n, false)
+    {
+        std::vector<int> buf;
+        const int *p = as_parent(parent_, buf);
+        parent.assign(p, p + n);
+        py::gil_scoped_release release;
+        root = root_ < 0 ? find_root(n, parent.data()) : root_;
+        if (root < 0 || size_t(root) >= n || parent[root] != root)
+            throw std::invalid_argument("root " + std::to_string(root) +
+                                        " is not a root");
+        tree_orders(n, parent.data(), root, postorder, queue_start);
+        if (postorder.size() != n)
+            throw std::invalid_argument("parent does not describe a tree");
+        z.resize(n);
+    }
+
+    /** `lam`, `mu` may be scalars or arrays (float64/float32, any stride) */
+    py::object
+    solve(py::array y,
+          const py::object &lam,
+          const py::object &mu,
+          py::array x,
+          const bool return_dual,
+          const bool verbose,
+          const double timeout)
+    {
+        TimerQuiet _ (verbose);
+        check_len(ssize_t(n), y, "y");
+        const auto yv = convert(y);
+        py::array lam_a, mu_a;
+        py::array_f64 alpha;
+        if (return_dual)
+            alpha = py::array_f64({n});
+        double *ap = return_dual ? alpha.mutable_data() : nullptr;
+        with_output({ssize_t(n)}, x, y, "x", [&](auto xv) {
+            with_weight(lam, lam_a, "lam", [&](const auto &lv) {
+                with_weight(mu, mu_a, "mu", [&](const auto &mv) {
+                    interruptible(timeout, [&](const Cancel &cancel) {
+                        std::lock_guard<std::mutex> lock (busy);
+                        TreeDPDual dual;
+                        dual.alpha = ap;
+                        const auto run = [&](const auto &yy) {
+                            tree_dp<false, true>(n, xv, yy, parent.data(), lv, mv,
+                                                 root, status, postorder.data(),
+                                                 queue_start.data(), &cancel,
+                                                 ap ? &dual : nullptr);
+                        };
+                        if (ap && x.data() == y.data()) {   // dual reads y late
+                            for (size_t i = 0; i < n; i++)
+                                z[i] = yv[i];
+                            run(static_cast<const double *>(z.data()));
+                        } else {
+                            run(yv);
+                        }
+                    });
+                });
+            });
+        });
+        if (return_dual)
+            return py::make_tuple(x, alpha);
+        return x;
+    }
+
+    const size_t n;
+    int root = -1;
+
+private:
+    /** Call `f` with `Const<double>` for scalars, `Numbers` for arrays */
+    template <typename F>
+    void
+    with_weight(const py::object &w, py::array &keep, const char *w_str, F f) const
+    {
+        if (py::isinstance<py::float_>(w) || py::isinstance<py::int_>(w))
+            return f(Const<double>(w.cast<double>()));
+        keep = py::array::ensure(w);
+        if (!keep)
+            throw py::type_error(std::string(w_str) + " must be a number or an array");
+        check_len(ssize_t(n), keep, w_str);
+        f(convert(keep));
+    }
+
+    std::vector<int> parent, postorder, queue_start;
+    TreeDPStatus status;
+    std::vector<double> z;              // copy of y if x aliases it
+    std::mutex busy;
+};
+
+
+void
+reg_solver(py::module &m)
+{
+    py::class_<TreeSolver>(m, "TreeSolver", R"pbdoc(
+            Dynamic programming solver for a fixed tree that keeps its
+            processing orders and memory between the calls of `solve`.
+        )pbdoc")
+        .def(py::init<const py::array &, int>(),
+             py::arg("parent"),
+             py::arg("root") = -1)
+        .def("solve", &TreeSolver::solve,
+             R"pbdoc(
+                 Solve for the signal `y`; `lam` and `mu` are numbers or arrays.
+                 If `return_dual`, return `(x, alpha)` (see `tree_dual`); the
+                 flows are accumulated within the backtrace of `tree_dp`.
+                 The GIL is released while solving; [Ctrl-C] raises
+                 `KeyboardInterrupt`, exceeding `timeout` seconds `TimeoutError`.
+             )pbdoc",
+             py::arg("y"),
+             py::arg("lam") = 1.0,
+             py::arg("mu") = 1.0,
+             py::arg("out") = py::none(),
+             py::arg("return_dual") = false,
+             py::arg("verbose") = false,
+             py::arg("timeout") = NO_TIMEOUT)
+        .def_readonly("root", &TreeSolver::root)
+        .def("__len__", [](const TreeSolver &s) { return s.n; });
+}
@@ -33,3 +33,21 @@ def test_root_sum(n=10, seed=42):
     assert np.flipud(c)  == approx(z)
     assert x.sum() + alpha[1:].sum() == approx(z.sum(), rel=1e-4), \
         f'\nrhs={x.sum() - alpha[1:].sum()}\nlhs={z.sum()}'
+
+
+def test_fused_dual(n=300, seed=2021):
+    rng = np.random.default_rng(seed)
+    parent = np.zeros(n, dtype=np.int32)
+    parent[1:] = (rng.random(n - 1) * np.arange(1, n)).astype(np.int32)
+    y = np.round(8 * rng.random(n))
+    lam = 0.5 * rng.random(n)
+    mu = rng.random(n) + 0.1
+    x, alpha, obj = tl.tree_dp(y, parent, lam, mu, root=0, return_dual=True)
+    assert (x == tl.tree_dp(y, parent, lam, mu, root=0)).all()
+    expected = tl.tree_dual(parent, mu * (x - y), root=0)
+    assert np.isnan(alpha[0])
+    assert alpha[1:] == approx(expected[1:])
+    gamma = tl.tree_dual_gap(x, alpha, lam, parent)
+    assert obj["gap"] == approx((lam * gamma)[1:].sum(), abs=1e-9)
+    assert obj["primal"] - obj["dual"] == approx(obj["gap"], abs=1e-9)
+    assert abs(obj["gap"]) < 1e-8 * obj["primal"]
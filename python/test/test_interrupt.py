@@ -0,0 +1,21 @@
+import numpy as np
+import pytest
+from treelas import TreeSolver, tree_apx
+
+
+def test_solver_timeout():
+    parent = np.arange(1000) // 2
+    y = np.random.default_rng(2021).normal(size=len(parent))
+    solver = TreeSolver(parent)
+    with pytest.raises(TimeoutError):
+        solver.solve(y, lam=0.1, timeout=0.0)
+    x = solver.solve(y, lam=0.1, timeout=60.0)
+    assert np.isfinite(x).all()
+
+
+def test_apx_anytime():
+    parent = (np.arange(1000) // 2).astype(np.int32)
+    y = np.random.default_rng(2021).normal(size=len(parent))
+    x = tree_apx(parent, y, lam=0.1, max_iter=10, timeout=0.0)
+    assert (x == x[0]).all()            # no iteration: the initial guess
+    assert x[0] == 0.5 * (y.min() + y.max())
@@ -0,0 +1,44 @@
+import numpy as np
+import pytest
+from treelas import TreeSolver, tree_dp, tree_dual
+
+
+def test_solver_reuse():
+    parent = np.array([0, 0, 0, 1, 1, 2, 2], dtype=np.int64)
+    y = np.array([0.0, 0.5, 0.0, 1.0, 3.0, 0.0, 2.0])
+    solver = TreeSolver(parent)
+    assert solver.root == 0
+    assert len(solver) == len(y)
+    x = np.empty_like(y)
+    for lam in [0.01, 0.3, 1.0, 5.0]:
+        out = solver.solve(y, lam=lam, out=x)
+        assert out is x
+        assert np.abs(x - tree_dp(y, parent, lam=lam)).max() < 1e-12
+
+
+def test_solver_weights_dual():
+    rng = np.random.default_rng(2021)
+    n = 500
+    parent = np.zeros(n, dtype=np.int32)
+    parent[1:] = (rng.random(n - 1) * np.arange(1, n)).astype(np.int32)
+    y = rng.normal(size=n)
+    lam = rng.random(n)
+    mu = rng.random(n) + 0.1
+    solver = TreeSolver(parent, root=0)
+    x, alpha = solver.solve(y, lam, mu, return_dual=True)
+    assert np.abs(x - tree_dp(y, parent, lam, mu, root=0)).max() < 1e-12
+    expected = tree_dual(parent, mu * (x - y), root=0)
+    assert np.isnan(alpha[0])
+    assert np.abs(alpha[1:] - expected[1:]).max() < 1e-12
+
+    xf = solver.solve(y.astype(np.float32), lam.astype(np.float32), mu)
+    assert xf.dtype == np.float32
+    assert np.abs(xf - x).max() < 1e-4
+
+
+def test_solver_errors():
+    with pytest.raises(ValueError):
+        TreeSolver(np.array([1, 2, 0]))
+    solver = TreeSolver(np.array([0, 0]))
+    with pytest.raises(Exception):
+        solver.solve(np.zeros(3))
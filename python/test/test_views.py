@@ -0,0 +1,90 @@
+"""dtypes, strides and batches without copies; the GIL is released"""
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+from treelas import line_dp, line_dp_batch, tree_dp, tree_dp_batch
+
+
+def random_tree(n, seed=2021):
+    rng = np.random.default_rng(seed)
+    parent = np.zeros(n, dtype=np.int64)
+    parent[1:] = (rng.random(n - 1) * np.arange(1, n)).astype(np.int64)
+    y = rng.normal(size=n)
+    return parent, y
+
+
+def test_tree_int64_float32_strided():
+    parent, y = random_tree(200)
+    expected = tree_dp(y, parent.astype(np.int32), lam=0.3, root=0)
+    x = tree_dp(y, parent, lam=0.3, root=0)
+    assert x.dtype == np.float64
+    assert np.abs(x - expected).max() < 1e-12
+
+    yy = np.zeros((len(y), 2))
+    yy[:, 1] = y
+    x = tree_dp(yy[:, 1], parent, lam=0.3)
+    assert np.abs(x - expected).max() < 1e-12
+
+    x = tree_dp(y.astype(np.float32), parent, lam=0.3)
+    assert x.dtype == np.float32
+    assert np.abs(x - expected).max() < 1e-5
+
+
+def test_tree_weights_float32():
+    parent, y = random_tree(100)
+    lam = np.full(len(y), 0.2)
+    mu = np.ones(len(y))
+    expected = tree_dp(y, parent.astype(np.int32), lam, mu, root=0)
+    out = np.empty((len(y), 3), dtype=np.float32)
+    x = tree_dp(y, parent, lam.astype(np.float32), mu[::-1], root=0, x=out[:, 2])
+    assert np.abs(out[:, 2] - expected).max() < 1e-5
+    assert np.abs(x - expected).max() < 1e-5
+
+
+def test_tree_batch():
+    parent, y = random_tree(300)
+    lams = np.array([0.01, 0.1, 1.0, 5.0])
+    ys = np.vstack([y + j for j in range(len(lams))])
+    xs = tree_dp_batch(ys, parent, lams, threads=3)
+    for j, lam in enumerate(lams):
+        x = tree_dp(ys[j], parent, lam=lam)
+        assert np.abs(xs[j] - x).max() < 1e-12
+
+
+def test_line_views():
+    _, y = random_tree(150)
+    expected = line_dp(y, 0.4)
+    assert np.abs(line_dp(y.astype(np.float32), 0.4) - expected).max() < 1e-5
+    yy = np.repeat(y, 2)
+    assert np.abs(line_dp(yy[::2], 0.4) - expected).max() < 1e-12
+
+    lams = np.array([0.1, 0.4])
+    xs = line_dp_batch(np.vstack([y, y]), lams, threads=2)
+    assert np.abs(xs[1] - expected).max() < 1e-12
+    assert np.abs(xs[0] - line_dp(y, 0.1)).max() < 1e-12
+
+
+def test_python_threads():
+    parent, y = random_tree(10000)
+    lams = [0.1 * j for j in range(1, 9)]
+    with ThreadPoolExecutor(4) as pool:
+        xs = list(pool.map(lambda lam: tree_dp(y, parent, lam=lam), lams))
+    for lam, x in zip(lams, xs):
+        assert np.abs(x - tree_dp(y, parent, lam=lam)).max() == 0
+
+
+def test_python_threads_merge_sort():
+    parent, y = random_tree(50000)
+    lams = [0.1 * j for j in range(1, 9)]
+    w = np.ones(len(y))
+
+    def solve(lam):
+        return (tree_dp(y, parent, lam=lam, merge_sort=True),
+                tree_dp(y, parent, lam * w, w, root=0))
+
+    expected = [solve(lam) for lam in lams]
+    with ThreadPoolExecutor(4) as pool:
+        results = list(pool.map(solve, lams))
+    for (x1, x2), (e1, e2) in zip(results, expected):
+        assert np.abs(x1 - e1).max() == 0
+        assert np.abs(x2 - e2).max() == 0
@@ -1,3 +1,5 @@
+#include <atomic>
+#include <cmath>            // std::isfinite
 #include <pybind11/pybind11.h>
 
 #include <graphidx/bits/finite.hpp>
@@ -6,13 +8,57 @@
 #include "../cxx/tree_apx.hpp"
 #include "../cxx/tree_dp.hpp"
 #include "../cxx/tree_dual.hpp"
+#include "../cxx/merge.hpp"        // tree_orders
+#include "../cxx/parallel.hpp"
 
+#include "interrupt.hpp"
 #include "py_np.hpp"
 #include "weights.hpp"
 
 namespace py = pybind11;
 
 
+/** Index of the first element of `a` that is not finite (`n` if none) */
+template <typename A>
+inline size_t
+first_non_finite(const A &a, const size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (!std::isfinite(a[i]))
+            return i;
+    return n;
+}
+
+
+/** Fused certificate of `tree_dp` (if requested); `x` must not alias `y` */
+inline TreeDPDual*
+prepare_dual(const bool return_dual, const py::array &x, const py::array &y,
+             py::array_f64 &alpha, TreeDPDual &dual)
+{
+    if (!return_dual)
+        return nullptr;
+    if (x.data() == y.data())
+        throw py::value_error("x must not share memory with y for return_dual");
+    alpha = py::array_f64({x.shape(0)});
+    dual.alpha = alpha.mutable_data();
+    return &dual;
+}
+
+
+/** `x` or `(x, alpha, {"primal": .., "dual": .., "gap": ..})` */
+inline py::object
+dp_result(const py::array &x, const py::array_f64 &alpha, const TreeDPDual *dual)
+{
+    if (!dual)
+        return x;
+    py::dict obj;
+    obj["primal"] = dual->primal;
+    obj["dual"] = dual->dual;
+    obj["gap"] = dual->gap;
+    return py::make_tuple(x, alpha, obj);
+}
+
+
 void
 reg_tree(py::module &m)
 {
@@ -23,7 +69,8 @@ reg_tree(py::module &m)
              int max_iter,
              bool verbose,
              py::array_f64 x,
-             bool reorder) -> py::array_f64
+             bool reorder,
+             const double timeout) -> py::array_f64
           {
               TimerQuiet _ (verbose);
               const auto n = check_1d_len(parent, "parent");
@@ -33,19 +80,26 @@ reg_tree(py::module &m)
               if (is_empty(x))
                   x = py::array_t<double>({n}, {sizeof(double)});
               check_len(n, x, "x");
-              tree_apx(n,
-                       parent.data(),
-                       y.data(),
-                       lam,
-                       x.mutable_data(),
-                       root,
-                       max_iter,
-                       print_timings,
-                       reorder);
+              double *xp = x.mutable_data();
+              interruptible(timeout, [&](const Cancel &cancel) {
+                  tree_apx(n,
+                           parent.data(),
+                           y.data(),
+                           lam,
+                           xp,
+                           root,
+                           max_iter,
+                           print_timings,
+                           reorder,
+                           false,
+                           static_cast<const int *>(nullptr),
+                           &cancel);
+              });
               return x;
           },
           R"pbdoc(
             Perform `max_iter` iterations in O(n) time to approximate flsa on tree.
+            After `timeout` seconds, the current iterate is returned.
           )pbdoc",
           py::arg("parent"),
           py::arg("y"),
@@ -53,58 +107,57 @@ reg_tree(py::module &m)
           py::arg("max_iter") = 10,
           py::arg("verbose") = false,
           py::arg("x") = py::none(),
-          py::arg("reorder") = true);
+          py::arg("reorder") = true,
+          py::arg("timeout") = NO_TIMEOUT);
 
     m.def("tree_dp",
-          [](const py::array_f64 &y,
-             const py::array_i32 &parent,
+          [](py::array y,
+             const py::array &parent,
              const double lam,
              const int32_t root,
              const double mu,
-             py::array_f64 &x,
+             py::array x,
              const bool verbose,
              const bool merge_sort,
-             const bool lazy_sort) -> py::array_f64
+             const bool lazy_sort,
+             const bool return_dual) -> py::object
           {
               TimerQuiet _ (verbose);
               const auto n = check_1d_len(y, "y");
               check_len(n, parent, "parent");
-              if (is_empty(x)) {
-                  Timer _ ("allocate x");
-                  x = py::array_t<double>({n}, {sizeof(double)});
-              }
-              check_len(n, x, "x");
-              if (merge_sort) {
-                  tree_dp<true>(n,
-                                x.mutable_data(),
-                                y.data(),
-                                parent.data(),
-                                lam,
-                                mu,
-                                root);
-              } else {
-                  if (lazy_sort)
-                      tree_dp<false, true>(n,
-                                           x.mutable_data(),
-                                           y.data(),
-                                           parent.data(),
-                                           lam,
-                                           mu,
-                                           root);
-                  else
-                      tree_dp<false, false>(n,
-                                            x.mutable_data(),
-                                            y.data(),
-                                            parent.data(),
-                                            lam,
-                                            mu,
-                                            root);
-              }
+              const auto yv = convert(y);
+              std::vector<int> pbuf;
+              const int *p = as_parent(parent, pbuf);
+              py::array_f64 alpha;
+              TreeDPDual dual, *d = nullptr;
+              with_output({ssize_t(n)}, x, y, "x", [&](auto xv) {
+                  d = prepare_dual(return_dual, x, y, alpha, dual);
+                  interruptible(NO_TIMEOUT, [&](const Cancel &c) {
+                      TreeDPStatus s (n);
+                      const Const<double> _lam (lam), _mu (mu);
+                      if (merge_sort)
+                          tree_dp<true, false>(
+                              n, xv, yv, p, _lam, _mu, root, s, nullptr, nullptr,
+                              &c, d);
+                      else if (lazy_sort)
+                          tree_dp<false, true>(
+                              n, xv, yv, p, _lam, _mu, root, s, nullptr, nullptr,
+                              &c, d);
+                      else
+                          tree_dp<false, false>(
+                              n, xv, yv, p, _lam, _mu, root, s, nullptr, nullptr,
+                              &c, d);
+                  });
+              });
               Timer::stopit();
-              return x;
+              return dp_result(x, alpha, d);
           },
           R"pbdoc(
               Dynamic programming algorithm for trees (uniform weighting)
+
+              If `return_dual`, also return the edge flows `alpha` (see
+              `tree_dual`) and a dict of the primal and dual objective and
+              the duality gap, computed in the same passes.
             )pbdoc",
           py::arg("y"),
           py::arg("parent"),
@@ -114,7 +167,8 @@ reg_tree(py::module &m)
           py::arg("x") = py::none(),
           py::arg("verbose") = false,
           py::arg("merge_sort") = false,
-          py::arg("lazy_sort") = false);
+          py::arg("lazy_sort") = false,
+          py::arg("return_dual") = false);
 
     m.def("tree_dual",
           [](const py::array_i32 &parent,
@@ -131,11 +185,14 @@ reg_tree(py::module &m)
                   alpha = py::array_f64({n}, {sizeof(double)});
               check_len(n, alpha, "alpha");
               TimerQuiet _ (verbose);
+              double *xp = x.mutable_data(), *ap = alpha.mutable_data();
+              const int *po = is_empty(post_ord) ? nullptr : post_ord.data();
+              py::gil_scoped_release release;
               tree_dual(int(n),
-                        x.mutable_data(),
+                        xp,
                         parent.data(),
-                        is_empty(post_ord) ? nullptr : post_ord.data(),
-                        alpha.mutable_data(),
+                        po,
+                        ap,
                         root,
                         tree_orientation);
               return alpha;
@@ -158,59 +215,64 @@ reg_tree(py::module &m)
           py::arg("verbose") = false);
 
     m.def("tree_dp",
-          [](const py::array_f64 &y,
-             const py::array_i32 &parent,
-             const py::array_f64 &lam,
-             const py::array_f64 &mu,
+          [](py::array y,
+             const py::array &parent,
+             py::array lam,
+             py::array mu,
              int root,
              const bool verbose,
              const bool lazy_sort,
-             py::array_f64 &x) -> py::array_f64
+             py::array x,
+             const bool return_dual) -> py::object
           {
               TimerQuiet _ (verbose);
               const auto n = check_1d_len(y, "y");
               check_len(n, parent, "parent");
               check_len(n, lam, "lam");
               check_len(n, mu, "mu");
-              if (is_empty(x))
-                  x = py::array_f64({n}, {sizeof(double)});
-              check_len(n, x, "x");
-              {   Timer _ ("check finite");
-                  check_all_finite(y.data(),  n, "y");
-                  check_all_finite(mu.data(), n, "mu");
-                  const size_t i = find_non_finite(lam.data(), n);
-                  if (i < n && int(i) != root) {
-                      throw std::runtime_error(
-                          std::string("lam[") + std::to_string(i) +
-                          "] = " + std::to_string(lam.unchecked<1>()(i)) +
-                          " ; root = " + std::to_string(root));
-                  }
-              }
+              const auto yv = convert(y), lv = convert(lam), mv = convert(mu);
+              std::vector<int> pbuf;
+              const int *p = as_parent(parent, pbuf);
+              py::array_f64 alpha;
+              TreeDPDual dual, *d = nullptr;
+              with_output({ssize_t(n)}, x, y, "x", [&](auto xv) {
+                  d = prepare_dual(return_dual, x, y, alpha, dual);
+                  interruptible(NO_TIMEOUT, [&](const Cancel &c) {
+                      {   Timer _ ("check finite");
+                          for (const auto &[a, a_str] : {std::make_pair(yv, "y"),
+                                                         std::make_pair(mv, "mu")}) {
+                              const size_t i = first_non_finite(a, n);
+                              if (i < n)
+                                  throw std::runtime_error(
+                                      std::string(a_str) + "[" + std::to_string(i) +
+                                      "] = " + std::to_string(a[i]) + " is not finite");
+                          }
+                          const size_t i = first_non_finite(lv, n);
+                          if (i < n && int(i) != root) {
+                              throw std::runtime_error(
+                                  std::string("lam[") + std::to_string(i) +
+                                  "] = " + std::to_string(lv[i]) +
+                                  " ; root = " + std::to_string(root));
+                          }
+                      }
 
-              constexpr auto merge_sort = true;
-              if (lazy_sort)
-                  tree_dp<merge_sort, true>(
-                      n,
-                      x.mutable_data(),
-                      y.data(),
-                      parent.data(),
-                      convert(lam),
-                      convert(mu),
-                      root);
-              else
-                  tree_dp<merge_sort, false>(
-                      n,
-                      x.mutable_data(),
-                      y.data(),
-                      parent.data(),
-                      convert(lam),
-                      convert(mu),
-                      root);
+                      // merge2 buffers live in `s`: safe without the GIL
+                      constexpr auto merge_sort = true;
+                      TreeDPStatus s (n);
+                      if (lazy_sort)
+                          tree_dp<merge_sort, true>(
+                              n, xv, yv, p, lv, mv, root, s, nullptr, nullptr, &c, d);
+                      else
+                          tree_dp<merge_sort, false>(
+                              n, xv, yv, p, lv, mv, root, s, nullptr, nullptr, &c, d);
+                  });
+              });
               Timer::stopit();
-              return x;
+              return dp_result(x, alpha, d);
           },
           R"pbdoc(
               Dynamic programming algorithm for trees (node and edge weighting)
+              (`return_dual`: see above)
           )pbdoc",
           py::arg("y"),
           py::arg("parent"),
@@ -219,7 +281,8 @@ reg_tree(py::module &m)
           py::arg("root") = -1,
           py::arg("verbose") = false,
           py::arg("lazy_sort") = false,
-          py::arg("x") = py::none());
+          py::arg("x") = py::none(),
+          py::arg("return_dual") = false);
 
     m.def("tree_dual_gap",
           [](const py::array_f64 &x,
@@ -235,10 +298,12 @@ reg_tree(py::module &m)
               if (is_empty(gamma))
                   gamma = py::array_f64({n}, {sizeof(double)});
               check_len(n, gamma, "gamma");
+              double *gp = gamma.mutable_data();
               if (lam.ndim() == 1) {
                   check_len(n, lam, "lam");
+                  py::gil_scoped_release release;
                   tree_dual_gap(n,
-                                gamma.mutable_data(),
+                                gp,
                                 x.data(),
                                 alpha.data(),
                                 lam.data(),
@@ -247,8 +312,9 @@ reg_tree(py::module &m)
               } else if (lam.ndim() == 0) {
                   // throw std::runtime_error(py::repr(lam).cast<std::string>());
                   const double la = lam.cast<double>();
+                  py::gil_scoped_release release;
                   tree_dual_gap(n,
-                                gamma.mutable_data(),
+                                gp,
                                 x.data(),
                                 alpha.data(),
                                 la,
@@ -266,4 +332,72 @@ reg_tree(py::module &m)
           py::arg("parent"),
           py::arg("root_val") = 0.0,
           py::arg("gamma") = py::none());
+
+    m.def("tree_dp_batch",
+          [](py::array y,
+             const py::array &parent,
+             py::array lam,
+             int root,
+             const double mu,
+             py::array x,
+             const unsigned threads) -> py::array
+          {
+              TimerQuiet _ (false);
+              const auto n = check_1d_len(parent, "parent");
+              if (y.ndim() != 2 || size_t(y.shape(1)) != n)
+                  throw std::length_error("y must be of shape (k, len(parent))");
+              const auto k = size_t(y.shape(0));
+              check_len(ssize_t(k), lam, "lam");
+              const auto yv = convert(y), lv = convert(lam);
+              const ssize_t ystep = y.strides(0);
+              std::vector<int> pbuf;
+              const int *p = as_parent(parent, pbuf);
+              if (root < 0)
+                  root = find_root(n, p);
+              if (root < 0 || size_t(root) >= n || p[root] != root)
+                  throw std::invalid_argument("root " + std::to_string(root) +
+                                              " is not a root");
+              with_output({ssize_t(k), ssize_t(n)}, x, y, "x", [&](auto xv) {
+                  const ssize_t xstep = x.strides(0) / x.itemsize();
+                  interruptible(NO_TIMEOUT, [&](const Cancel &c) {
+                      std::vector<int> postorder, queue_start;
+                      tree_orders(n, p, root, postorder, queue_start);
+                      if (postorder.size() != n)
+                          throw std::invalid_argument(
+                              "parent does not describe a tree");
+                      const unsigned nt = threads > 0 ? threads : default_threads();
+                      std::atomic<bool> stopped {false};
+                      parallel_blocks(k, nt, [&](size_t begin, size_t end, unsigned) {
+                          TreeDPStatus s (n, false);
+                          try {
+                              for (size_t j = begin; j < end; j++) {
+                                  auto xj = xv;
+                                  xj.ptr += ssize_t(j) * xstep;
+                                  tree_dp<false, true>(
+                                      n, xj, yv.shift(ssize_t(j) * ystep), p,
+                                      Const<double>(lv[j]), Const<double>(mu), root, s,
+                                      postorder.data(), queue_start.data(), &c);
+                              }
+                          } catch (const Interrupted &) {
+                              stopped = true;
+                          }
+                      });
+                      if (stopped)
+                          throw Interrupted("tree_dp_batch");
+                  });
+              });
+              return x;
+          },
+          R"pbdoc(
+              Solve the rows of `y` (shape `(k, n)`) on the same tree, row `j`
+              with `lam[j]`, distributed over `threads` native threads
+              (default: all cores).  The GIL is released meanwhile.
+          )pbdoc",
+          py::arg("y"),
+          py::arg("parent"),
+          py::arg("lam"),
+          py::arg("root") = -1,
+          py::arg("mu") = 1.0,
+          py::arg("x") = py::none(),
+          py::arg("threads") = 0);
 }
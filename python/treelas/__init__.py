@@ -41,14 +41,17 @@ from ._treelas import (
     line_condat,
     line_glmgen,
     line_dp,
+    line_dp_batch,
     line_para,
     line_lasc,
     line_las2,
     line_las3,
     tree_dp,
+    tree_dp_batch,
     tree_apx,
     tree_dual,
     tree_dual_gap,
+    TreeSolver,
 )
 
 
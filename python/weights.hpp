@@ -31,3 +31,43 @@ convert()
 {
     return Ones<double>();
 }
+
+
+/**
+   Read-only view on (the last axis of) a float64 or float32 array with
+   any stride; other types are converted to float64 first.
+ */
+struct Numbers
+{
+    const char *ptr;
+    ssize_t stride;
+    bool single;
+
+    static constexpr bool is_const() { return false; }
+
+    double operator[](const size_t i) const
+    {
+        const char *p = ptr + ssize_t(i) * stride;
+        return single ? double(*reinterpret_cast<const float *>(p))
+                      : *reinterpret_cast<const double *>(p);
+    }
+
+    /** Same view on another row of a 2-d array */
+    Numbers shift(const ssize_t bytes) const
+    {
+        return Numbers{ptr + bytes, stride, single};
+    }
+};
+
+
+inline Numbers
+convert(py::array &a)
+{
+    const bool single = py::isinstance<py::array_t<float>>(a);
+    if (!single && !py::isinstance<py::array_t<double>>(a))
+        a = py::array_f64::ensure(a);
+    if (!a)
+        throw py::type_error("expected an array of numbers");
+    const ssize_t stride = a.ndim() > 0 ? a.strides(a.ndim()-1) : 0;
+    return Numbers{static_cast<const char *>(a.data()), stride, single};
+}